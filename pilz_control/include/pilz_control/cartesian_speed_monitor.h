@@ -17,39 +17,51 @@
 #ifndef CARTESIAN_SPEED_MONITOR_H
 #define CARTESIAN_SPEED_MONITOR_H
 
+#include <array>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <string>
 
-#include <moveit/robot_state/robot_state.h>
+#include <Eigen/Geometry>
+
+#include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_model/joint_model.h>
 
+#include <pilz_control/kinematic_chain_evaluator.h>
+
 namespace pilz_control
 {
 /**
- * @brief Compute the cartesian speed of a single robot link.
- *
- * @param current_state Current state of the robot. The link transforms have to be up-to-date.
- * @param desired_state Desired state of the robot in the future. The link transforms have to be up-to-date.
- * @param link Robot link under observation.
- * @param time_delta Time[s] for reaching the desired state.
- * @returns Cartesian speed[m/s].
+ * @brief A point with an individual cartesian speed limit, which is monitored in addition to the link origins.
  */
-static double linkSpeed(const robot_state::RobotState* current_state,  // We require that the link transforms
-                        const robot_state::RobotState* desired_state,  // are up-to-date in this context, such
-                                                                       // that we can use the more efficient
-                                                                       // const-version getGlobalLinkTransform()
-                        const moveit::core::LinkModel* link, const double& time_delta)
+struct MonitoredPoint
 {
-  const auto p1_cart{ current_state->getGlobalLinkTransform(link) };
-  const auto p2_cart{ desired_state->getGlobalLinkTransform(link) };
-
-  const auto dist{ (p2_cart.translation() - p1_cart.translation()).norm() };
-  const auto speed{ dist / time_delta };
-
-  return speed;
-}
+  //! @brief Name of the link the point is attached to.
+  std::string link_name;
+  //! @brief Position of the point in the frame of the link.
+  Eigen::Vector3d offset{ Eigen::Vector3d::Zero() };
+  //! @brief Speed limit[m/s] of the point. The lower one of this and the global speed limit is applied.
+  double speed_limit{ std::numeric_limits<double>::infinity() };
+};
 
-//! @brief Monitors the cartesian speed of all links of a position-controlled robot (end effector is excluded).
+/**
+ * @brief Monitors the cartesian speed of all links of a position-controlled robot (end effector is excluded).
+ *
+ * The origins of all links are monitored with the speed limit given to cartesianSpeedIsBelowLimit(). Additional
+ * points (e.g. the tool tip or points on the hull of a link) can be monitored with individual speed limits. The
+ * positions of all points are stored as structure of arrays, such that all points are checked in a single
+ * (vectorizable) loop.
+ *
+ * In the typical use case the current positions of a call to cartesianSpeedIsBelowLimit() are the desired positions
+ * of the previous call. The link translations computed for the previous desired positions are therefore cached and
+ * reused, such that the forward kinematics is computed only once per call. The forward kinematics itself is
+ * computed by a KinematicChainEvaluator, which is compiled from the robot model in init().
+ *
+ * Optionally the linear joint interpolation between the current and the desired positions can be sub-sampled. The speed
+ * is then checked between all consecutive samples, which detects links exceeding the limit in the middle of the
+ * interval (e.g. due to a rotation) although the straight-line distance between the end points is short.
+ */
 class CartesianSpeedMonitor
 {
 public:
@@ -61,34 +73,66 @@ public:
   CartesianSpeedMonitor(const std::vector<std::string>& joint_names,
                         const robot_model::RobotModelConstPtr& kinematic_model);
 
-  //! @brief Prepares the CartesianSpeedMonitor for execution.
-  void init();
+  /**
+   * @brief Prepares the CartesianSpeedMonitor for execution.
+   *
+   * @param number_of_sub_samples Number of samples per call of cartesianSpeedIsBelowLimit() between the current and
+   * the desired positions (the desired positions count as sample). The default of 1 only checks the end points.
+   *
+   * @param additional_points Points monitored in addition to the link origins.
+   *
+   * @throw std::invalid_argument if number_of_sub_samples is 0 or if the speed limit of a point is not positive.
+   * @throw UnknownLinkName if an additional point is attached to a link which is not part of the robot model.
+   * @throw UnsupportedJointType if a controlled joint is neither revolute nor prismatic.
+   */
+  void init(const unsigned int& number_of_sub_samples = 1,
+            const std::vector<MonitoredPoint>& additional_points = std::vector<MonitoredPoint>());
 
   /**
-   * @brief Check if cartesian speed of all monitored links is below the speed limit.
+   * @brief Check if cartesian speed of all monitored points is below the speed limit.
    *
    * @param current_position Current positions[rad] of controlled joints in the order of \ref joint_names_.
    * @param desired_position Desired positions[rad] of controlled joints in the order of \ref joint_names_.
    * @param time_delta Time[s] for reaching the desired positions.
-   * @param speed_limit Speed limit in m/s.
+   * @param speed_limit Speed limit in m/s applied to all points. A negative value deactivates the monitoring.
    *
-   * @returns False if the speed limit is violated, otherwise true.
+   * @returns False if the speed limit of a point is violated, otherwise true.
    */
   bool cartesianSpeedIsBelowLimit(const std::vector<double>& current_position,
                                   const std::vector<double>& desired_position, const double& time_delta,
                                   const double& speed_limit);
 
+private:
+  //! @returns False if the speed limit of a point is violated between start and end, otherwise true.
+  bool pointSpeedsAreBelowLimit(const PointPositions& start, const PointPositions& end, const double& time_delta,
+                                const double& speed_limit) const;
+
+  void reportSpeedLimitViolation(const PointPositions& start, const PointPositions& end, const double& time_delta,
+                                 const double& speed_limit) const;
+
 private:
   const robot_model::RobotModelConstPtr kinematic_model_;
-  //! @brief The robot states are kept in order to allow efficient getGlobalLinkTransform calls.
-  robot_state::RobotStatePtr state_current_;
-  //! @brief The robot states are kept in order to allow efficient getGlobalLinkTransform calls.
-  robot_state::RobotStatePtr state_desired_;
+  //! @brief Computes the positions of the monitored points.
+  std::unique_ptr<KinematicChainEvaluator> kinematic_chain_;
 
   const std::vector<std::string> joint_names_;
 
   //! @brief Stores all monitored links.
   std::vector<const robot_model::LinkModel*> monitored_links_;
+
+  //! @brief Individual speed limit of each monitored point (infinity for the link origins).
+  std::vector<double> point_speed_limits_;
+  //! @brief Human readable description of each monitored point used for logging.
+  std::vector<std::string> point_descriptions_;
+
+  //! @brief Ring of monitored point positions. The slot cached_slot_ belongs to \ref cached_position_.
+  std::array<PointPositions, 2> point_positions_;
+  //! @brief Monitored point positions of the sub-samples (the last one belongs to the desired positions).
+  std::vector<PointPositions> sample_positions_;
+  std::size_t cached_slot_{ 0 };
+  //! @brief Joint positions of the last evaluation (desired positions of the previous call).
+  std::vector<double> cached_position_;
+  bool cache_valid_{ false };
 };
 
 }  // namespace pilz_control
@@ -34,6 +34,30 @@ public:
   }
 };
 
+/**
+ * @brief Throw this exception when a controlled joint has a type which is not supported by the speed monitoring.
+ */
+class UnsupportedJointType : public std::invalid_argument
+{
+public:
+  UnsupportedJointType(const std::string& joint_name)
+    : std::invalid_argument("The type of joint " + joint_name + " is not supported by the cartesian speed monitoring.")
+  {
+  }
+};
+
+/**
+ * @brief Throw this exception when a given link name does not match a link of the robot model.
+ */
+class UnknownLinkName : public std::invalid_argument
+{
+public:
+  UnknownLinkName(const std::string& link_name)
+    : std::invalid_argument("The link " + link_name + " is not part of the robot model.")
+  {
+  }
+};
+
 }  // namespace pilz_control
 
 #endif  // PILZ_CONTROL_CARTESIAN_SPEED_MONITOR_EXCEPTION_H
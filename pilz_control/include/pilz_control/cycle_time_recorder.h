@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PILZ_CONTROL_CYCLE_TIME_RECORDER_H
+#define PILZ_CONTROL_CYCLE_TIME_RECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <boost/lockfree/spsc_queue.hpp>
+
+#include <ros/time.h>
+
+#include <pilz_control/CycleTimeStatistics.h>
+
+namespace pilz_control
+{
+/**
+ * @brief Compile-time switch of the cycle time instrumentation of the controller.
+ *
+ * Set by the CMake option PILZ_CONTROL_CYCLE_TIME_INSTRUMENTATION. If false, the measurements are removed from the
+ * realtime loop as dead code.
+ */
+#ifdef PILZ_CONTROL_CYCLE_TIME_INSTRUMENTATION
+static constexpr bool CYCLE_TIME_INSTRUMENTATION_ENABLED{ true };
+#else
+static constexpr bool CYCLE_TIME_INSTRUMENTATION_ENABLED{ false };
+#endif
+
+static constexpr std::size_t DEFAULT_CYCLE_TIME_BUFFER_SIZE{ 4096 };
+
+//! @brief Default upper bounds[s] of the histogram bins.
+static const std::vector<double> DEFAULT_CYCLE_TIME_BIN_UPPER_BOUNDS{ 1e-6, 2e-6, 5e-6, 1e-5, 2e-5,
+                                                                      5e-5, 1e-4, 2e-4, 5e-4, 1e-3 };
+
+/**
+ * @brief Execution times measured in a single control cycle.
+ */
+struct CycleTimeSample
+{
+  //! @brief Uptime of the controller in this cycle.
+  ros::Time uptime;
+  double extension_duration{ 0.0 };
+  double speed_monitoring_duration{ 0.0 };
+  //! @brief Zero if no stop was triggered in this cycle.
+  double stop_duration{ 0.0 };
+};
+
+/**
+ * @brief Collects the execution times of the control cycles and accumulates them to statistics.
+ *
+ * The realtime thread only enqueues the samples into a preallocated lock-free single-producer/single-consumer queue.
+ * The accumulation into histograms, overrun counters and the worst cycle is performed by a non-realtime thread.
+ */
+class CycleTimeRecorder
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @param overrun_threshold Extension durations[s] above this threshold are counted as overrun.
+   * @param buffer_size Maximal number of samples which can be recorded between two calls of processSamples().
+   * @param bin_upper_bounds Ascending upper bounds[s] of the histogram bins.
+   */
+  explicit CycleTimeRecorder(const double& overrun_threshold,
+                             const std::size_t& buffer_size = DEFAULT_CYCLE_TIME_BUFFER_SIZE,
+                             const std::vector<double>& bin_upper_bounds = DEFAULT_CYCLE_TIME_BIN_UPPER_BOUNDS);
+
+  /**
+   * @brief Record the execution times of a cycle. Realtime-safe.
+   *
+   * @note Only a single thread (the realtime thread) is allowed to call this function.
+   * @return False if the buffer is full, in this case the sample is counted as dropped.
+   */
+  bool record(const CycleTimeSample& sample);
+
+  /**
+   * @brief Accumulate all recorded samples. Not realtime-safe.
+   *
+   * @note Only a single (non-realtime) thread is allowed to call this function and getStatistics().
+   */
+  void processSamples();
+
+  //! @brief Write the statistics of all processed samples into the given message.
+  void getStatistics(CycleTimeStatistics& statistics) const;
+
+  //! @brief Time[s] passed since the given time point.
+  static double secondsSince(const Clock::time_point& start);
+
+private:
+  void accumulate(const CycleTimeSample& sample);
+  void addToHistogram(const double& duration, std::vector<uint64_t>& histogram) const;
+
+private:
+  const double overrun_threshold_;
+  const std::vector<double> bin_upper_bounds_;
+
+  boost::lockfree::spsc_queue<CycleTimeSample> samples_;
+  std::atomic<uint64_t> dropped_cycles_{ 0 };
+
+  uint64_t cycles_{ 0 };
+  uint64_t overruns_{ 0 };
+  std::vector<uint64_t> extension_histogram_;
+  std::vector<uint64_t> speed_monitoring_histogram_;
+  std::vector<uint64_t> stop_histogram_;
+  CycleTimeSample worst_cycle_;
+};
+
+/**
+ * @brief Measures the time[s] between its construction and its destruction, if the instrumentation is enabled.
+ *
+ * Without instrumentation the measurement does nothing.
+ */
+class ScopedDurationMeasurement
+{
+public:
+  explicit ScopedDurationMeasurement(double& duration);
+  ~ScopedDurationMeasurement();
+
+private:
+  double& duration_;
+  CycleTimeRecorder::Clock::time_point start_;
+};
+
+inline double CycleTimeRecorder::secondsSince(const Clock::time_point& start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+inline ScopedDurationMeasurement::ScopedDurationMeasurement(double& duration) : duration_(duration)
+{
+  if (CYCLE_TIME_INSTRUMENTATION_ENABLED)
+  {
+    start_ = CycleTimeRecorder::Clock::now();
+  }
+}
+
+inline ScopedDurationMeasurement::~ScopedDurationMeasurement()
+{
+  if (CYCLE_TIME_INSTRUMENTATION_ENABLED)
+  {
+    duration_ = CycleTimeRecorder::secondsSince(start_);
+  }
+}
+
+}  // namespace pilz_control
+
+#endif  // PILZ_CONTROL_CYCLE_TIME_RECORDER_H
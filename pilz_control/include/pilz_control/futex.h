@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PILZ_CONTROL_FUTEX_H
+#define PILZ_CONTROL_FUTEX_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace pilz_joint_trajectory_controller
+{
+/**
+ * @brief Block until the word is woken via futexWakeAll(), unless its value already differs from the expected value.
+ *
+ * Returns early on signals and spurious wakeups, hence the caller has to re-check its condition.
+ *
+ * @throw std::system_error if the wait fails for another reason.
+ */
+void futexWait(std::atomic<uint32_t>& word, const uint32_t& expected);
+
+//! @brief Same as futexWait(), but returns after the given timeout at the latest.
+void futexWait(std::atomic<uint32_t>& word, const uint32_t& expected, const std::chrono::nanoseconds& timeout);
+
+/**
+ * @brief Wake all threads blocked in futexWait() on the word. Does neither block nor allocate memory.
+ *
+ * @throw std::system_error if the wakeup fails, which is not possible for a valid word.
+ */
+void futexWakeAll(std::atomic<uint32_t>& word);
+
+}  // namespace pilz_joint_trajectory_controller
+
+#endif  // PILZ_CONTROL_FUTEX_H
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PILZ_CONTROL_GOAL_TERMINATION_WORKER_H
+#define PILZ_CONTROL_GOAL_TERMINATION_WORKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/lockfree/spsc_queue.hpp>
+
+#include <pilz_control/futex.h>
+
+namespace pilz_joint_trajectory_controller
+{
+static constexpr std::size_t GOAL_TERMINATION_QUEUE_CAPACITY{ 16 };
+
+/**
+ * @brief Terminates (aborts or cancels) goals outside of the realtime loop.
+ *
+ * Abort requests of the realtime thread are enqueued into a lock-free single-producer/single-consumer queue, cancel
+ * requests of non-realtime threads are stored in a mutex protected container. The actual (blocking) actionlib calls
+ * are performed by a separate non-realtime thread, which sleeps on a futex until a request arrives. As a side effect
+ * the last reference to a goal handle is never released in the realtime thread.
+ *
+ * @tparam GoalHandlePtr Pointer to a realtime goal handle, see realtime_tools::RealtimeServerGoalHandle.
+ * @tparam ResultConstPtr Pointer to the result sent to the client. It is copied instead of the result itself, such
+ * that requesting an abort never allocates memory.
+ */
+template <class GoalHandlePtr, class ResultConstPtr>
+class GoalTerminationWorker
+{
+public:
+  ~GoalTerminationWorker();
+
+  //! @brief Start the worker thread. Has no effect if the worker is already running.
+  void start();
+
+  //! @brief Process all pending requests and stop the worker thread.
+  void stop();
+
+  /**
+   * @brief Request the abortion of a goal with the given result (must not be null). Realtime-safe.
+   *
+   * @note Only a single thread (the realtime thread) is allowed to call this function.
+   * @return False if the queue is full, otherwise true. The caller has to keep the goal and retry later.
+   */
+  bool requestAbort(const GoalHandlePtr& goal_handle, const ResultConstPtr& result);
+
+  /**
+   * @brief Request the cancellation of a goal with the given result (must not be null). Not realtime-safe, but can be
+   * called from any non-realtime thread.
+   *
+   * Never fails, since the number of pending cancel requests is not limited.
+   */
+  void requestCancel(const GoalHandlePtr& goal_handle, const ResultConstPtr& result);
+
+private:
+  struct Request
+  {
+    GoalHandlePtr goal_handle;
+    ResultConstPtr result;
+  };
+
+  void run();
+  void processPendingRequests();
+  //! @brief Wake the worker thread, if it waits for requests. Does not block.
+  void notify();
+
+private:
+  using RequestQueue = boost::lockfree::spsc_queue<Request, boost::lockfree::capacity<GOAL_TERMINATION_QUEUE_CAPACITY>>;
+
+  //! @brief Filled by the realtime thread.
+  RequestQueue abort_requests_;
+  //! @brief Filled by non-realtime threads, protected by cancel_requests_mutex_.
+  std::vector<Request> cancel_requests_;
+  std::mutex cancel_requests_mutex_;
+
+  //! @brief Incremented after each request, the worker thread blocks on it while no request is pending.
+  std::atomic<uint32_t> number_of_requests_{ 0 };
+  //! @brief Only if set a wakeup is needed.
+  std::atomic<bool> worker_waiting_{ false };
+  std::atomic<bool> running_{ false };
+  std::thread thread_;
+};
+
+template <class GoalHandlePtr, class ResultConstPtr>
+GoalTerminationWorker<GoalHandlePtr, ResultConstPtr>::~GoalTerminationWorker()
+{
+  stop();
+}
+
+template <class GoalHandlePtr, class ResultConstPtr>
+void GoalTerminationWorker<GoalHandlePtr, ResultConstPtr>::start()
+{
+  if (running_.exchange(true))
+  {
+    return;
+  }
+  thread_ = std::thread(&GoalTerminationWorker::run, this);
+}
+
+template <class GoalHandlePtr, class ResultConstPtr>
+void GoalTerminationWorker<GoalHandlePtr, ResultConstPtr>::stop()
+{
+  running_ = false;
+  number_of_requests_.fetch_add(1);
+  futexWakeAll(number_of_requests_);
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+  processPendingRequests();
+}
+
+template <class GoalHandlePtr, class ResultConstPtr>
+bool GoalTerminationWorker<GoalHandlePtr, ResultConstPtr>::requestAbort(const GoalHandlePtr& goal_handle,
+                                                                        const ResultConstPtr& result)
+{
+  if (!abort_requests_.push(Request{ goal_handle, result }))
+  {
+    return false;
+  }
+  notify();
+  return true;
+}
+
+template <class GoalHandlePtr, class ResultConstPtr>
+void GoalTerminationWorker<GoalHandlePtr, ResultConstPtr>::requestCancel(const GoalHandlePtr& goal_handle,
+                                                                         const ResultConstPtr& result)
+{
+  {
+    std::lock_guard<std::mutex> lk(cancel_requests_mutex_);
+    cancel_requests_.push_back(Request{ goal_handle, result });
+  }
+  notify();
+}
+
+template <class GoalHandlePtr, class ResultConstPtr>
+void GoalTerminationWorker<GoalHandlePtr, ResultConstPtr>::notify()
+{
+  // Sequentially consistent, such that either the waiting worker is seen here or the worker sees the new count
+  number_of_requests_.fetch_add(1);
+  if (worker_waiting_.load())
+  {
+    futexWakeAll(number_of_requests_);
+  }
+}
+
+template <class GoalHandlePtr, class ResultConstPtr>
+void GoalTerminationWorker<GoalHandlePtr, ResultConstPtr>::run()
+{
+  while (running_)
+  {
+    const uint32_t number_of_requests{ number_of_requests_.load() };
+    processPendingRequests();
+
+    // Registered before the count is compared by the futex, such that a concurrent request either is seen or wakes us
+    worker_waiting_.store(true);
+    if (running_)
+    {
+      futexWait(number_of_requests_, number_of_requests);
+    }
+    worker_waiting_.store(false);
+  }
+}
+
+template <class GoalHandlePtr, class ResultConstPtr>
+void GoalTerminationWorker<GoalHandlePtr, ResultConstPtr>::processPendingRequests()
+{
+  std::vector<Request> cancel_requests;
+  {
+    std::lock_guard<std::mutex> lk(cancel_requests_mutex_);
+    cancel_requests.swap(cancel_requests_);
+  }
+  for (const auto& cancel_request : cancel_requests)
+  {
+    cancel_request.goal_handle->gh_.setCanceled(*cancel_request.result, cancel_request.result->error_string);
+  }
+
+  Request abort_request;
+  while (abort_requests_.pop(abort_request))
+  {
+    abort_request.goal_handle->gh_.setAborted(*abort_request.result, abort_request.result->error_string);
+  }
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+#endif  // PILZ_CONTROL_GOAL_TERMINATION_WORKER_H
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PILZ_CONTROL_JERK_LIMITED_STOP_TRAJECTORY_BUILDER_H
+#define PILZ_CONTROL_JERK_LIMITED_STOP_TRAJECTORY_BUILDER_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <joint_trajectory_controller/trajectory_builder.h>
+
+namespace pilz_joint_trajectory_controller
+{
+//! @brief Lower bound of the stop duration[s], avoids degenerated segments if the robot is at rest.
+static constexpr double MIN_STOP_DURATION{ 1e-3 };
+
+/**
+ * @brief Get the longest duration of a stop motion of a single joint, for which its velocity does not change its sign.
+ *
+ * If the joint is braking (the acceleration opposes the velocity), the cubic velocity profile described at
+ * getMinStopDuration() crosses zero velocity for any duration above 3|v0|/|a0|, i.e. the joint would move backwards.
+ *
+ * @return Longest duration[s]. Infinite if the joint is not braking.
+ */
+inline double getMaxStopDuration(const double& velocity, const double& acceleration)
+{
+  if (velocity * acceleration < 0.0)
+  {
+    return 3.0 * std::abs(velocity / acceleration);
+  }
+  return std::numeric_limits<double>::infinity();
+}
+
+/**
+ * @brief Get the shortest duration of a stop motion of a single joint, which respects the given limits.
+ *
+ * The stop motion has a cubic velocity profile, which starts with the given velocity and acceleration and ends with
+ * zero velocity and acceleration. For this profile the max acceleration equals the acceleration limit for the duration
+ * T = 3|v0| / (a_max -+ |a0| + sqrt(a_max (a_max +- |a0|))), where the upper sign applies if the joint is accelerating
+ * and the lower sign if it is braking. The max jerk is bounded by 6|v0|/T^2 + 4|a0|/T. Both decrease with the
+ * duration T, hence the limits are also respected if the joint stops within a longer duration.
+ *
+ * The duration is capped by getMaxStopDuration(), such that a braking joint never moves backwards. A cubic profile
+ * of this duration does not exceed the initial acceleration, however it exceeds the jerk limit if the joint is too slow
+ * to reduce its acceleration to zero before reaching standstill.
+ *
+ * @param velocity Velocity at the start of the stop motion.
+ * @param acceleration Acceleration at the start of the stop motion.
+ * @param max_acceleration Acceleration limit, may be infinite.
+ * @param max_jerk Jerk limit, may be infinite.
+ *
+ * @return Shortest duration[s]. Zero if both limits are infinite.
+ */
+inline double getMinStopDuration(const double& velocity, const double& acceleration, const double& max_acceleration,
+                                 const double& max_jerk)
+{
+  const double abs_velocity{ std::abs(velocity) };
+  const double abs_acceleration{ std::abs(acceleration) };
+
+  double duration{ 0.0 };
+  if (std::isfinite(max_acceleration) && abs_velocity > 0.0)
+  {
+    // An initial acceleration beyond the limit cannot be undone, only the remaining profile is limited
+    const double signed_acceleration{ (velocity * acceleration < 0.0 ? -1.0 : 1.0) *
+                                      std::min(abs_acceleration, max_acceleration) };
+    duration = 3.0 * abs_velocity /
+               (max_acceleration - signed_acceleration +
+                std::sqrt(max_acceleration * (max_acceleration + signed_acceleration)));
+  }
+
+  if (std::isfinite(max_jerk) && (abs_velocity > 0.0 || abs_acceleration > 0.0))
+  {
+    // Positive root of max_jerk * T^2 - 4|a0| * T - 6|v0| = 0
+    const double jerk_duration{ (4.0 * abs_acceleration +
+                                 std::sqrt(16.0 * abs_acceleration * abs_acceleration +
+                                           24.0 * max_jerk * abs_velocity)) /
+                                (2.0 * max_jerk) };
+    duration = std::max(duration, jerk_duration);
+  }
+  return std::min(duration, getMaxStopDuration(velocity, acceleration));
+}
+
+/**
+ * @brief Builds a stop trajectory, which brings all joints to a standstill as fast as the joint limits allow.
+ *
+ * In contrast to joint_trajectory_controller::StopTrajectoryBuilder the duration is not fixed, but derived from the
+ * velocities and accelerations of the given state and from the acceleration and jerk limits. The stop motions of all
+ * joints are synchronized to the slowest joint. Only braking joints stop earlier, if they would otherwise move
+ * backwards (see getMaxStopDuration()). Joints without any finite limit stop within the default duration.
+ *
+ * The states needed for building are preallocated, such that buildTrajectory() can be called from the realtime
+ * thread. The computation time is linear in the number of joints.
+ *
+ * @note The limits must be set via setLimits() before building.
+ */
+template <class SegmentImpl>
+class JerkLimitedStopTrajectoryBuilder : public joint_trajectory_controller::TrajectoryBuilder<SegmentImpl>
+{
+private:
+  using Segment = joint_trajectory_controller::JointTrajectorySegment<SegmentImpl>;
+  using TrajectoryPerJoint = std::vector<Segment>;
+  using Trajectory = std::vector<TrajectoryPerJoint>;
+
+public:
+  /**
+   * @param default_stop_duration Stop duration[s] of joints without finite limits.
+   * @param start_state The state the stop motion starts from.
+   */
+  JerkLimitedStopTrajectoryBuilder(const typename Segment::Time& default_stop_duration,
+                                   const typename Segment::State& start_state);
+
+  /**
+   * @brief Set the limits applied to the next trajectory. The vectors must outlive the call of buildTrajectory().
+   *
+   * @param max_acceleration Acceleration limit of each joint, infinite if the joint has no limit.
+   * @param max_jerk Jerk limit of each joint, infinite if the joint has no limit.
+   */
+  JerkLimitedStopTrajectoryBuilder* setLimits(const std::vector<double>& max_acceleration,
+                                              const std::vector<double>& max_jerk);
+
+  bool buildTrajectory(Trajectory* stop_traj) override;
+
+  //! @brief Duration[s] of the last built stop trajectory, i.e. the duration of its slowest joint.
+  typename Segment::Time getStopDuration() const;
+
+private:
+  const typename Segment::Time default_stop_duration_;
+  const typename Segment::State& start_state_;
+  const std::vector<double>* max_acceleration_{ nullptr };
+  const std::vector<double>* max_jerk_{ nullptr };
+  typename Segment::Time stop_duration_{ 0.0 };
+
+  // Preallocated single joint states
+  typename Segment::State joint_start_state_;
+  typename Segment::State joint_end_state_;
+};
+
+template <class SegmentImpl>
+JerkLimitedStopTrajectoryBuilder<SegmentImpl>::JerkLimitedStopTrajectoryBuilder(
+    const typename Segment::Time& default_stop_duration, const typename Segment::State& start_state)
+  : default_stop_duration_(default_stop_duration)
+  , start_state_(start_state)
+  , joint_start_state_(1)
+  , joint_end_state_(1)
+{
+}
+
+template <class SegmentImpl>
+JerkLimitedStopTrajectoryBuilder<SegmentImpl>*
+JerkLimitedStopTrajectoryBuilder<SegmentImpl>::setLimits(const std::vector<double>& max_acceleration,
+                                                         const std::vector<double>& max_jerk)
+{
+  max_acceleration_ = &max_acceleration;
+  max_jerk_ = &max_jerk;
+  return this;
+}
+
+template <class SegmentImpl>
+bool JerkLimitedStopTrajectoryBuilder<SegmentImpl>::buildTrajectory(Trajectory* stop_traj)
+{
+  const std::size_t number_of_joints{ start_state_.position.size() };
+  if (!max_acceleration_ || !max_jerk_ || max_acceleration_->size() != number_of_joints ||
+      max_jerk_->size() != number_of_joints ||
+      !joint_trajectory_controller::TrajectoryBuilder<SegmentImpl>::isTrajectoryValid(
+          stop_traj, static_cast<unsigned int>(number_of_joints), 1))
+  {
+    return false;
+  }
+
+  // Synchronize all joints to the slowest one
+  typename Segment::Time duration{ MIN_STOP_DURATION };
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    const double max_acceleration{ (*max_acceleration_)[i] };
+    const double max_jerk{ (*max_jerk_)[i] };
+    const bool has_finite_limit{ std::isfinite(max_acceleration) || std::isfinite(max_jerk) };
+    duration = std::max(duration, has_finite_limit ? getMinStopDuration(start_state_.velocity[i],
+                                                                        start_state_.acceleration[i],
+                                                                        max_acceleration, max_jerk) :
+                                                     default_stop_duration_);
+  }
+  stop_duration_ = duration;
+
+  const typename Segment::Time start_time{ this->getStartTime() };
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    const double velocity{ start_state_.velocity[i] };
+    const double acceleration{ start_state_.acceleration[i] };
+    const double joint_duration{ std::max(MIN_STOP_DURATION,
+                                          std::min(duration, getMaxStopDuration(velocity, acceleration))) };
+    joint_start_state_.position[0] = start_state_.position[i];
+    joint_start_state_.velocity[0] = velocity;
+    joint_start_state_.acceleration[0] = acceleration;
+
+    // End position of the cubic velocity profile, for which the quintic spline segment degenerates
+    joint_end_state_.position[0] = start_state_.position[i] + velocity * joint_duration / 2.0 +
+                                   acceleration * joint_duration * joint_duration / 12.0;
+    joint_end_state_.velocity[0] = 0.0;
+    joint_end_state_.acceleration[0] = 0.0;
+
+    (*stop_traj)[i].front().init(start_time, joint_start_state_, start_time + joint_duration, joint_end_state_);
+  }
+  return true;
+}
+
+template <class SegmentImpl>
+typename JerkLimitedStopTrajectoryBuilder<SegmentImpl>::Segment::Time
+JerkLimitedStopTrajectoryBuilder<SegmentImpl>::getStopDuration() const
+{
+  return stop_duration_;
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+#endif  // PILZ_CONTROL_JERK_LIMITED_STOP_TRAJECTORY_BUILDER_H
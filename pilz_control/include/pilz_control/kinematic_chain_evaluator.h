@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PILZ_CONTROL_KINEMATIC_CHAIN_EVALUATOR_H
+#define PILZ_CONTROL_KINEMATIC_CHAIN_EVALUATOR_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <moveit/robot_model/robot_model.h>
+
+namespace pilz_control
+{
+/**
+ * @brief Cartesian positions of a set of points stored as structure of arrays (one array per coordinate).
+ */
+struct PointPositions
+{
+  explicit PointPositions(const std::size_t& size = 0);
+
+  void resize(const std::size_t& size);
+  std::size_t size() const;
+
+  Eigen::Vector3d getPosition(const std::size_t& index) const;
+
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> z;
+};
+
+/**
+ * @brief Computes the global positions of a fixed set of points attached to links with a minimal forward kinematics.
+ *
+ * Each point is given by a link and an offset in the frame of this link. Without offsets the points are the link
+ * origins. On construction the kinematic tree is reduced to the links needed for the requested points. All fixed
+ * joints and all joints which are not controlled are folded into constant offsets. These offsets, the joint axes and
+ * the parent relations are stored in flat arrays (one array per property). The evaluation only performs the matrix
+ * products along this reduced tree and does not need a moveit::core::RobotState.
+ *
+ * Supported types of controlled joints are revolute (including continuous) and prismatic joints. Mimic joints of
+ * controlled joints are supported as well.
+ *
+ * Several samples along a linear joint interpolation can be evaluated in one batch. In this case the frames are stored
+ * sample-major per frame component, such that all samples are processed in the innermost (vectorizable) loops.
+ */
+class KinematicChainEvaluator
+{
+public:
+  /**
+   * @param kinematic_model Robot model describing the kinematic tree.
+   * @param joint_names Names of the controlled joints. The same order has to be used for joint positions.
+   * @param links Links to which the points are attached. The same order is used for the computed positions.
+   * @param offsets Offsets of the points in the frames of the respective links. If empty, all offsets are zero.
+   *
+   * @throw RobotModelVariableNamesMismatch if a joint name does not match a variable name of the kinematic_model.
+   * @throw UnsupportedJointType if a controlled joint is neither revolute nor prismatic.
+   * @throw std::invalid_argument if offsets is neither empty nor of the same size as links.
+   */
+  KinematicChainEvaluator(const robot_model::RobotModelConstPtr& kinematic_model,
+                          const std::vector<std::string>& joint_names,
+                          const std::vector<const robot_model::LinkModel*>& links,
+                          const std::vector<Eigen::Vector3d>& offsets = std::vector<Eigen::Vector3d>());
+
+  /**
+   * @brief Compute the global positions of the points given on construction. Does not allocate memory.
+   *
+   * @param position Positions of the controlled joints in the order of the joint names given on construction.
+   * @param points Output, has to be of the same size as the number of points given on construction.
+   */
+  void computePointPositions(const std::vector<double>& position, PointPositions& points);
+
+  /**
+   * @brief Preallocate the memory needed for computeInterpolatedPointPositions().
+   *
+   * @param number_of_samples Maximal number of samples per batch.
+   */
+  void reserveSamples(const std::size_t& number_of_samples);
+
+  /**
+   * @brief Compute the global point positions along the linear interpolation between two joint positions.
+   *
+   * The k-th sample (k = 1, ..., N) is located at start + k/N * (end - start), where N denotes the size of
+   * samples. Therefore the last sample corresponds to the end position. Does not allocate memory if
+   * reserveSamples() was called with a number of samples >= N before.
+   *
+   * @param start Start positions of the controlled joints.
+   * @param end End positions of the controlled joints.
+   * @param samples Output, samples[k-1] contains the positions of all points for the k-th sample.
+   */
+  void computeInterpolatedPointPositions(const std::vector<double>& start, const std::vector<double>& end,
+                                         std::vector<PointPositions>& samples);
+
+  std::size_t getNumberOfPoints() const;
+
+private:
+  //! @brief Number of values of a frame: 3x3 rotation (row-major) followed by the translation.
+  static constexpr std::size_t FRAME_SIZE{ 12 };
+  static constexpr std::size_t AXIS_SIZE{ 3 };
+
+  enum class JointType : char
+  {
+    fixed,
+    revolute,
+    prismatic
+  };
+
+  //! @brief Compute all frames of the reduced tree.
+  void computeFrames(const std::vector<double>& position);
+
+  //! @brief Compute all frames of the reduced tree for the interpolated samples.
+  void computeBatchFrames(const std::vector<double>& start, const std::vector<double>& end,
+                          const std::size_t& number_of_samples);
+
+private:
+  // Flat arrays describing the reduced tree. Entry i belongs to frame i. Parents precede their children.
+
+  //! @brief Index of the parent frame or -1 if the frame is attached to the model frame.
+  std::vector<int> parent_;
+  //! @brief Constant transform from the parent frame to the joint frame.
+  std::vector<double> offset_;
+  std::vector<JointType> joint_type_;
+  std::vector<double> axis_;
+  //! @brief Index into the position vector or -1 for fixed joints.
+  std::vector<int> position_index_;
+  //! @brief Joint value is position_factor_ * position + position_offset_ (needed for mimic joints).
+  std::vector<double> position_factor_;
+  std::vector<double> position_offset_;
+
+  //! @brief Frame index of each requested point.
+  std::vector<std::size_t> point_frame_index_;
+  //! @brief Offset of each requested point in its frame.
+  std::vector<double> point_offset_;
+
+  //! @brief Preallocated storage of the computed frames.
+  std::vector<double> frames_;
+
+  /**
+   * @brief Preallocated storage of the frames of a batch.
+   *
+   * Component c of frame i for sample s is stored at index (i * FRAME_SIZE + c) * number_of_samples + s.
+   */
+  std::vector<double> batch_frames_;
+  //! @brief Preallocated storage of the joint values of a batch.
+  std::vector<double> batch_joint_values_;
+};
+
+inline PointPositions::PointPositions(const std::size_t& size) : x(size), y(size), z(size)
+{
+}
+
+inline void PointPositions::resize(const std::size_t& size)
+{
+  x.resize(size);
+  y.resize(size);
+  z.resize(size);
+}
+
+inline std::size_t PointPositions::size() const
+{
+  return x.size();
+}
+
+inline Eigen::Vector3d PointPositions::getPosition(const std::size_t& index) const
+{
+  return Eigen::Vector3d(x[index], y[index], z[index]);
+}
+
+inline std::size_t KinematicChainEvaluator::getNumberOfPoints() const
+{
+  return point_frame_index_.size();
+}
+
+}  // namespace pilz_control
+
+#endif  // PILZ_CONTROL_KINEMATIC_CHAIN_EVALUATOR_H
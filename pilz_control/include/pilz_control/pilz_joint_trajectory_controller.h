@@ -17,7 +17,11 @@
 #ifndef PILZ_CONTROL_PILZ_JOINT_TRAJECTORY_CONTROLLER_H
 #define PILZ_CONTROL_PILZ_JOINT_TRAJECTORY_CONTROLLER_H
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -25,33 +29,116 @@
 
 #include <std_srvs/Trigger.h>
 #include <std_srvs/SetBool.h>
+#include <trajectory_msgs/JointTrajectoryPoint.h>
 
+#include <actionlib/server/action_server.h>
+
+#include <boost/lockfree/spsc_queue.hpp>
 #include <boost/optional/optional_io.hpp>
 
 #include <joint_trajectory_controller/joint_trajectory_controller.h>
-#include <joint_trajectory_controller/stop_trajectory_builder.h>
 
 #include <moveit/robot_model_loader/robot_model_loader.h>
 
+#include <realtime_tools/realtime_publisher.h>
+
 #include <pilz_control/cartesian_speed_monitor.h>
+#include <pilz_control/cycle_time_recorder.h>
+#include <pilz_control/CycleTimeStatistics.h>
+#include <pilz_control/ExecutionState.h>
+#include <pilz_control/goal_termination_worker.h>
+#include <pilz_control/HoldAction.h>
+#include <pilz_control/jerk_limited_stop_trajectory_builder.h>
+#include <pilz_control/segment_cursor.h>
+#include <pilz_control/SpeedOverride.h>
 #include <pilz_control/traj_mode_manager.h>
+#include <pilz_control/trajectory_blending.h>
+#include <pilz_control/trajectory_pool.h>
+#include <pilz_control/triple_buffer.h>
 
 namespace pilz_joint_trajectory_controller
 {
 template <class Segment>
 using TrajectoryPerJoint = std::vector<Segment>;
 
+static constexpr std::size_t JOINT_LIMIT_VIOLATION_QUEUE_CAPACITY{ 16 };
+static constexpr std::size_t EXECUTION_STATE_QUEUE_CAPACITY{ 16 };
+//! @brief Max number of queued goals, which wait for the execution of their predecessor.
+static constexpr std::size_t GOAL_QUEUE_CAPACITY{ 8 };
+
+/**
+ * @brief Details of a violated joint limit. Passed from the realtime thread to the reporting thread.
+ */
+struct JointLimitViolation
+{
+  enum class Type
+  {
+    acceleration,
+    jerk
+  };
+
+  Type type{ Type::acceleration };
+  std::size_t joint_index{ 0 };
+  double value{ 0.0 };
+  double limit{ 0.0 };
+  //! Time[s] until the violation occurs, zero if it occurs in the current cycle. Positive for lookahead predictions.
+  double lead_time{ 0.0 };
+};
+
+/**
+ * @brief Limits checked by the controller in each cycle. Can be replaced at runtime, see reload_limits service.
+ */
+struct ControllerLimits
+{
+  //! The max allowed acceleration for each joint, infinity if the joint has no limit.
+  std::vector<double> acceleration;
+  //! The max allowed jerk for each joint, infinity if the joint has no limit.
+  std::vector<double> jerk;
+  //! The max allowed speed[m/s] for each frame on the Cartesian trajectory, applied if the monitoring is active.
+  double cartesian_speed{ 0.0 };
+};
+
+/**
+ * @brief Speed override commanded from outside, see topic speed_override.
+ */
+struct SpeedOverrideCommand
+{
+  //! Factor in [0, 1] the execution of trajectories is time-scaled with.
+  double speed_override{ 1.0 };
+  //! Limit[m/s] of the cartesian speed monitoring, ControllerLimits::cartesian_speed applies if it is lower.
+  double cartesian_speed_limit{ std::numeric_limits<double>::infinity() };
+};
+
+static constexpr std::size_t STREAMING_SETPOINT_QUEUE_CAPACITY{ 16 };
+//! @brief Max number of joints supported by the streaming interface, keeps the setpoints free of allocations.
+static constexpr std::size_t STREAMING_MAX_NUMBER_OF_JOINTS{ 16 };
+
+/**
+ * @brief Joint setpoint received on the streaming topic. Passed from the subscriber to the realtime thread.
+ */
+struct StreamingSetpoint
+{
+  //! Positions in the order of the controller joints.
+  std::array<double, STREAMING_MAX_NUMBER_OF_JOINTS> positions{};
+  //! Velocities in the order of the controller joints, zero if not given.
+  std::array<double, STREAMING_MAX_NUMBER_OF_JOINTS> velocities{};
+  //! Number of goal updates at the reception, see PilzJointTrajectoryController::goalCB().
+  uint64_t goal_update_count{ 0 };
+};
+
 /**
  * @brief Check if a trajectory is executed currently.
  *
  * @param traj Targeted trajectory.
  * @param curr_uptime Current uptime of the controller.
+ * @param cursors One cursor per joint of the trajectory. Keeps the found segments for subsequent calls.
  * @note Times that preceed the trajectory start time are ignored here, so isTrajectoryExecuted() returns false
  * even if there is a current trajectory that will be executed in the future.
  * @return True if trajectory is executed currently, otherwise false.
  */
 template <class Segment>
-static bool isTrajectoryExecuted(const std::vector<TrajectoryPerJoint<Segment>>& traj, const ros::Time& curr_uptime);
+static bool isTrajectoryExecuted(const std::vector<TrajectoryPerJoint<Segment>>& traj, const ros::Time& curr_uptime,
+                                 std::vector<SegmentCursor<Segment>>& cursors);
 
 /**
  * @class PilzJointTrajectoryController
@@ -73,15 +160,32 @@ public:
   typedef trajectory_msgs::JointTrajectory::ConstPtr JointTrajectoryConstPtr;
   typedef realtime_tools::RealtimeServerGoalHandle<control_msgs::FollowJointTrajectoryAction> RealtimeGoalHandle;
   typedef boost::shared_ptr<RealtimeGoalHandle> RealtimeGoalHandlePtr;
+  typedef control_msgs::FollowJointTrajectoryResultConstPtr ResultConstPtr;
   typedef joint_trajectory_controller::JointTrajectorySegment<SegmentImpl> Segment;
   typedef std::vector<Segment> TrajectoryPerJoint;
   typedef std::vector<TrajectoryPerJoint> Trajectory;
   typedef std::shared_ptr<Trajectory> TrajectoryPtr;
+  typedef typename JointTrajectoryController::GoalHandle GoalHandle;
+  typedef actionlib::ActionServer<pilz_control::HoldAction> HoldActionServer;
+  typedef HoldActionServer::GoalHandle HoldGoalHandle;
 
   PilzJointTrajectoryController();
 
   bool init(HardwareInterface* hw, ros::NodeHandle& root_nh, ros::NodeHandle& controller_nh) override;
 
+  /**
+   * @brief Perform the update of the JointTrajectoryController with the trajectory time scaled by the speed override.
+   *
+   * The speed override only applies while no stop motion is performed. Changes of the speed override are slewed,
+   * such that the joint acceleration limits are respected.
+   */
+  void update(const ros::Time& time, const ros::Duration& period) override;
+
+  /**
+   * @brief Stop the JointTrajectoryController and record that no trajectory is executed anymore.
+   */
+  void stopping(const ros::Time& time) override;
+
   /**
    * @brief Returns true if the controller currently is executing a trajectory. False otherwise.
    */
@@ -90,6 +194,10 @@ public:
   /**
    * @brief Service callback to force the controller into the hold position.
    *
+   * Blocks until the stop motion is finished, but at most for the time given by the parameter hold/timeout. Fails if
+   * the deadline passes or the controller is stopped before the stop motion is finished. See the action hold_action
+   * for a non-blocking alternative.
+   *
    * @param request Dummy for triggering the service
    * @param response True on success.
    *
@@ -127,6 +235,45 @@ public:
    */
   bool handleMonitorCartesianSpeedRequest(std_srvs::SetBool::Request& request, std_srvs::SetBool::Response& response);
 
+  /**
+   * @brief Service callback for reloading the joint and cartesian limits from the parameter server.
+   *
+   * The limits are validated before they are handed over to the realtime thread. Invalid limits are rejected and the
+   * previous limits stay active.
+   *
+   * @param request Dummy for triggering the service
+   * @param response success: True if the new limits are active. message: The reason in case of failure.
+   *
+   * @return Always true.
+   */
+  bool handleReloadLimitsRequest(std_srvs::TriggerRequest& request, std_srvs::TriggerResponse& response);
+
+  /**
+   * @brief Hand a joint setpoint over to the realtime thread, which moves the robot towards it. Not realtime-safe.
+   *
+   * Only a single thread is allowed to call this function.
+   *
+   * @param positions Joint positions in the order of the controller joints.
+   * @param velocities Joint velocities at the setpoint. Empty if the robot shall reach the setpoint at rest.
+   * @param error_string The reason in case of failure.
+   *
+   * @return False if the streaming interface is disabled, a goal is executed, the controller is not in unhold mode
+   * or the setpoint is invalid.
+   */
+  bool setStreamingSetpoint(const std::vector<double>& positions, const std::vector<double>& velocities,
+                            std::string* error_string = nullptr);
+
+  /**
+   * @brief Set the speed override, which is applied from the next update on. Not realtime-safe.
+   *
+   * @param speed_override Factor in [0, 1] the execution of trajectories is time-scaled with.
+   * @param cartesian_speed_limit Limit[m/s] of the cartesian speed monitoring, the configured limit applies if it is
+   * lower.
+   *
+   * @return False if a value is out of range, the previous speed override stays active in this case.
+   */
+  bool setSpeedOverride(const double& speed_override, const double& cartesian_speed_limit);
+
   /**
    * @brief Helper function to get paramter names to read
    *
@@ -154,6 +301,52 @@ public:
   static std::vector<boost::optional<double>> getJointAccelerationLimits(const ros::NodeHandle& nh,
                                                                          const std::vector<std::string>& joint_names);
 
+  /**
+   * @brief Get the Joint Jerk Limits for each joint from the parameter server.
+   *
+   * In contrast to the acceleration limits, the jerk limits are optional. A joint has no jerk limit if
+   * has_jerk_limits is missing or set to false.
+   *
+   * Function assumes parameter server naming prefix '/joint_limits/' for Joint Names.
+   *
+   * @param nh NodeHandle to access parameter server.
+   * @param joint_names Vector of Strings for all joint names to get the jerk limits for.
+   * @return std::vector<boost::optional<double>> Requested jerk limits as vector. Has the same length as param
+   * 'joint_names'.
+   *
+   * @throw InvalidParameterException has_jerk_limits is true, but max_jerk is not found on param server.
+   */
+  static std::vector<boost::optional<double>> getJointJerkLimits(const ros::NodeHandle& nh,
+                                                                 const std::vector<std::string>& joint_names);
+
+  /**
+   * @brief Get the points monitored by the cartesian speed monitoring in addition to the link origins.
+   *
+   * Each entry of the list under 'cartesian_speed_monitoring/monitored_points' has to contain the name of a 'link'.
+   * Optionally an 'offset' [x, y, z] in the link frame (default: link origin) and an individual 'speed_limit' can be
+   * given.
+   *
+   * @param nh NodeHandle to access parameter server.
+   * @return The monitored points. Empty if the parameter does not exist.
+   *
+   * @throw InvalidParameterException The parameter is malformed.
+   */
+  static std::vector<pilz_control::MonitoredPoint> getMonitoredPoints(const ros::NodeHandle& nh);
+
+  /**
+   * @brief Get all limits which are checked by the controller from the parameter server and validate them.
+   *
+   * The joint limits are read from the 'limits' namespace, see getJointAccelerationLimits() and getJointJerkLimits().
+   * The cartesian speed limit is read from 'cartesian_speed_monitoring/speed_limit' (default: 0.25m/s). It must not
+   * exceed 0.25m/s, which is required for operation mode T1.
+   *
+   * @param nh NodeHandle of the controller to access parameter server.
+   * @param joint_names Names of all joints of the controller.
+   *
+   * @throw InvalidParameterException Requested values not found on param server or invalid.
+   */
+  static ControllerLimits getLimits(const ros::NodeHandle& nh, const std::vector<std::string>& joint_names);
+
 protected:
   /**
    * @brief Called if new trajectory should be handled
@@ -165,7 +358,11 @@ protected:
                                std::string* error_string = 0) override;
 
   /**
-   * @brief Hands received JointTrajectory to parent class, normal handling of trajectory
+   * @brief Normal handling of trajectory, equals the handling of the parent class.
+   *
+   * Commands which do not create a new trajectory (controller not running, null-pointer or empty trajectory) are
+   * passed to the parent class. Otherwise the new trajectory is moved into the trajectory pool before it is handed
+   * over, which the parent class does not allow.
    */
   bool updateStrategyDefault(const JointTrajectoryConstPtr&, RealtimeGoalHandlePtr, std::string* error_string = 0);
 
@@ -174,15 +371,43 @@ protected:
    */
   bool updateStrategyWhileHolding(const JointTrajectoryConstPtr&, RealtimeGoalHandlePtr, std::string* error_string = 0);
 
+  /**
+   * @brief Request a stop motion, which is as fast as the limits allow.
+   *
+   * The stop trajectory is built by the realtime thread in its next update from its own desired state, hence neither
+   * the state nor the executed trajectory are accessed concurrently.
+   */
   void triggerMovementToHoldPosition();
 
   void trajectoryCommandCB(const JointTrajectoryConstPtr& msg) override;
 
+  /**
+   * @brief Queue the goal behind the active goal, if the goal queue is enabled. Otherwise replace the active goal.
+   *
+   * The trajectory of a queued goal is appended to the current trajectory (blended if a blend radius is configured),
+   * such that the robot does not stop in between. Goals received while no goal is active are handled as usual.
+   *
+   * Streaming setpoints received before or while the goal is handled are discarded, they must not replace the
+   * trajectory of the goal.
+   */
+  void goalCB(GoalHandle gh) override;
+
+  /**
+   * @brief Cancel the goal and stop the robot, see triggerMovementToHoldPosition().
+   *
+   * Since queued goals build on each other, cancelling the active or a queued goal cancels all queued goals.
+   */
+  void cancelCB(GoalHandle gh) override;
+
 private:
+  //! @brief Measures the execution times of the checks, see test/benchmark_pilz_joint_trajectory_controller.cpp.
+  friend class ControllerCheckProbe;
+
   /**
    * @brief Invoke cartesian speed monitoring and perform controlled stop in case of speed limit violation.
    *
-   * The actual procedure depends on the current mode.
+   * A stop motion requested via triggerMovementToHoldPosition() is started in any mode. Otherwise the actual
+   * procedure depends on the current mode.
    * - unhold: check the (desired) velocity and trigger controller stop in case of speed limit violation.
    * - stopping: check if the stop trajectory execution is complete. If yes, trigger hold.
    * - hold: nothing to do.
@@ -203,11 +428,11 @@ private:
   bool isPlannedUpdateOK(const ros::Duration& period) const;
 
   /**
-   * @brief Check acceleration limit. Ensure that trajectories are smooth enough.
+   * @brief Check acceleration and jerk limits. Ensure that trajectories are smooth enough.
    *
    * @param period The time passed since the last update.
    *
-   * @returns False if one or more joints violate the acceleration limit, otherwise true.
+   * @returns False if one or more joints violate the acceleration or the jerk limit, otherwise true.
    */
   bool isPlannedJointAccelerationOK(const ros::Duration& period) const;
 
@@ -220,6 +445,148 @@ private:
    */
   bool isPlannedCartesianVelocityOK(const ros::Duration& period) const;
 
+  /**
+   * @brief Check the acceleration and cartesian speed limits along the trajectory within the lookahead horizon.
+   *
+   * The trajectory is sampled at equidistant time points after the current uptime, the limits are checked between
+   * consecutive samples. This allows to stop the motion before the desired state actually violates a limit.
+   * Does not allocate memory. A predicted violation is enqueued for reporting by reportJointLimitViolations().
+   *
+   * @param curr_traj Currently executed trajectory.
+   * @param uptime Current uptime of the controller.
+   *
+   * @returns False if a limit is violated within the horizon, otherwise true. Always true if the lookahead is disabled.
+   */
+  bool isLookaheadOK(const typename JointTrajectoryController::Trajectory& curr_traj, const ros::Time& uptime);
+
+  /**
+   * @brief Perform the mode dependent actions of the extension point, see updateFuncExtensionPoint().
+   */
+  void processCurrentMode(const typename JointTrajectoryController::Trajectory& curr_traj,
+                          const typename JointTrajectoryController::TimeData& time_data);
+
+  /**
+   * @brief Create the recorder and the publisher of the cycle time statistics.
+   *
+   * Only called if the controller is built with cycle time instrumentation.
+   */
+  void initCycleTimeStatistics(ros::NodeHandle& controller_nh);
+
+  //! @brief Accumulate the recorded cycle times and publish the statistics. Called by a non-realtime timer.
+  void publishCycleTimeStatistics(const ros::WallTimerEvent&);
+
+  /**
+   * @brief Enqueue the execution state for publication if it changed since the last cycle. Realtime-safe.
+   *
+   * If the queue is full, the change is enqueued in one of the next cycles.
+   *
+   * @param time Time of the current cycle.
+   * @param running False if the controller is stopped.
+   */
+  void recordExecutionState(const ros::Time& time, bool running);
+
+  /**
+   * @brief Publish all execution states enqueued by the realtime thread. Called by a non-realtime timer.
+   *
+   * The goal id is determined here, since it cannot be accessed in realtime.
+   */
+  void publishExecutionStates(const ros::WallTimerEvent&);
+
+  /**
+   * @brief Check the acceleration limits between two velocities and the jerk limits between two accelerations.
+   *
+   * All joints are checked in a single branch-free pass, which can be vectorized by the compiler. Only in case of a
+   * violation the details are enqueued for reporting by reportJointLimitViolations(). Realtime-safe.
+   *
+   * @param old_velocity Joint velocities at the beginning of the period.
+   * @param new_velocity Joint velocities at the end of the period.
+   * @param old_acceleration Joint accelerations at the beginning of the period.
+   * @param new_acceleration Joint accelerations at the end of the period.
+   * @param period The time between both states.
+   * @param lead_time Time[s] until the end of the period is reached. Zero for the desired states of the current cycle,
+   * positive for states predicted by the lookahead.
+   *
+   * @returns False if one or more joints violate the acceleration or the jerk limit, otherwise true.
+   */
+  bool areJointLimitsOK(const std::vector<double>& old_velocity, const std::vector<double>& new_velocity,
+                        const std::vector<double>& old_acceleration, const std::vector<double>& new_acceleration,
+                        const ros::Duration& period, const double& lead_time = 0.0) const;
+
+  //! @brief Subscriber callback of the speed override topic.
+  void speedOverrideCB(const pilz_control::SpeedOverrideConstPtr& msg);
+
+  //! @brief Subscriber callback of the streaming topic.
+  void streamingSetpointCB(const trajectory_msgs::JointTrajectoryPointConstPtr& msg);
+
+  /**
+   * @brief Replace the current trajectory by a motion towards the latest streaming setpoint. Realtime-safe.
+   *
+   * The robot reaches the setpoint within the setpoint period and subsequently comes to rest within the shortest
+   * time the joint limits allow, unless a new setpoint arrives in time. The motion starts from the state of the current
+   * trajectory at the last uptime, hence it is continuous in position, velocity and acceleration.
+   */
+  void processStreamingSetpoints();
+
+  /**
+   * @brief Move the speed scaling towards the commanded speed override, limited by the max rate of change.
+   *
+   * If the trajectory is at rest, the speed scaling is set to the speed override directly.
+   *
+   * @param period The time passed since the last update.
+   */
+  void slewSpeedScaling(const ros::Duration& period);
+
+  //! @brief True if the desired velocities and accelerations are zero. Expects the desired state in trajectory time.
+  bool isDesiredStateAtRest() const;
+
+  /**
+   * @brief Determine the max rate of change of the speed scaling for the next cycle.
+   *
+   * A change of the speed scaling adds the trajectory velocity times the rate of change to the joint acceleration.
+   * The rate is limited such that this fits into the remaining share of the acceleration limit of each joint.
+   *
+   * @note Must be called before scaleDesiredState(), since the desired state is expected in trajectory time.
+   */
+  double getMaxSpeedScalingRate() const;
+
+  /**
+   * @brief Convert the desired velocities and accelerations from trajectory time into real time.
+   *
+   * Needed since the trajectory is sampled at the scaled uptime. Realtime-safe.
+   */
+  void scaleDesiredState();
+
+  /**
+   * @brief Abort the active goal, if the velocity of a joint violates its path tolerance. Realtime-safe.
+   *
+   * The parent class checks the path tolerances before the desired state is scaled, hence the velocity path tolerances
+   * are taken from the segments, see takeVelocityPathTolerances(), and checked after scaleDesiredState() instead.
+   *
+   * @param curr_traj Currently executed trajectory.
+   * @param uptime Current uptime of the controller.
+   */
+  void checkVelocityPathTolerances(const typename JointTrajectoryController::Trajectory& curr_traj,
+                                   const ros::Time& uptime);
+
+  /**
+   * @brief Remove the velocity path tolerances from the segments of the goal, before the trajectory is published.
+   *
+   * @returns The removed tolerance[rad/s] of each joint, zero if the velocity is not checked.
+   */
+  static std::vector<double> takeVelocityPathTolerances(Trajectory& traj, const RealtimeGoalHandlePtr& gh);
+
+  //! @brief Hand the velocity path tolerances over to the realtime thread. Must be called with goal_queue_mutex_ held.
+  void publishVelocityPathTolerances();
+
+  //! @brief Speed limit passed to the cartesian speed monitors, negative if the monitoring is deactivated.
+  double getCartesianSpeedLimit() const;
+
+  /**
+   * @brief Log the joint limit violations and the stops of the lookahead detected by the realtime thread. Called by a
+   * non-realtime timer.
+   */
+  void reportJointLimitViolations(const ros::WallTimerEvent&);
+
   /**
    * @brief Cancel the currently active goal and trigger a controller stop.
    *
@@ -228,36 +595,279 @@ private:
   void stopMotion(const ros::Time& curr_uptime);
 
   /**
-   * TODO: We should rather only trigger the cancelling of the active goal. The actual execution should be moved to a
-   * separate thread. See realtime_tools::RealtimeServerGoalHandle and
-   * https://github.com/ros-controls/ros_controllers/issues/174.
+   * @brief Build a stop trajectory from the last desired state and execute it. Realtime-safe.
+   *
+   * @param curr_uptime Current uptime of controller.
+   */
+  void startStopMotion(const ros::Time& curr_uptime);
+
+  /**
+   * @brief Release the active goal and trigger its cancelling with the given result.
+   *
+   * The actual cancelling is performed by the goal_termination_worker_. Must not be called from the realtime thread
+   * and not while holding active_goal_mutex_.
    */
-  void cancelActiveGoal();
+  void cancelActiveGoal(const ResultConstPtr& result);
 
   /**
-   * TODO: We should rather only trigger the aborting of the active goal. The actual execution should be moved to a
-   * separate thread. See realtime_tools::RealtimeServerGoalHandle and
-   * https://github.com/ros-controls/ros_controllers/issues/174.
+   * @brief Release the active goal and trigger its aborting due to a limit violation. Realtime-safe.
+   *
+   * The actual aborting is performed by the goal_termination_worker_, see
+   * https://github.com/ros-controls/ros_controllers/issues/174. If its queue is full, the goal stays active and the
+   * request is retried in the next cycles.
    */
   void abortActiveGoal();
 
+  /**
+   * @brief Append the trajectory of the goal to the current trajectory and add the goal to the queue.
+   *
+   * The combined trajectory is computed in the calling (non-realtime) thread and handed over to the realtime thread,
+   * see mergeTrajectory(). The goal is only accepted if the realtime thread installs the combined trajectory. Must be
+   * called without active_goal_mutex_ and goal_queue_mutex_ held.
+   *
+   * @param gh The goal to queue.
+   * @param curr_traj_ptr The current trajectory.
+   * @param error_string The reason in case of failure.
+   *
+   * @return False if the goal is rejected, otherwise true.
+   */
+  bool queueGoal(GoalHandle gh, const TrajectoryPtr& curr_traj_ptr, std::string* error_string);
+
+  //! @brief Queue the goal or replace the active goal, see goalCB().
+  void handleGoal(GoalHandle gh);
+
+  /**
+   * @brief Hand a combined trajectory over to the realtime thread and wait for its decision. Not realtime-safe.
+   *
+   * The realtime thread only installs the combined trajectory if the base trajectory is still executed, i.e. no stop
+   * motion was triggered meanwhile, and the uptime did not pass the given time yet. See
+   * processTrajectoryMergeRequest(). The realtime thread wakes the caller right after its decision, the request is
+   * only withdrawn if the controller does not run or does not decide within TRAJECTORY_MERGE_TIMEOUT.
+   *
+   * @param base_traj_ptr The trajectory the combined trajectory was built from.
+   * @param merged_traj_ptr The combined trajectory, which equals the base trajectory up to the given time.
+   * @param latest_install_time Latest uptime[s] at which the combined trajectory can replace the base trajectory.
+   *
+   * @return True if the realtime thread installed the combined trajectory, otherwise false.
+   */
+  bool mergeTrajectory(const TrajectoryPtr& base_traj_ptr, const TrajectoryPtr& merged_traj_ptr,
+                       const double& latest_install_time);
+
+  /**
+   * @brief Install or reject a pending combined trajectory, see mergeTrajectory(). Realtime-safe.
+   *
+   * @param curr_traj Currently executed trajectory. The request is rejected if it is a nullptr.
+   * @param uptime Current uptime of the controller.
+   */
+  void processTrajectoryMergeRequest(const typename JointTrajectoryController::Trajectory* curr_traj,
+                                     const ros::Time& uptime);
+
+  /**
+   * @brief Detect the start of the trajectory of a queued goal. Realtime-safe.
+   *
+   * A queued goal starts, if the goal of the current segment changes and the segments of the previous goal precede
+   * the current segment. The preceding goals are finished at this point. They succeed if the state error is within
+   * the goal tolerances of the predecessor, otherwise they are aborted. The queued goal is made the active goal outside
+   * of the realtime thread, see activateExecutedGoal().
+   *
+   * @param curr_traj Currently executed trajectory.
+   * @param uptime Current uptime of the controller.
+   */
+  void updateQueuedGoals(const typename JointTrajectoryController::Trajectory& curr_traj, const ros::Time& uptime);
+
+  /**
+   * @brief Check the state error against the goal tolerances of the segments preceding the current segments.
+   *
+   * @param curr_traj Currently executed trajectory.
+   * @param uptime Current uptime of the controller.
+   *
+   * @returns False if a joint violates its goal tolerance, otherwise true.
+   */
+  bool isStateWithinGoalTolerance(const typename JointTrajectoryController::Trajectory& curr_traj,
+                                  const ros::Time& uptime);
+
+  /**
+   * @brief Make the queued goal, whose trajectory the realtime thread started, the active goal.
+   *
+   * The preceding goals, which were finished by the realtime thread, are moved to finished_goals_. Must be called with
+   * active_goal_mutex_ held.
+   */
+  void activateExecutedGoal();
+
+  /**
+   * @brief Cancel all queued goals, which are not yet active, with the given result. Must not be called from the
+   * realtime thread.
+   */
+  void cancelQueuedGoals(const ResultConstPtr& result);
+
+  /**
+   * @brief Activate the executed queued goal and forward the results of the finished goals to actionlib.
+   *
+   * The queued goals are aborted, if no goal is active anymore (e.g. due to a stop motion), since their trajectories
+   * cannot be reached anymore. Called by a non-realtime timer, since queued goals start within the realtime thread.
+   */
+  void runQueuedGoalsNonRealtime(const ros::TimerEvent& event);
+
+  //! @brief Switch to stopping and trigger the stop motion, if not yet done. Shared by the hold service and action.
+  void requestHold(HoldModeListener* const listener);
+
+  //! @brief Accept a goal of the hold action and trigger the stop motion. Does not wait for its end.
+  void holdGoalCB(HoldGoalHandle gh);
+
+  //! @brief Cancel waiting for the hold mode. The stop motion is not affected.
+  void holdCancelCB(HoldGoalHandle gh);
+
+  /**
+   * @brief Terminate the goals of the hold action, once the hold mode is reached, their deadline passed or the
+   * controller was stopped. Publishes the remaining stop time as feedback otherwise.
+   *
+   * Called by a non-realtime timer, hence any number of goals can wait without blocking a callback.
+   */
+  void monitorHoldGoals(const ros::WallTimerEvent& event);
+
+  //! @brief Time[s] until the currently executed (stop) trajectory ends.
+  double getRemainingStopTime();
+
+private:
+  //! @brief Progress of a combined trajectory handed over to the realtime thread, see mergeTrajectory().
+  enum class TrajectoryMergeState : uint32_t
+  {
+    idle,
+    pending,
+    processing,
+    installed,
+    rejected
+  };
+
+  /**
+   * @brief Combined trajectory of the current trajectory and a queued goal, see mergeTrajectory().
+   */
+  struct TrajectoryMergeRequest
+  {
+    TrajectoryPtr base_trajectory;
+    TrajectoryPtr merged_trajectory;
+    double latest_install_time{ 0.0 };
+  };
+
+  /**
+   * @brief Execution state detected by the realtime thread, see recordExecutionState().
+   */
+  struct ExecutionStateChange
+  {
+    ros::Time stamp;
+    bool executing{ false };
+    uint8_t mode{ pilz_control::ExecutionState::UNHOLD };
+    //! Active goal, released outside of the realtime thread by publishExecutionStates().
+    RealtimeGoalHandlePtr goal;
+  };
+
+  /**
+   * @brief Velocity path tolerances of a goal, see checkVelocityPathTolerances().
+   */
+  struct VelocityPathTolerances
+  {
+    //! Goal of the segments, never dereferenced.
+    const RealtimeGoalHandle* goal{ nullptr };
+    //! Tolerance[rad/s] of each joint, zero if the velocity is not checked.
+    std::vector<double> velocity;
+  };
+
+  /**
+   * @brief Goal of the hold action, which waits for the hold mode.
+   */
+  struct PendingHoldGoal
+  {
+    HoldGoalHandle goal_handle;
+    std::shared_ptr<HoldModeListener> listener;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
 private:
   ros::ServiceServer hold_position_service;
   ros::ServiceServer unhold_position_service;
   ros::ServiceServer is_executing_service_;
   ros::ServiceServer monitor_cartesian_speed_service_;
+  ros::ServiceServer reload_limits_service_;
+  //! @brief Needed for reading the limits from the parameter server on reload.
+  ros::NodeHandle controller_nh_;
 
   //! @brief Manages the different modes of the controller (stopping, hold, unhold).
   std::unique_ptr<TrajProcessingModeManager> mode_{ std::unique_ptr<TrajProcessingModeManager>(
       new TrajProcessingModeManager()) };
 
+  //! @brief Results of the goals terminated by the controller, preallocated for the realtime thread.
+  const ResultConstPtr limit_violation_result_;
+  const ResultConstPtr predecessor_aborted_result_;
+  const ResultConstPtr hold_result_;
+  const ResultConstPtr client_cancel_result_;
+  const ResultConstPtr replaced_result_;
+  const ResultConstPtr path_tolerance_result_;
+
+  //! @brief Performs the (blocking) goal terminations requested by the realtime thread in a separate thread.
+  GoalTerminationWorker<RealtimeGoalHandlePtr, ResultConstPtr> goal_termination_worker_;
+  /**
+   * @brief Active goal whose abort request did not fit into the queue of the goal_termination_worker_, see
+   * abortActiveGoal(). Only used by the realtime thread.
+   */
+  const RealtimeGoalHandle* rt_goal_to_abort_{ nullptr };
+
   std::unique_ptr<pilz_control::CartesianSpeedMonitor> cartesian_speed_monitor_;
-  std::unique_ptr<joint_trajectory_controller::StopTrajectoryBuilder<SegmentImpl>> stop_traj_builder_;
+
+  //! @brief Time[s] the trajectory is checked in advance.
+  double lookahead_horizon_{ 0.0 };
+  //! @brief Separate monitor for the lookahead, since the monitors cache the positions of the previous call.
+  std::unique_ptr<pilz_control::CartesianSpeedMonitor> lookahead_speed_monitor_;
+  /**
+   * @brief Preallocated joint positions of the lookahead samples. The first sample is the desired state.
+   *
+   * Empty if the lookahead is disabled.
+   */
+  std::vector<std::vector<double>> lookahead_positions_;
+  //! @brief Preallocated joint velocities of the lookahead samples. The first sample is the desired state.
+  std::vector<std::vector<double>> lookahead_velocities_;
+  //! @brief Preallocated joint accelerations of the lookahead samples. The first sample is the desired state.
+  std::vector<std::vector<double>> lookahead_accelerations_;
+  typename Segment::State lookahead_segment_state_;
+  //! @brief One cursor per joint for the sampling of the lookahead.
+  std::vector<SegmentCursor<Segment>> lookahead_segment_cursors_;
+
+  //! @brief One cursor per joint for detecting the execution of the trajectory. Only used by the realtime thread.
+  std::vector<SegmentCursor<Segment>> rt_segment_cursors_;
+  //! @brief One cursor per joint for is_executing(), protected by is_executing_mutex_.
+  std::vector<SegmentCursor<Segment>> is_executing_segment_cursors_;
+  std::mutex is_executing_mutex_;
+
+  //! @brief Result of the execution check in the last update. Written by the realtime thread.
+  std::atomic<bool> rt_executing_{ false };
+  ros::Publisher execution_state_publisher_;
+  ros::WallTimer execution_state_timer_;
+  //! @brief Last published execution state. Only accessed by the timer callback.
+  pilz_control::ExecutionState execution_state_;
+  //! @brief Filled by the realtime thread on each change of the execution state, see recordExecutionState().
+  boost::lockfree::spsc_queue<ExecutionStateChange, boost::lockfree::capacity<EXECUTION_STATE_QUEUE_CAPACITY>>
+      execution_state_changes_;
+  /**
+   * @brief Last enqueued execution state. Only used by the realtime thread.
+   *
+   * The goal is identified by its address together with the goal update count, such that the realtime thread does not
+   * hold a reference and a new goal is detected even if it reuses the memory of a released goal.
+   */
+  bool rt_recorded_executing_{ false };
+  uint8_t rt_recorded_mode_{ pilz_control::ExecutionState::UNHOLD };
+  const RealtimeGoalHandle* rt_recorded_goal_{ nullptr };
+  uint64_t rt_recorded_goal_update_count_{ 0 };
+
+  //! @brief Builds the stop trajectory from the last desired state. Only used by the realtime thread.
+  std::unique_ptr<JerkLimitedStopTrajectoryBuilder<SegmentImpl>> stop_traj_builder_;
   /**
-   * @brief Stores the stop trajectory which is used in case the newly calculated desired value violates the
-   * Cartesian path velocity restraint.
+   * @brief Buffers of the stop trajectories, e.g. in case the newly calculated desired value violates the Cartesian
+   * path velocity restraint or on a hold request. They are used alternately, such that a stop trajectory is never
+   * rebuilt while it is executed. Only used by the realtime thread.
    */
-  TrajectoryPtr stop_traj_velocity_violation_;
+  std::array<TrajectoryPtr, 2> stop_trajectories_;
+  std::size_t rt_stop_trajectory_index_{ 0 };
+  //! @brief Set by triggerMovementToHoldPosition(), reset by the realtime thread when it starts the stop motion.
+  std::atomic<bool> stop_requested_{ false };
 
   /**
    * @brief Synchronizes hold/unhold and update trajectory function to avoid
@@ -265,11 +875,41 @@ private:
    */
   std::mutex sync_mutex_;
 
-  //! The currently max allowed speed for each frame on the Cartesian trajectory.
-  std::atomic<double> cartesian_speed_limit_{ 0.0 };
-
-  //! The max allowed acceleration for each joint.
-  std::vector<boost::optional<double>> acceleration_joint_limits_;
+  //! @brief True if the cartesian speed is monitored.
+  std::atomic<bool> cartesian_speed_monitoring_active_{ true };
+
+  //! @brief Passes reloaded limits to the realtime thread, which reads them wait-free.
+  pilz_control::TripleBuffer<ControllerLimits> limits_buffer_;
+  //! @brief Limits applied in the current cycle. Only used by the realtime thread.
+  const ControllerLimits* rt_limits_{ nullptr };
+  //! @brief Copy of the current limits for non-realtime threads, protected by limits_mutex_.
+  ControllerLimits limits_;
+  std::mutex limits_mutex_;
+
+  ros::Subscriber speed_override_subscriber_;
+  //! @brief Passes the commanded speed override to the realtime thread, which reads it wait-free.
+  pilz_control::TripleBuffer<SpeedOverrideCommand> speed_override_buffer_;
+  //! @brief Speed override applied in the current cycle. Only used by the realtime thread.
+  const SpeedOverrideCommand* rt_speed_override_{ nullptr };
+  //! @brief Factor the trajectory time is scaled with in the current cycle. Only used by the realtime thread.
+  double rt_speed_scaling_{ 1.0 };
+  //! @brief Rate of change[1/s] of the speed scaling in the current cycle. Only used by the realtime thread.
+  double rt_speed_scaling_rate_{ 0.0 };
+  //! @brief Max rate of change[1/s] of the speed scaling in the next cycle. Only used by the realtime thread.
+  double rt_max_speed_scaling_rate_{ 0.0 };
+  //! @brief True if the desired state of the last cycle was at rest. Only used by the realtime thread.
+  bool rt_trajectory_at_rest_{ true };
+  //! @brief Configured upper bound of the rate of change[1/s] of the speed scaling.
+  double speed_override_max_rate_{ 0.0 };
+
+  //! @brief Filled by the realtime thread in case of a joint limit violation.
+  mutable boost::lockfree::spsc_queue<JointLimitViolation,
+                                      boost::lockfree::capacity<JOINT_LIMIT_VIOLATION_QUEUE_CAPACITY>>
+      joint_limit_violations_;
+  //! @brief Filled by the realtime thread with the time[s] until the violation, if the lookahead stops the motion.
+  boost::lockfree::spsc_queue<double, boost::lockfree::capacity<JOINT_LIMIT_VIOLATION_QUEUE_CAPACITY>>
+      lookahead_stops_;
+  ros::WallTimer joint_limit_violation_timer_;
 
   /**
    * @brief Used for loading a RobotModel for the CartesianSpeedMonitor.
@@ -279,6 +919,92 @@ private:
    * the member cartesian_speed_monitor_, the loader has to be stored as well.
    */
   robot_model_loader::RobotModelLoaderConstPtr robot_model_loader_;
+
+  //! @brief Collects the cycle times. Only exists if the controller is built with cycle time instrumentation.
+  std::unique_ptr<pilz_control::CycleTimeRecorder> cycle_time_recorder_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<pilz_control::CycleTimeStatistics>> cycle_time_publisher_;
+  ros::WallTimer cycle_time_timer_;
+
+  //! @brief True if joint setpoints are accepted on the streaming topic.
+  bool streaming_enabled_{ false };
+  //! @brief Time[s] within which the robot moves to a streaming setpoint.
+  double streaming_setpoint_period_{ 0.0 };
+  ros::Subscriber streaming_setpoint_subscriber_;
+  //! @brief Filled by setStreamingSetpoint(), consumed by the realtime thread.
+  boost::lockfree::spsc_queue<StreamingSetpoint, boost::lockfree::capacity<STREAMING_SETPOINT_QUEUE_CAPACITY>>
+      streaming_setpoints_;
+  //! @brief Latest streaming setpoint. Only used by the realtime thread.
+  StreamingSetpoint rt_streaming_setpoint_;
+  //! @brief True if the latest streaming setpoint was not yet processed. Only used by the realtime thread.
+  bool rt_streaming_setpoint_pending_{ false };
+  /**
+   * @brief Incremented before and after goalCB() handles a goal, i.e. odd while a goal is handled. A streaming
+   * setpoint is only executed if the count did not change since its reception.
+   */
+  std::atomic<uint64_t> goal_update_counter_{ 0 };
+  /**
+   * @brief Preallocated trajectories towards the streaming setpoints, two segments per joint.
+   *
+   * The realtime thread only rebuilds a trajectory which is not referenced elsewhere, hence non-realtime threads can
+   * read the current trajectory meanwhile.
+   */
+  std::array<TrajectoryPtr, 3> streaming_trajectories_;
+  // Preallocated single joint states for building the streaming trajectories
+  typename Segment::State streaming_start_state_;
+  typename Segment::State streaming_target_state_;
+  typename Segment::State streaming_rest_state_;
+
+  //! @brief Keeps the trajectories handed over to the realtime thread, such that it never releases them.
+  std::unique_ptr<TrajectoryPool<Segment>> trajectory_pool_;
+
+  //! @brief True if goals received during the execution of another goal are queued instead of replacing it.
+  bool goal_queue_enabled_{ false };
+  //! @brief Radius[rad] in joint space around the junction of two queued goals, which is blended.
+  double blend_radius_{ 0.0 };
+  //! @brief Queued goals in the order of execution, which are not yet active. Protected by goal_queue_mutex_.
+  std::vector<RealtimeGoalHandlePtr> goal_queue_;
+  //! @brief Goals finished by the realtime thread, whose results are not yet forwarded. Protected by goal_queue_mutex_.
+  std::vector<RealtimeGoalHandlePtr> finished_goals_;
+  /**
+   * @brief Velocity path tolerances of the active goal and the queued goals, latest goal last. Protected by
+   * goal_queue_mutex_, handed over to the realtime thread by velocity_path_tolerances_buffer_.
+   */
+  std::vector<VelocityPathTolerances> velocity_path_tolerances_;
+  pilz_control::TripleBuffer<std::vector<VelocityPathTolerances>> velocity_path_tolerances_buffer_;
+  std::mutex goal_queue_mutex_;
+  /**
+   * @brief Queued goal, whose trajectory is executed. Written by the realtime thread, which leaves the assignment of
+   * the active goal to activateExecutedGoal(). The goal is kept alive by goal_queue_.
+   */
+  std::atomic<RealtimeGoalHandle*> executed_goal_{ nullptr };
+  //! @brief Goal of the current segment in the last cycle. Only used by the realtime thread, never dereferenced.
+  const RealtimeGoalHandle* rt_segment_goal_{ nullptr };
+  /**
+   * @brief Serializes the non-realtime assignments of the active goal, i.e. the goal callbacks, the hold requests and
+   * activateExecutedGoal(). Locked before goal_queue_mutex_, actionlib must not be called while it is held, unless
+   * from within an action server callback.
+   */
+  std::mutex active_goal_mutex_;
+  ros::Timer goal_queue_timer_;
+  //! @brief Written by mergeTrajectory() before the state becomes pending, read by the realtime thread afterwards.
+  TrajectoryMergeRequest trajectory_merge_request_;
+  //! @brief Holds a TrajectoryMergeState, mergeTrajectory() waits on it via a futex.
+  std::atomic<uint32_t> trajectory_merge_state_{ static_cast<uint32_t>(TrajectoryMergeState::idle) };
+  //! @brief Preallocated single joint state error for the goal tolerance check of queued goals.
+  typename Segment::State rt_joint_state_error_;
+
+  //! @brief Max time[s] to wait for the end of the stop motion on a hold request.
+  double hold_timeout_{ 0.0 };
+  std::unique_ptr<HoldActionServer> hold_action_server_;
+  //! @brief Goals of the hold action, protected by pending_hold_goals_mutex_.
+  std::vector<PendingHoldGoal> pending_hold_goals_;
+  std::mutex pending_hold_goals_mutex_;
+  //! @brief Wall timer, since waiting for the hold mode must end even if the (simulated) time stands still.
+  ros::WallTimer hold_goal_timer_;
+
+  // Durations[s] measured in the current cycle
+  mutable double speed_monitoring_duration_{ 0.0 };
+  double stop_duration_{ 0.0 };
 };
 
 }  // namespace pilz_joint_trajectory_controller
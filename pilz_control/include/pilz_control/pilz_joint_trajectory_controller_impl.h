@@ -17,8 +17,16 @@
 #ifndef PILZ_CONTROL_PILZ_JOINT_TRAJECTORY_CONTROLLER_IMPL_H
 #define PILZ_CONTROL_PILZ_JOINT_TRAJECTORY_CONTROLLER_IMPL_H
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <string>
+#include <utility>
 
+#include <joint_trajectory_controller/init_joint_trajectory.h>
 #include <joint_trajectory_controller/joint_trajectory_segment.h>
 #include <joint_trajectory_controller/tolerances.h>
 
@@ -27,16 +35,73 @@ namespace pilz_joint_trajectory_controller
 static constexpr double SPEED_LIMIT_ACTIVATED{ 0.25 };
 static constexpr double SPEED_LIMIT_NOT_ACTIVATED{ -1.0 };
 
+static constexpr int DEFAULT_LOOKAHEAD_SAMPLES{ 10 };
+static constexpr int DEFAULT_TRAJECTORY_POOL_CAPACITY{ 4 };
+//! @brief Default time[s] within which the robot moves to a streaming setpoint, fits setpoints sent with 250Hz.
+static constexpr double DEFAULT_STREAMING_SETPOINT_PERIOD{ 0.004 };
+//! @brief Default max time[s] to wait for the end of the stop motion on a hold request.
+static constexpr double DEFAULT_HOLD_TIMEOUT{ 3.0 };
+
+//! @brief Default max rate of change[1/s] of the speed scaling.
+static constexpr double DEFAULT_SPEED_OVERRIDE_MAX_RATE{ 1.0 };
+//! @brief Share of the joint acceleration limits which can be used for changing the speed scaling.
+static constexpr double SPEED_SCALING_ACCELERATION_SHARE{ 0.9 };
+//! @brief Max desired joint velocity[rad/s] and acceleration[rad/s^2] at which the trajectory is considered at rest.
+static constexpr double STANDSTILL_THRESHOLD{ 1e-9 };
+
+static constexpr double DEFAULT_CYCLE_TIME_PUBLISH_PERIOD{ 1.0 };
+static constexpr double DEFAULT_CYCLE_TIME_OVERRUN_THRESHOLD{ 50e-6 };
+//! @brief Period[s] in which the execution states recorded by the realtime thread are published.
+static constexpr double EXECUTION_STATE_CHECK_PERIOD{ 0.01 };
+//! @brief Period[s] in which joint limit violations detected by the realtime thread are reported.
+static constexpr double JOINT_LIMIT_VIOLATION_REPORT_PERIOD{ 0.01 };
+//! @brief Min time[s] between the receipt of a queued goal and the start of its blend.
+static constexpr double MIN_BLEND_LEAD_TIME{ 0.05 };
+//! @brief Max deviation[rad] between the start of a queued goal and the end of the current trajectory.
+static constexpr double QUEUED_GOAL_START_TOLERANCE{ 1e-3 };
+//! @brief Max wall time[s] to wait for the realtime thread to take over the trajectory of a queued goal.
+static constexpr double TRAJECTORY_MERGE_TIMEOUT{ 1.0 };
+
 static const std::string LIMITS_NAMESPACE{ "limits" };
+static const std::string LOOKAHEAD_NAMESPACE{ "lookahead" };
+static const std::string CYCLE_TIME_STATISTICS_NAMESPACE{ "cycle_time_statistics" };
 
 static const std::string ROBOT_DESCRIPTION_PARAM_NAME{ "/robot_description" };
 static const std::string HAS_ACCELERATION_LIMITS_PARAM_NAME{ "/has_acceleration_limits" };
 static const std::string MAX_ACCELERATION_PARAM_NAME{ "/max_acceleration" };
+static const std::string HAS_JERK_LIMITS_PARAM_NAME{ "/has_jerk_limits" };
+static const std::string MAX_JERK_PARAM_NAME{ "/max_jerk" };
+static const std::string CARTESIAN_SPEED_SUB_SAMPLES_PARAM_NAME{ "cartesian_speed_monitoring/sub_samples" };
+static const std::string CARTESIAN_SPEED_LIMIT_PARAM_NAME{ "cartesian_speed_monitoring/speed_limit" };
+static const std::string MONITORED_POINTS_PARAM_NAME{ "cartesian_speed_monitoring/monitored_points" };
+static const std::string MONITORED_POINT_LINK_KEY{ "link" };
+static const std::string MONITORED_POINT_OFFSET_KEY{ "offset" };
+static const std::string MONITORED_POINT_SPEED_LIMIT_KEY{ "speed_limit" };
+static const std::string LOOKAHEAD_ENABLED_PARAM_NAME{ "enabled" };
+static const std::string LOOKAHEAD_HORIZON_PARAM_NAME{ "horizon" };
+static const std::string LOOKAHEAD_SAMPLES_PARAM_NAME{ "samples" };
+static const std::string SPEED_OVERRIDE_MAX_RATE_PARAM_NAME{ "speed_override/max_rate" };
+static const std::string TRAJECTORY_POOL_CAPACITY_PARAM_NAME{ "trajectory_pool/capacity" };
+static const std::string STREAMING_ENABLED_PARAM_NAME{ "streaming/enabled" };
+static const std::string STREAMING_SETPOINT_PERIOD_PARAM_NAME{ "streaming/setpoint_period" };
+static const std::string HOLD_TIMEOUT_PARAM_NAME{ "hold/timeout" };
+static const std::string GOAL_QUEUE_ENABLED_PARAM_NAME{ "goal_queue/enabled" };
+static const std::string GOAL_QUEUE_BLEND_RADIUS_PARAM_NAME{ "goal_queue/blend_radius" };
+static const std::string CYCLE_TIME_PUBLISH_PERIOD_PARAM_NAME{ "publish_period" };
+static const std::string CYCLE_TIME_OVERRUN_THRESHOLD_PARAM_NAME{ "overrun_threshold" };
+
+static const std::string CYCLE_TIME_STATISTICS_TOPIC_NAME{ "cycle_time_statistics" };
+static const std::string EXECUTION_STATE_TOPIC_NAME{ "execution_state" };
+static const std::string SPEED_OVERRIDE_TOPIC_NAME{ "speed_override" };
+static const std::string STREAMING_SETPOINT_TOPIC_NAME{ "streaming_setpoint" };
 
 static const std::string HOLD_SERVICE_NAME{ "hold" };
 static const std::string UNHOLD_SERVICE_NAME{ "unhold" };
 static const std::string IS_EXECUTING_SERVICE_NAME{ "is_executing" };
 static const std::string MONITOR_CARTESIAN_SPEED_SERVICE_NAME{ "monitor_cartesian_speed" };
+static const std::string RELOAD_LIMITS_SERVICE_NAME{ "reload_limits" };
+
+static const std::string HOLD_ACTION_NAME{ "hold_action" };
 
 static const std::string USER_NOTIFICATION_NOT_IMPLEMENTED_COMMAND_INTERFACE_WARN{
   "The topic interface of the original `joint_trajectory_controller` is deactivated. Please use the action interface "
@@ -53,23 +118,43 @@ static const std::string USER_NOTIFICATION_NOT_IMPLEMENTED_COMMAND_INTERFACE_INF
 
 namespace ph = std::placeholders;
 
+inline std::chrono::nanoseconds toNanoseconds(const double& seconds)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(seconds));
+}
+
+//! @brief Equals max(0.0, value), but without a conditional.
+inline double positivePart(const double& value)
+{
+  return 0.5 * (value + std::abs(value));
+}
+
+//! @brief Create the result of a goal terminated by the controller.
+inline control_msgs::FollowJointTrajectoryResultConstPtr createResult(const int32_t& error_code,
+                                                                      const std::string& error_string)
+{
+  control_msgs::FollowJointTrajectoryResultPtr result{ new control_msgs::FollowJointTrajectoryResult() };
+  result->error_code = error_code;
+  result->error_string = error_string;
+  return result;
+}
+
 /**
  * @brief Calculate acceleration in direction of desired movement.
  *
  * @note If the direction of the movement changes (i.e. the velocities have different signs), we have a deceleration
  * from @p old_desired_velocity to 0.0 and an acceleration from 0.0 to @p desired_velocity. In this case the
  * deceleration part is neglected.
+ *
+ * Implemented without branches, such that loops over several joints can be vectorized.
  */
 inline double calculateAcceleration(const double& desired_velocity, const double& old_desired_velocity,
-                                    const ros::Duration& delta_t)
+                                    const double& inverse_delta_t)
 {
-  if (desired_velocity > 0.0)
-  {
-    // neglect deceleration if old_desired_velocity < 0.0
-    return (desired_velocity - std::max(0.0, old_desired_velocity)) / delta_t.toSec();
-  }
-  // neglect deceleration if old_desired_velocity > 0.0
-  return (std::min(0.0, old_desired_velocity) - desired_velocity) / delta_t.toSec();
+  // desired_velocity > 0.0: desired_velocity - max(0.0, old_desired_velocity)
+  // otherwise:              min(0.0, old_desired_velocity) - desired_velocity
+  const double direction{ 2.0 * static_cast<double>(desired_velocity > 0.0) - 1.0 };
+  return (direction * desired_velocity - positivePart(direction * old_desired_velocity)) * inverse_delta_t;
 }
 
 /**
@@ -80,14 +165,14 @@ inline double calculateAcceleration(const double& desired_velocity, const double
  * or if it lies inside the goal_time_tolerance of at least one segment.
  */
 template <class Segment>
-bool isTrajectoryExecuted(const std::vector<TrajectoryPerJoint<Segment>>& traj, const ros::Time& curr_uptime)
+bool isTrajectoryExecuted(const std::vector<TrajectoryPerJoint<Segment>>& traj, const ros::Time& curr_uptime,
+                          std::vector<SegmentCursor<Segment>>& cursors)
 {
   for (unsigned int joint_index = 0; joint_index < traj.size(); ++joint_index)
   {
-    const auto& segment_it = findSegment(traj[joint_index], curr_uptime.toSec());
-    const auto& tolerances = segment_it->getTolerances();
+    const auto segment_it = cursors[joint_index].findSegment(traj[joint_index], curr_uptime.toSec());
     if (segment_it != traj[joint_index].end() &&
-        curr_uptime.toSec() < segment_it->endTime() + tolerances.goal_time_tolerance)
+        curr_uptime.toSec() < segment_it->endTime() + segment_it->getTolerances().goal_time_tolerance)
     {
       return true;
     }
@@ -95,6 +180,20 @@ bool isTrajectoryExecuted(const std::vector<TrajectoryPerJoint<Segment>>& traj,
   return false;
 };
 
+//! @brief Convert the mode into its representation in pilz_control::ExecutionState.
+inline uint8_t toExecutionStateMode(const TrajProcessingMode& mode)
+{
+  switch (mode)
+  {
+    case TrajProcessingMode::unhold:
+      return pilz_control::ExecutionState::UNHOLD;
+    case TrajProcessingMode::stopping:
+      return pilz_control::ExecutionState::STOPPING;
+    default:
+      return pilz_control::ExecutionState::HOLD;
+  }
+}
+
 template <class SegmentImpl, class HardwareInterface>
 void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::makeParamNameWithSuffix(
     std::string& param_name, const std::string& joint_name, const std::string& suffix)
@@ -137,8 +236,162 @@ PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::getJointAccelerat
   return acc_limits;
 }
 
+template <class SegmentImpl, class HardwareInterface>
+std::vector<boost::optional<double>> PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::getJointJerkLimits(
+    const ros::NodeHandle& nh, const std::vector<std::string>& joint_names)
+{
+  std::vector<boost::optional<double>> jerk_limits(joint_names.size());
+  for (unsigned int i = 0; i < joint_names.size(); ++i)
+  {
+    bool has_jerk_limits = false;
+    std::string has_limits_param_name_to_read;
+    makeParamNameWithSuffix(has_limits_param_name_to_read, joint_names.at(i), HAS_JERK_LIMITS_PARAM_NAME);
+    nh.param<bool>(has_limits_param_name_to_read, has_jerk_limits, false);
+
+    if (has_jerk_limits)
+    {
+      std::string jerk_limits_param_name_to_read;
+      makeParamNameWithSuffix(jerk_limits_param_name_to_read, joint_names.at(i), MAX_JERK_PARAM_NAME);
+      double tmp_limit;
+      if (!nh.getParam(jerk_limits_param_name_to_read, tmp_limit))
+      {
+        throw ros::InvalidParameterException("Failed to get the joint jerk limit for " + joint_names.at(i) +
+                                             " under param name >" + jerk_limits_param_name_to_read + "<.");
+      }
+      jerk_limits.at(i) = tmp_limit;
+    }
+  }
+  return jerk_limits;
+}
+
+/**
+ * @brief Convert optional limits into limits which are infinite if not given.
+ */
+inline std::vector<double> toLimitArray(const std::vector<boost::optional<double>>& optional_limits)
+{
+  std::vector<double> limits;
+  for (const auto& limit : optional_limits)
+  {
+    limits.push_back(limit ? limit.value() : std::numeric_limits<double>::infinity());
+  }
+  return limits;
+}
+
+/**
+ * @brief Convert a numeric XmlRpc value (int or double) to double.
+ *
+ * @throw InvalidParameterException The value is not numeric.
+ */
+inline double toDouble(XmlRpc::XmlRpcValue& value, const std::string& param_name)
+{
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+  {
+    return static_cast<int>(value);
+  }
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeDouble)
+  {
+    return static_cast<double>(value);
+  }
+  throw ros::InvalidParameterException("Expected a number under param name >" + param_name + "<.");
+}
+
+template <class SegmentImpl, class HardwareInterface>
+std::vector<pilz_control::MonitoredPoint>
+PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::getMonitoredPoints(const ros::NodeHandle& nh)
+{
+  std::vector<pilz_control::MonitoredPoint> points;
+  XmlRpc::XmlRpcValue points_param;
+  if (!nh.getParam(MONITORED_POINTS_PARAM_NAME, points_param))
+  {
+    return points;
+  }
+  if (points_param.getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    throw ros::InvalidParameterException("Expected a list under param name >" + MONITORED_POINTS_PARAM_NAME + "<.");
+  }
+
+  for (int i = 0; i < points_param.size(); ++i)
+  {
+    XmlRpc::XmlRpcValue& point_param = points_param[i];
+    const std::string point_param_name{ MONITORED_POINTS_PARAM_NAME + "[" + std::to_string(i) + "]" };
+    if (point_param.getType() != XmlRpc::XmlRpcValue::TypeStruct || !point_param.hasMember(MONITORED_POINT_LINK_KEY) ||
+        point_param[MONITORED_POINT_LINK_KEY].getType() != XmlRpc::XmlRpcValue::TypeString)
+    {
+      throw ros::InvalidParameterException("Failed to get the link of the monitored point under param name >" +
+                                           point_param_name + "<.");
+    }
+
+    pilz_control::MonitoredPoint point;
+    point.link_name = static_cast<std::string>(point_param[MONITORED_POINT_LINK_KEY]);
+
+    if (point_param.hasMember(MONITORED_POINT_OFFSET_KEY))
+    {
+      XmlRpc::XmlRpcValue& offset_param = point_param[MONITORED_POINT_OFFSET_KEY];
+      if (offset_param.getType() != XmlRpc::XmlRpcValue::TypeArray || offset_param.size() != 3)
+      {
+        throw ros::InvalidParameterException("Expected a list [x, y, z] under param name >" + point_param_name + "/" +
+                                             MONITORED_POINT_OFFSET_KEY + "<.");
+      }
+      for (int j = 0; j < 3; ++j)
+      {
+        point.offset(j) = toDouble(offset_param[j], point_param_name + "/" + MONITORED_POINT_OFFSET_KEY);
+      }
+    }
+
+    if (point_param.hasMember(MONITORED_POINT_SPEED_LIMIT_KEY))
+    {
+      point.speed_limit = toDouble(point_param[MONITORED_POINT_SPEED_LIMIT_KEY],
+                                   point_param_name + "/" + MONITORED_POINT_SPEED_LIMIT_KEY);
+    }
+
+    points.push_back(point);
+  }
+  return points;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+ControllerLimits
+PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::getLimits(const ros::NodeHandle& nh,
+                                                                         const std::vector<std::string>& joint_names)
+{
+  ros::NodeHandle limits_nh(nh, LIMITS_NAMESPACE);
+  ControllerLimits limits;
+  limits.acceleration = toLimitArray(getJointAccelerationLimits(limits_nh, joint_names));
+  limits.jerk = toLimitArray(getJointJerkLimits(limits_nh, joint_names));
+  nh.param<double>(CARTESIAN_SPEED_LIMIT_PARAM_NAME, limits.cartesian_speed, SPEED_LIMIT_ACTIVATED);
+
+  for (std::size_t i = 0; i < joint_names.size(); ++i)
+  {
+    // Negated comparisons in order to reject NaN as well
+    if (!(limits.acceleration.at(i) > 0.0) || !(limits.jerk.at(i) > 0.0))
+    {
+      throw ros::InvalidParameterException("Expected positive acceleration and jerk limits for " + joint_names.at(i) +
+                                           ".");
+    }
+  }
+  if (!(limits.cartesian_speed > 0.0) || limits.cartesian_speed > SPEED_LIMIT_ACTIVATED)
+  {
+    throw ros::InvalidParameterException("Expected a cartesian speed limit in (0, " +
+                                         std::to_string(SPEED_LIMIT_ACTIVATED) + "] under param name >" +
+                                         CARTESIAN_SPEED_LIMIT_PARAM_NAME + "<.");
+  }
+  return limits;
+}
+
 template <class SegmentImpl, class HardwareInterface>
 PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::PilzJointTrajectoryController()
+  : limit_violation_result_(createResult(control_msgs::FollowJointTrajectoryResult::INVALID_GOAL,
+                                         "Stopped, since the trajectory violates the limits of the controller."))
+  , predecessor_aborted_result_(createResult(control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED,
+                                             "Aborted together with the preceding goal."))
+  , hold_result_(createResult(control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED,
+                              "Canceled, since the holding mode was requested."))
+  , client_cancel_result_(
+        createResult(control_msgs::FollowJointTrajectoryResult::SUCCESSFUL, "Canceled by the client."))
+  , replaced_result_(createResult(control_msgs::FollowJointTrajectoryResult::SUCCESSFUL,
+                                  "Canceled, since a new goal replaced the queued goals."))
+  , path_tolerance_result_(createResult(control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED,
+                                        "Aborted, since the velocity of a joint violated its path tolerance."))
 {
 }
 
@@ -150,8 +403,10 @@ bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::init(Hardwar
 {
   bool res = JointTrajectoryController::init(hw, root_nh, controller_nh);
 
-  ros::NodeHandle limits_nh(controller_nh, LIMITS_NAMESPACE);
-  acceleration_joint_limits_ = getJointAccelerationLimits(limits_nh, JointTrajectoryController::joint_names_);
+  controller_nh_ = controller_nh;
+  limits_ = getLimits(controller_nh, JointTrajectoryController::joint_names_);
+  limits_buffer_.writeFromNonRT(limits_);
+  rt_limits_ = &limits_buffer_.readFromRT();
 
   using robot_model_loader::RobotModelLoader;
   robot_model_loader_ = std::make_shared<RobotModelLoader>(ROBOT_DESCRIPTION_PARAM_NAME, false);
@@ -159,8 +414,43 @@ bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::init(Hardwar
 
   using pilz_control::CartesianSpeedMonitor;
   cartesian_speed_monitor_.reset(new CartesianSpeedMonitor(JointTrajectoryController::joint_names_, kinematic_model));
-  cartesian_speed_monitor_->init();
-  cartesian_speed_limit_ = SPEED_LIMIT_ACTIVATED;
+  int number_of_sub_samples{ 1 };
+  controller_nh.param<int>(CARTESIAN_SPEED_SUB_SAMPLES_PARAM_NAME, number_of_sub_samples, 1);
+  const auto monitored_points{ getMonitoredPoints(controller_nh) };
+  cartesian_speed_monitor_->init(static_cast<unsigned int>(std::max(1, number_of_sub_samples)), monitored_points);
+  cartesian_speed_monitoring_active_ = true;
+
+  ros::NodeHandle lookahead_nh(controller_nh, LOOKAHEAD_NAMESPACE);
+  bool lookahead_enabled{ false };
+  lookahead_nh.param<bool>(LOOKAHEAD_ENABLED_PARAM_NAME, lookahead_enabled, false);
+  if (lookahead_enabled)
+  {
+    // By default check the time needed for a controlled stop
+    lookahead_nh.param<double>(LOOKAHEAD_HORIZON_PARAM_NAME, lookahead_horizon_,
+                               JointTrajectoryController::stop_trajectory_duration_);
+    int number_of_lookahead_samples{ DEFAULT_LOOKAHEAD_SAMPLES };
+    lookahead_nh.param<int>(LOOKAHEAD_SAMPLES_PARAM_NAME, number_of_lookahead_samples, DEFAULT_LOOKAHEAD_SAMPLES);
+
+    if (lookahead_horizon_ > 0.0 && number_of_lookahead_samples > 0)
+    {
+      lookahead_speed_monitor_.reset(
+          new CartesianSpeedMonitor(JointTrajectoryController::joint_names_, kinematic_model));
+      lookahead_speed_monitor_->init(1, monitored_points);
+      const std::size_t number_of_joints{ JointTrajectoryController::getNumberOfJoints() };
+      lookahead_positions_.assign(static_cast<std::size_t>(number_of_lookahead_samples) + 1,
+                                  std::vector<double>(number_of_joints, 0.0));
+      lookahead_velocities_ = lookahead_positions_;
+      lookahead_accelerations_ = lookahead_positions_;
+      lookahead_segment_state_ = typename Segment::State(1);
+      lookahead_segment_cursors_.resize(number_of_joints);
+      ROS_INFO_STREAM_NAMED(this->name_, "Checking limits " << lookahead_horizon_ << "s in advance with "
+                                                            << number_of_lookahead_samples << " samples.");
+    }
+    else
+    {
+      ROS_WARN_STREAM_NAMED(this->name_, "Lookahead disabled due to non-positive horizon or number of samples.");
+    }
+  }
 
   hold_position_service =
       controller_nh.advertiseService(HOLD_SERVICE_NAME, &PilzJointTrajectoryController::handleHoldRequest, this);
@@ -168,21 +458,259 @@ bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::init(Hardwar
   unhold_position_service =
       controller_nh.advertiseService(UNHOLD_SERVICE_NAME, &PilzJointTrajectoryController::handleUnHoldRequest, this);
 
+  controller_nh.param<double>(HOLD_TIMEOUT_PARAM_NAME, hold_timeout_, DEFAULT_HOLD_TIMEOUT);
+  if (!(hold_timeout_ > 0.0))
+  {
+    ROS_WARN_STREAM_NAMED(this->name_, "Non-positive hold timeout, using the default " << DEFAULT_HOLD_TIMEOUT << "s.");
+    hold_timeout_ = DEFAULT_HOLD_TIMEOUT;
+  }
+  hold_action_server_.reset(new HoldActionServer(controller_nh, HOLD_ACTION_NAME,
+                                                 std::bind(&PilzJointTrajectoryController::holdGoalCB, this, ph::_1),
+                                                 std::bind(&PilzJointTrajectoryController::holdCancelCB, this, ph::_1),
+                                                 false));
+  hold_action_server_->start();
+  hold_goal_timer_ = controller_nh.createWallTimer(
+      ros::WallDuration(JointTrajectoryController::action_monitor_period_.toSec()),
+      &PilzJointTrajectoryController::monitorHoldGoals, this);
+
   is_executing_service_ = controller_nh.advertiseService(
       IS_EXECUTING_SERVICE_NAME, &PilzJointTrajectoryController::handleIsExecutingRequest, this);
 
   monitor_cartesian_speed_service_ = controller_nh.advertiseService(
       MONITOR_CARTESIAN_SPEED_SERVICE_NAME, &PilzJointTrajectoryController::handleMonitorCartesianSpeedRequest, this);
 
-  stop_traj_builder_ = std::unique_ptr<joint_trajectory_controller::StopTrajectoryBuilder<SegmentImpl>>(
-      new joint_trajectory_controller::StopTrajectoryBuilder<SegmentImpl>(
-          JointTrajectoryController::stop_trajectory_duration_, JointTrajectoryController::old_desired_state_));
-  stop_traj_velocity_violation_ =
-      JointTrajectoryController::createHoldTrajectory(JointTrajectoryController::getNumberOfJoints());
+  reload_limits_service_ = controller_nh.advertiseService(
+      RELOAD_LIMITS_SERVICE_NAME, &PilzJointTrajectoryController::handleReloadLimitsRequest, this);
+
+  controller_nh.param<double>(SPEED_OVERRIDE_MAX_RATE_PARAM_NAME, speed_override_max_rate_,
+                              DEFAULT_SPEED_OVERRIDE_MAX_RATE);
+  if (!(speed_override_max_rate_ > 0.0))
+  {
+    ROS_WARN_STREAM_NAMED(this->name_, "Non-positive max rate of the speed override, using the default "
+                                           << DEFAULT_SPEED_OVERRIDE_MAX_RATE << "/s.");
+    speed_override_max_rate_ = DEFAULT_SPEED_OVERRIDE_MAX_RATE;
+  }
+  rt_max_speed_scaling_rate_ = speed_override_max_rate_;
+  rt_speed_override_ = &speed_override_buffer_.readFromRT();
+  speed_override_subscriber_ =
+      controller_nh.subscribe(SPEED_OVERRIDE_TOPIC_NAME, 1, &PilzJointTrajectoryController::speedOverrideCB, this);
+
+  controller_nh.param<bool>(STREAMING_ENABLED_PARAM_NAME, streaming_enabled_, false);
+  controller_nh.param<double>(STREAMING_SETPOINT_PERIOD_PARAM_NAME, streaming_setpoint_period_,
+                              DEFAULT_STREAMING_SETPOINT_PERIOD);
+  if (!(streaming_setpoint_period_ > 0.0))
+  {
+    ROS_WARN_STREAM_NAMED(this->name_, "Non-positive streaming setpoint period, using the default "
+                                           << DEFAULT_STREAMING_SETPOINT_PERIOD << "s.");
+    streaming_setpoint_period_ = DEFAULT_STREAMING_SETPOINT_PERIOD;
+  }
+  if (streaming_enabled_ && JointTrajectoryController::getNumberOfJoints() > STREAMING_MAX_NUMBER_OF_JOINTS)
+  {
+    ROS_ERROR_STREAM_NAMED(this->name_, "Streaming disabled, since it supports at most "
+                                            << STREAMING_MAX_NUMBER_OF_JOINTS << " joints.");
+    streaming_enabled_ = false;
+  }
+  if (streaming_enabled_)
+  {
+    for (auto& trajectory : streaming_trajectories_)
+    {
+      trajectory = JointTrajectoryController::createHoldTrajectory(JointTrajectoryController::getNumberOfJoints());
+      for (auto& joint_trajectory : *trajectory)
+      {
+        joint_trajectory.push_back(joint_trajectory.front());
+      }
+    }
+    streaming_start_state_ = typename Segment::State(1);
+    streaming_target_state_ = typename Segment::State(1);
+    streaming_rest_state_ = typename Segment::State(1);
+    streaming_setpoint_subscriber_ = controller_nh.subscribe(
+        STREAMING_SETPOINT_TOPIC_NAME, STREAMING_SETPOINT_QUEUE_CAPACITY,
+        &PilzJointTrajectoryController::streamingSetpointCB, this, ros::TransportHints().tcpNoDelay());
+    ROS_INFO_STREAM_NAMED(this->name_, "Accepting streaming setpoints, each reached within "
+                                           << streaming_setpoint_period_ << "s.");
+  }
+
+  int trajectory_pool_capacity{ DEFAULT_TRAJECTORY_POOL_CAPACITY };
+  controller_nh.param<int>(TRAJECTORY_POOL_CAPACITY_PARAM_NAME, trajectory_pool_capacity,
+                           DEFAULT_TRAJECTORY_POOL_CAPACITY);
+  if (trajectory_pool_capacity < 0)
+  {
+    ROS_WARN_STREAM_NAMED(this->name_, "Negative capacity of the trajectory pool, using the default "
+                                           << DEFAULT_TRAJECTORY_POOL_CAPACITY << ".");
+    trajectory_pool_capacity = DEFAULT_TRAJECTORY_POOL_CAPACITY;
+  }
+  trajectory_pool_.reset(new TrajectoryPool<Segment>(static_cast<std::size_t>(trajectory_pool_capacity)));
+
+  controller_nh.param<bool>(GOAL_QUEUE_ENABLED_PARAM_NAME, goal_queue_enabled_, false);
+  controller_nh.param<double>(GOAL_QUEUE_BLEND_RADIUS_PARAM_NAME, blend_radius_, 0.0);
+  if (!(blend_radius_ >= 0.0))
+  {
+    ROS_WARN_STREAM_NAMED(this->name_, "Negative blend radius, goals are queued without blending.");
+    blend_radius_ = 0.0;
+  }
+  if (goal_queue_enabled_)
+  {
+    goal_queue_timer_ = controller_nh.createTimer(JointTrajectoryController::action_monitor_period_,
+                                                  &PilzJointTrajectoryController::runQueuedGoalsNonRealtime, this);
+    ROS_INFO_STREAM_NAMED(this->name_, "Queuing goals with a blend radius of " << blend_radius_ << "rad.");
+  }
+
+  stop_traj_builder_ = std::unique_ptr<JerkLimitedStopTrajectoryBuilder<SegmentImpl>>(
+      new JerkLimitedStopTrajectoryBuilder<SegmentImpl>(JointTrajectoryController::stop_trajectory_duration_,
+                                                        JointTrajectoryController::old_desired_state_));
+  for (auto& stop_traj : stop_trajectories_)
+  {
+    stop_traj = JointTrajectoryController::createHoldTrajectory(JointTrajectoryController::getNumberOfJoints());
+  }
+  rt_segment_cursors_.resize(JointTrajectoryController::getNumberOfJoints());
+  rt_joint_state_error_ = typename Segment::State(1);
+  is_executing_segment_cursors_.resize(JointTrajectoryController::getNumberOfJoints());
+
+  execution_state_publisher_ =
+      controller_nh.advertise<pilz_control::ExecutionState>(EXECUTION_STATE_TOPIC_NAME, 1, true /* latch */);
+  execution_state_.mode = toExecutionStateMode(mode_->getCurrentMode());
+  execution_state_.header.stamp = ros::Time::now();
+  execution_state_publisher_.publish(execution_state_);
+  rt_recorded_mode_ = execution_state_.mode;
+  execution_state_timer_ = controller_nh.createWallTimer(
+      ros::WallDuration(EXECUTION_STATE_CHECK_PERIOD), &PilzJointTrajectoryController::publishExecutionStates, this);
+
+  if (pilz_control::CYCLE_TIME_INSTRUMENTATION_ENABLED)
+  {
+    initCycleTimeStatistics(controller_nh);
+  }
+
+  joint_limit_violation_timer_ =
+      controller_nh.createWallTimer(ros::WallDuration(JOINT_LIMIT_VIOLATION_REPORT_PERIOD),
+                                    &PilzJointTrajectoryController::reportJointLimitViolations, this);
+
+  goal_termination_worker_.start();
 
   return res;
 }
 
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::update(const ros::Time& time,
+                                                                           const ros::Duration& period)
+{
+  rt_speed_override_ = &speed_override_buffer_.readFromRT();
+  if (streaming_enabled_)
+  {
+    processStreamingSetpoints();
+  }
+  TrajectoryPtr curr_traj_ptr;
+  JointTrajectoryController::curr_trajectory_box_.get(curr_traj_ptr);
+  if (mode_->getCurrentMode() == TrajProcessingMode::unhold &&
+      curr_traj_ptr != stop_trajectories_[rt_stop_trajectory_index_])
+  {
+    slewSpeedScaling(period);
+  }
+  else
+  {
+    // Stop motions (also of cancelled goals) are executed in real time, they start from the already scaled state
+    rt_speed_scaling_ = 1.0;
+    rt_speed_scaling_rate_ = 0.0;
+    rt_max_speed_scaling_rate_ = speed_override_max_rate_;
+  }
+
+  // The trajectory is sampled at the uptime, hence advancing the uptime by the scaled period results in a time-scaled
+  // execution. The period itself is passed on unchanged, since the hardware interface adapter refers to real time.
+  if (rt_speed_scaling_ != 1.0)
+  {
+    JointTrajectoryController::time_data_.readFromRT()->uptime -= period * (1.0 - rt_speed_scaling_);
+  }
+  JointTrajectoryController::update(time, period);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::stopping(const ros::Time& time)
+{
+  JointTrajectoryController::stopping(time);
+  // A trajectory handed over afterwards would not be decided until the next start
+  processTrajectoryMergeRequest(nullptr, time);
+  recordExecutionState(time, false);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::initCycleTimeStatistics(
+    ros::NodeHandle& controller_nh)
+{
+  ros::NodeHandle statistics_nh(controller_nh, CYCLE_TIME_STATISTICS_NAMESPACE);
+  double publish_period{ DEFAULT_CYCLE_TIME_PUBLISH_PERIOD };
+  statistics_nh.param<double>(CYCLE_TIME_PUBLISH_PERIOD_PARAM_NAME, publish_period, DEFAULT_CYCLE_TIME_PUBLISH_PERIOD);
+  double overrun_threshold{ DEFAULT_CYCLE_TIME_OVERRUN_THRESHOLD };
+  statistics_nh.param<double>(CYCLE_TIME_OVERRUN_THRESHOLD_PARAM_NAME, overrun_threshold,
+                              DEFAULT_CYCLE_TIME_OVERRUN_THRESHOLD);
+
+  cycle_time_recorder_.reset(new pilz_control::CycleTimeRecorder(overrun_threshold));
+  cycle_time_publisher_.reset(new realtime_tools::RealtimePublisher<pilz_control::CycleTimeStatistics>(
+      controller_nh, CYCLE_TIME_STATISTICS_TOPIC_NAME, 1));
+  cycle_time_timer_ = controller_nh.createWallTimer(
+      ros::WallDuration(publish_period), &PilzJointTrajectoryController::publishCycleTimeStatistics, this);
+  ROS_INFO_STREAM_NAMED(this->name_, "Publishing cycle time statistics every " << publish_period << "s.");
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::publishCycleTimeStatistics(
+    const ros::WallTimerEvent&)
+{
+  cycle_time_recorder_->processSamples();
+  if (cycle_time_publisher_->trylock())
+  {
+    cycle_time_publisher_->msg_.header.stamp = ros::Time::now();
+    cycle_time_recorder_->getStatistics(cycle_time_publisher_->msg_);
+    cycle_time_publisher_->unlockAndPublish();
+  }
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::recordExecutionState(const ros::Time& time,
+                                                                                         bool running)
+{
+  const bool executing{ running && rt_executing_.load(std::memory_order_relaxed) };
+  const uint8_t mode{ toExecutionStateMode(mode_->getCurrentMode()) };
+  const RealtimeGoalHandlePtr& active_goal{ JointTrajectoryController::rt_active_goal_ };
+  const uint64_t goal_update_count{ goal_update_counter_.load() };
+  if (executing == rt_recorded_executing_ && mode == rt_recorded_mode_ && active_goal.get() == rt_recorded_goal_ &&
+      goal_update_count == rt_recorded_goal_update_count_)
+  {
+    return;
+  }
+
+  ExecutionStateChange change;
+  change.stamp = time;
+  change.executing = executing;
+  change.mode = mode;
+  change.goal = active_goal;
+  if (!execution_state_changes_.push(change))
+  {
+    return;  // Retried in the next cycle, the goal reference is released with the local copy
+  }
+  rt_recorded_executing_ = executing;
+  rt_recorded_mode_ = mode;
+  rt_recorded_goal_ = active_goal.get();
+  rt_recorded_goal_update_count_ = goal_update_count;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::publishExecutionStates(const ros::WallTimerEvent&)
+{
+  execution_state_changes_.consume_all([this](const ExecutionStateChange& change) {
+    const std::string goal_id{ change.goal ? change.goal->gh_.getGoalID().id : std::string() };
+    if (change.executing == execution_state_.executing && change.mode == execution_state_.mode &&
+        goal_id == execution_state_.goal_id)
+    {
+      return;
+    }
+
+    execution_state_.header.stamp = change.stamp;
+    execution_state_.executing = change.executing;
+    execution_state_.mode = change.mode;
+    execution_state_.goal_id = goal_id;
+    execution_state_publisher_.publish(execution_state_);
+  });
+}
+
 template <class SegmentImpl, class HardwareInterface>
 bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::is_executing()
 {
@@ -202,7 +730,8 @@ bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::is_executing
   Trajectory& curr_traj = *curr_traj_ptr;
   auto uptime{ JointTrajectoryController::time_data_.readFromRT()->uptime };
 
-  return isTrajectoryExecuted<typename JointTrajectoryController::Segment>(curr_traj, uptime);
+  std::lock_guard<std::mutex> lock(is_executing_mutex_);
+  return isTrajectoryExecuted(curr_traj, uptime, is_executing_segment_cursors_);
 }
 
 template <class SegmentImpl, class HardwareInterface>
@@ -210,15 +739,31 @@ bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::handleHoldRe
     std_srvs::TriggerRequest&, std_srvs::TriggerResponse& response)
 {
   HoldModeListener listener;
-  if (mode_->stopEvent(&listener))
+  requestHold(&listener);
+
+  // Wait till stop motion finished by waiting for hold mode, but give up if the controller is not updated anymore
+  const std::chrono::nanoseconds check_period{ toNanoseconds(
+      JointTrajectoryController::action_monitor_period_.toSec()) };
+  const std::chrono::steady_clock::time_point deadline{ std::chrono::steady_clock::now() +
+                                                        toNanoseconds(hold_timeout_) };
+  while (!listener.waitFor(check_period))
   {
-    cancelActiveGoal();
-    triggerMovementToHoldPosition();
+    if (JointTrajectoryController::state_ != JointTrajectoryController::RUNNING)
+    {
+      ROS_ERROR_STREAM_NAMED(this->name_, "Controller stopped before the stop motion finished.");
+      response.message = "Controller stopped before the stop motion finished";
+      response.success = false;
+      return true;
+    }
+    if (std::chrono::steady_clock::now() >= deadline)
+    {
+      ROS_ERROR_STREAM_NAMED(this->name_, "Stop motion did not finish within " << hold_timeout_ << "s.");
+      response.message = "Stop motion did not finish in time";
+      response.success = false;
+      return true;
+    }
   }
 
-  // Wait till stop motion finished by waiting for hold mode
-  listener.wait();
-
   response.message = "Holding mode enabled";
   response.success = true;
   return true;
@@ -265,7 +810,65 @@ template <class SegmentImpl, class HardwareInterface>
 bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::updateStrategyDefault(
     const JointTrajectoryConstPtr& msg, RealtimeGoalHandlePtr gh, std::string* error_string)
 {
-  return JointTrajectoryController::updateTrajectoryCommand(msg, gh, error_string);
+  // Commands which do not create a new trajectory are handled by the parent, the pool is not involved
+  if (JointTrajectoryController::state_ != JointTrajectoryController::RUNNING || !msg || msg->points.empty())
+  {
+    return JointTrajectoryController::updateTrajectoryCommand(msg, gh, error_string);
+  }
+
+  const auto* time_data{ JointTrajectoryController::time_data_.readFromRT() };
+  const ros::Time next_update_time{ time_data->time + time_data->period };
+  ros::Time next_update_uptime{ time_data->uptime + time_data->period };
+
+  TrajectoryPtr curr_traj_ptr;
+  JointTrajectoryController::curr_trajectory_box_.get(curr_traj_ptr);
+
+  joint_trajectory_controller::InitJointTrajectoryOptions<Trajectory> options;
+  options.other_time_base = &next_update_uptime;
+  options.current_trajectory = curr_traj_ptr.get();
+  options.joint_names = &JointTrajectoryController::joint_names_;
+  options.angle_wraparound = &JointTrajectoryController::angle_wraparound_;
+  options.rt_goal_handle = gh;
+  options.default_tolerances = &JointTrajectoryController::default_tolerances_;
+  options.allow_partial_joints_goal = JointTrajectoryController::allow_partial_joints_goal_;
+  options.error_string = error_string;
+
+  try
+  {
+    Trajectory traj{ joint_trajectory_controller::initJointTrajectory<Trajectory>(*msg, next_update_time, options) };
+    if (traj.empty())
+    {
+      return false;
+    }
+    VelocityPathTolerances tolerances;
+    tolerances.goal = gh.get();
+    tolerances.velocity = takeVelocityPathTolerances(traj, gh);
+    // Owned by the pool before it is published, hence it is released outside of the realtime thread
+    JointTrajectoryController::curr_trajectory_box_.set(trajectory_pool_->acquire(std::move(traj)));
+    if (gh)
+    {
+      // The goal replaces the active goal and the queued goals
+      std::lock_guard<std::mutex> lock(goal_queue_mutex_);
+      velocity_path_tolerances_.assign(1, tolerances);
+      publishVelocityPathTolerances();
+    }
+  }
+  catch (const std::invalid_argument& ex)
+  {
+    ROS_ERROR_STREAM_NAMED(this->name_, ex.what());
+    if (error_string)
+    {
+      *error_string = ex.what();
+    }
+    return false;
+  }
+  catch (...)
+  {
+    ROS_ERROR_STREAM_NAMED(this->name_, "Unexpected exception caught when initializing trajectory from ROS message "
+                                        "data.");
+    return false;
+  }
+  return true;
 }
 
 template <class SegmentImpl, class HardwareInterface>
@@ -280,7 +883,8 @@ bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::updateStrate
 template <class SegmentImpl, class HardwareInterface>
 void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::triggerMovementToHoldPosition()
 {
-  JointTrajectoryController::setHoldPosition(this->time_data_.readFromRT()->uptime);
+  // Same as JointTrajectoryController::setHoldPosition(), but stops as fast as the limits allow
+  stop_requested_.store(true);
 }
 
 template <class SegmentImpl, class HardwareInterface>
@@ -288,11 +892,71 @@ inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::updat
     const typename JointTrajectoryController::Trajectory& curr_traj,
     const typename JointTrajectoryController::TimeData& time_data)
 {
+  if (!pilz_control::CYCLE_TIME_INSTRUMENTATION_ENABLED || !cycle_time_recorder_)
+  {
+    processCurrentMode(curr_traj, time_data);
+    recordExecutionState(time_data.time, true);
+    return;
+  }
+
+  pilz_control::CycleTimeSample sample;
+  speed_monitoring_duration_ = 0.0;
+  stop_duration_ = 0.0;
+  {
+    pilz_control::ScopedDurationMeasurement measurement(sample.extension_duration);
+    processCurrentMode(curr_traj, time_data);
+  }
+  recordExecutionState(time_data.time, true);
+  sample.uptime = time_data.uptime;
+  sample.speed_monitoring_duration = speed_monitoring_duration_;
+  sample.stop_duration = stop_duration_;
+  cycle_time_recorder_->record(sample);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::processCurrentMode(
+    const typename JointTrajectoryController::Trajectory& curr_traj,
+    const typename JointTrajectoryController::TimeData& time_data)
+{
+  // Apply limits reloaded since the last cycle
+  rt_limits_ = &limits_buffer_.readFromRT();
+  rt_trajectory_at_rest_ = isDesiredStateAtRest();
+
+  // Retry a failed abort request, unless the goal was replaced in the meantime
+  if (rt_goal_to_abort_ && rt_goal_to_abort_ == JointTrajectoryController::rt_active_goal_.get())
+  {
+    abortActiveGoal();
+  }
+  else
+  {
+    rt_goal_to_abort_ = nullptr;
+  }
+
+  const bool executing{ isTrajectoryExecuted(curr_traj, time_data.uptime, rt_segment_cursors_) };
+  if (executing != rt_executing_.load(std::memory_order_relaxed))
+  {
+    rt_executing_.store(executing, std::memory_order_relaxed);
+  }
+  if (goal_queue_enabled_)
+  {
+    updateQueuedGoals(curr_traj, time_data.uptime);
+    processTrajectoryMergeRequest(&curr_traj, time_data.uptime);
+  }
+
+  if (stop_requested_.exchange(false))
+  {
+    startStopMotion(time_data.uptime);
+    return;
+  }
+
   switch (mode_->getCurrentMode())
   {
     case TrajProcessingMode::unhold:
     {
-      if (!isPlannedUpdateOK(time_data.period) && mode_->stopEvent())
+      scaleDesiredState();
+      checkVelocityPathTolerances(curr_traj, time_data.uptime);
+      if ((!isPlannedUpdateOK(time_data.period) || !isLookaheadOK(curr_traj, time_data.uptime)) &&
+          mode_->stopEvent())
       {
         stopMotion(time_data.uptime);
       }
@@ -301,7 +965,7 @@ inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::updat
     case TrajProcessingMode::stopping:
     {
       // By construction of the stop trajectory we can exclude that the execution starts in the future
-      if (!isTrajectoryExecuted<typename JointTrajectoryController::Segment>(curr_traj, time_data.uptime))
+      if (!executing)
       {
         mode_->stopMotionFinishedEvent();
       }
@@ -316,76 +980,359 @@ inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::updat
 }
 
 template <class SegmentImpl, class HardwareInterface>
-inline bool
-PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::isPlannedUpdateOK(const ros::Duration& period) const
+inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::slewSpeedScaling(const ros::Duration& period)
 {
-  return isPlannedJointAccelerationOK(period) && isPlannedCartesianVelocityOK(period);
+  // A change of the speed scaling does not affect a trajectory at rest, hence the speed override applies immediately
+  if (rt_trajectory_at_rest_)
+  {
+    rt_speed_scaling_ = rt_speed_override_->speed_override;
+    rt_speed_scaling_rate_ = 0.0;
+    return;
+  }
+
+  const double max_change{ rt_max_speed_scaling_rate_ * period.toSec() };
+  const double change{ std::max(-max_change,
+                                std::min(max_change, rt_speed_override_->speed_override - rt_speed_scaling_)) };
+  rt_speed_scaling_ += change;
+  rt_speed_scaling_rate_ = period.toSec() > 0.0 ? change / period.toSec() : 0.0;
 }
 
 template <class SegmentImpl, class HardwareInterface>
-inline bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::isPlannedJointAccelerationOK(
-    const ros::Duration& period) const
+inline bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::isDesiredStateAtRest() const
 {
-  for (unsigned int i = 0; i < JointTrajectoryController::getNumberOfJoints(); ++i)
+  const auto& desired_state{ JointTrajectoryController::desired_state_ };
+  for (std::size_t i = 0; i < desired_state.velocity.size(); ++i)
   {
-    if (acceleration_joint_limits_.at(i))
+    if (std::abs(desired_state.velocity[i]) > STANDSTILL_THRESHOLD ||
+        std::abs(desired_state.acceleration[i]) > STANDSTILL_THRESHOLD)
     {
-      const double& old_velocity = JointTrajectoryController::old_desired_state_.velocity.at(i);
-      const double& new_velocity = JointTrajectoryController::desired_state_.velocity.at(i);
-      const double& acceleration = calculateAcceleration(new_velocity, old_velocity, period);
-      if (acceleration > acceleration_joint_limits_.at(i).value())
-      {
-        ROS_ERROR_STREAM_NAMED(JointTrajectoryController::name_,
-                               "Acceleration limit violated by joint "
-                                   << JointTrajectoryController::joint_names_.at(i)
-                                   << ". Desired acceleration: " << acceleration
-                                   << "rad/s^2, limit: " << acceleration_joint_limits_.at(i) << "rad/s^2.");
-        return false;
-      }
+      return false;
     }
   }
   return true;
 }
 
 template <class SegmentImpl, class HardwareInterface>
-inline bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::isPlannedCartesianVelocityOK(
-    const ros::Duration& period) const
+inline double PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::getMaxSpeedScalingRate() const
 {
-  return (cartesian_speed_monitor_->cartesianSpeedIsBelowLimit(JointTrajectoryController::old_desired_state_.position,
-                                                               JointTrajectoryController::desired_state_.position,
-                                                               period.toSec(), cartesian_speed_limit_));
+  const auto& desired_state{ JointTrajectoryController::desired_state_ };
+  const double acceleration_scaling{ rt_speed_scaling_ * rt_speed_scaling_ };
+  double max_rate{ speed_override_max_rate_ };
+  for (std::size_t i = 0; i < desired_state.velocity.size(); ++i)
+  {
+    const double remaining_acceleration{ SPEED_SCALING_ACCELERATION_SHARE * rt_limits_->acceleration[i] -
+                                         std::abs(desired_state.acceleration[i]) * acceleration_scaling };
+    const double speed{ std::abs(desired_state.velocity[i]) };
+    if (speed * max_rate > remaining_acceleration)
+    {
+      max_rate = remaining_acceleration > 0.0 ? remaining_acceleration / speed : 0.0;
+    }
+  }
+  return max_rate;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::scaleDesiredState()
+{
+  rt_max_speed_scaling_rate_ = getMaxSpeedScalingRate();
+  if (rt_speed_scaling_ == 1.0 && rt_speed_scaling_rate_ == 0.0)
+  {
+    return;
+  }
+
+  auto& desired_state{ JointTrajectoryController::desired_state_ };
+  const auto& current_state{ JointTrajectoryController::current_state_ };
+  auto& state_error{ JointTrajectoryController::state_error_ };
+  const double acceleration_scaling{ rt_speed_scaling_ * rt_speed_scaling_ };
+  for (std::size_t i = 0; i < desired_state.velocity.size(); ++i)
+  {
+    // Chain rule for the trajectory sampled at the scaled time
+    desired_state.acceleration[i] =
+        desired_state.acceleration[i] * acceleration_scaling + desired_state.velocity[i] * rt_speed_scaling_rate_;
+    desired_state.velocity[i] *= rt_speed_scaling_;
+    state_error.velocity[i] = desired_state.velocity[i] - current_state.velocity[i];
+  }
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::checkVelocityPathTolerances(
+    const typename JointTrajectoryController::Trajectory& curr_traj, const ros::Time& uptime)
+{
+  const RealtimeGoalHandlePtr& active_goal{ JointTrajectoryController::rt_active_goal_ };
+  const std::vector<VelocityPathTolerances>& all_tolerances{ velocity_path_tolerances_buffer_.readFromRT() };
+  if (!active_goal || active_goal.get() == rt_goal_to_abort_)
+  {
+    return;
+  }
+  // The latest entry wins, in case the address of a finished goal was reused
+  const auto tolerances_it{ std::find_if(
+      all_tolerances.rbegin(), all_tolerances.rend(),
+      [&active_goal](const VelocityPathTolerances& tolerances) { return tolerances.goal == active_goal.get(); }) };
+  if (tolerances_it == all_tolerances.rend())
+  {
+    return;
+  }
+
+  const auto& state_error{ JointTrajectoryController::state_error_ };
+  for (std::size_t i = 0; i < curr_traj.size() && i < tolerances_it->velocity.size(); ++i)
+  {
+    const double tolerance{ tolerances_it->velocity[i] };
+    if (!(tolerance > 0.0) || std::abs(state_error.velocity[i]) <= tolerance)
+    {
+      continue;
+    }
+    // Like the parent class, only checked during the segments of the active goal
+    const auto segment_it{ rt_segment_cursors_[i].findSegment(curr_traj[i], uptime.toSec()) };
+    if (segment_it == curr_traj[i].end() || segment_it->getGoalHandle() != active_goal ||
+        uptime.toSec() >= segment_it->endTime())
+    {
+      continue;
+    }
+    RealtimeGoalHandlePtr violating_goal(active_goal);
+    if (goal_termination_worker_.requestAbort(violating_goal, path_tolerance_result_))
+    {
+      JointTrajectoryController::rt_active_goal_.reset();
+    }
+    // Otherwise retried in the next cycle, keeping the goal active ensures that the last reference is not released here
+    return;
+  }
+}
+
+template <class SegmentImpl, class HardwareInterface>
+std::vector<double> PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::takeVelocityPathTolerances(
+    Trajectory& traj, const RealtimeGoalHandlePtr& gh)
+{
+  std::vector<double> velocity_tolerances(traj.size(), 0.0);
+  if (!gh)
+  {
+    return velocity_tolerances;
+  }
+  for (std::size_t i = 0; i < traj.size(); ++i)
+  {
+    for (auto& segment : traj[i])
+    {
+      if (segment.getGoalHandle() != gh)
+      {
+        continue;  // Segments of preceding goals were already handled
+      }
+      auto tolerances{ segment.getTolerances() };
+      velocity_tolerances[i] = tolerances.state_tolerance.velocity;
+      tolerances.state_tolerance.velocity = 0.0;  // Disables the check of the parent class
+      segment.setTolerances(tolerances);
+    }
+  }
+  return velocity_tolerances;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::publishVelocityPathTolerances()
+{
+  velocity_path_tolerances_buffer_.writeFromNonRT(velocity_path_tolerances_);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline bool
+PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::isPlannedUpdateOK(const ros::Duration& period) const
+{
+  return isPlannedJointAccelerationOK(period) && isPlannedCartesianVelocityOK(period);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::isPlannedJointAccelerationOK(
+    const ros::Duration& period) const
+{
+  const auto& old_desired_state{ JointTrajectoryController::old_desired_state_ };
+  const auto& desired_state{ JointTrajectoryController::desired_state_ };
+  return areJointLimitsOK(old_desired_state.velocity, desired_state.velocity, old_desired_state.acceleration,
+                          desired_state.acceleration, period);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::areJointLimitsOK(
+    const std::vector<double>& old_velocity, const std::vector<double>& new_velocity,
+    const std::vector<double>& old_acceleration, const std::vector<double>& new_acceleration,
+    const ros::Duration& period, const double& lead_time) const
+{
+  const std::vector<double>& acceleration_limits{ rt_limits_->acceleration };
+  const std::vector<double>& jerk_limits{ rt_limits_->jerk };
+  const std::size_t number_of_joints{ acceleration_limits.size() };
+  const double inverse_period{ 1.0 / period.toSec() };
+
+  // Single pass without branches and without early exit, such that the loop can be vectorized
+  uint64_t limits_violated{ 0 };
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    const double acceleration{ calculateAcceleration(new_velocity[i], old_velocity[i], inverse_period) };
+    const double jerk{ std::abs(new_acceleration[i] - old_acceleration[i]) * inverse_period };
+    limits_violated |= static_cast<uint64_t>(acceleration > acceleration_limits[i]) |
+                       static_cast<uint64_t>(jerk > jerk_limits[i]);
+  }
+  if (limits_violated == 0)
+  {
+    return true;
+  }
+
+  // Determine the details, which are reported outside of the realtime thread
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    JointLimitViolation violation;
+    violation.joint_index = i;
+    violation.lead_time = lead_time;
+    const double acceleration{ calculateAcceleration(new_velocity[i], old_velocity[i], inverse_period) };
+    const double jerk{ std::abs(new_acceleration[i] - old_acceleration[i]) * inverse_period };
+    if (acceleration > acceleration_limits[i])
+    {
+      violation.type = JointLimitViolation::Type::acceleration;
+      violation.value = acceleration;
+      violation.limit = acceleration_limits[i];
+      joint_limit_violations_.push(violation);
+    }
+    if (jerk > jerk_limits[i])
+    {
+      violation.type = JointLimitViolation::Type::jerk;
+      violation.value = jerk;
+      violation.limit = jerk_limits[i];
+      joint_limit_violations_.push(violation);
+    }
+  }
+  return false;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::reportJointLimitViolations(
+    const ros::WallTimerEvent&)
+{
+  joint_limit_violations_.consume_all([this](const JointLimitViolation& violation) {
+    const bool is_acceleration{ violation.type == JointLimitViolation::Type::acceleration };
+    const std::string& joint_name{ JointTrajectoryController::joint_names_.at(violation.joint_index) };
+    if (violation.lead_time > 0.0)
+    {
+      ROS_WARN_STREAM_NAMED(JointTrajectoryController::name_,
+                            (is_acceleration ? "Acceleration" : "Jerk")
+                                << " limit violation by joint " << joint_name << " predicted in "
+                                << violation.lead_time << "s. Predicted "
+                                << (is_acceleration ? "acceleration: " : "jerk: ") << violation.value
+                                << (is_acceleration ? "rad/s^2" : "rad/s^3") << ", limit: " << violation.limit
+                                << (is_acceleration ? "rad/s^2." : "rad/s^3."));
+      return;
+    }
+    ROS_ERROR_STREAM_NAMED(JointTrajectoryController::name_,
+                           (is_acceleration ? "Acceleration" : "Jerk")
+                               << " limit violated by joint " << joint_name << ". Desired "
+                               << (is_acceleration ? "acceleration: " : "jerk: ") << violation.value
+                               << (is_acceleration ? "rad/s^2" : "rad/s^3") << ", limit: " << violation.limit
+                               << (is_acceleration ? "rad/s^2." : "rad/s^3."));
+  });
+  lookahead_stops_.consume_all([this](const double& lead_time) {
+    ROS_ERROR_STREAM_NAMED(JointTrajectoryController::name_,
+                           "Limit violation predicted in " << lead_time << "s. Stopped in advance.");
+  });
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::isPlannedCartesianVelocityOK(
+    const ros::Duration& period) const
+{
+  pilz_control::ScopedDurationMeasurement measurement(speed_monitoring_duration_);
+  return (cartesian_speed_monitor_->cartesianSpeedIsBelowLimit(JointTrajectoryController::old_desired_state_.position,
+                                                               JointTrajectoryController::desired_state_.position,
+                                                               period.toSec(), getCartesianSpeedLimit()));
+}
+
+template <class SegmentImpl, class HardwareInterface>
+bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::isLookaheadOK(
+    const typename JointTrajectoryController::Trajectory& curr_traj, const ros::Time& uptime)
+{
+  if (lookahead_positions_.empty())
+  {
+    return true;
+  }
+
+  const std::size_t number_of_samples{ lookahead_positions_.size() - 1 };
+  // The horizon refers to real time, the trajectory is sampled in (scaled) trajectory time
+  const double sample_period{ lookahead_horizon_ / static_cast<double>(number_of_samples) };
+  const double trajectory_sample_period{ sample_period * rt_speed_scaling_ };
+  const double acceleration_scaling{ rt_speed_scaling_ * rt_speed_scaling_ };
+
+  const auto& desired_state{ JointTrajectoryController::desired_state_ };
+  std::copy(desired_state.position.begin(), desired_state.position.end(), lookahead_positions_.front().begin());
+  std::copy(desired_state.velocity.begin(), desired_state.velocity.end(), lookahead_velocities_.front().begin());
+  std::copy(desired_state.acceleration.begin(), desired_state.acceleration.end(),
+            lookahead_accelerations_.front().begin());
+
+  // Sample joint by joint, such that consecutive samples are located in the same or in subsequent segments
+  for (std::size_t joint_index = 0; joint_index < curr_traj.size(); ++joint_index)
+  {
+    if (curr_traj[joint_index].empty())
+    {
+      return true;  // LCOV_EXCL_LINE Trajectories of the controller always contain at least one segment
+    }
+    auto& cursor{ lookahead_segment_cursors_[joint_index] };
+    for (std::size_t k = 1; k <= number_of_samples; ++k)
+    {
+      // Equivalent to trajectory_interface::sample(), but avoids a binary search per sample
+      const double sample_time{ uptime.toSec() + static_cast<double>(k) * trajectory_sample_period };
+      const auto segment_it{ cursor.findSegment(curr_traj[joint_index], sample_time) };
+      const auto& segment{ segment_it != curr_traj[joint_index].end() ? *segment_it : curr_traj[joint_index].front() };
+      segment.sample(sample_time, lookahead_segment_state_);
+      lookahead_positions_[k][joint_index] = lookahead_segment_state_.position[0];
+      lookahead_velocities_[k][joint_index] = lookahead_segment_state_.velocity[0] * rt_speed_scaling_;
+      lookahead_accelerations_[k][joint_index] = lookahead_segment_state_.acceleration[0] * acceleration_scaling;
+    }
+  }
+
+  const ros::Duration sample_duration(sample_period);
+  for (std::size_t k = 1; k <= number_of_samples; ++k)
+  {
+    const double lead_time{ static_cast<double>(k) * sample_period };
+    if (!areJointLimitsOK(lookahead_velocities_[k - 1], lookahead_velocities_[k], lookahead_accelerations_[k - 1],
+                          lookahead_accelerations_[k], sample_duration, lead_time) ||
+        !lookahead_speed_monitor_->cartesianSpeedIsBelowLimit(lookahead_positions_[k - 1], lookahead_positions_[k],
+                                                              sample_period, getCartesianSpeedLimit()))
+    {
+      lookahead_stops_.push(lead_time);
+      return false;
+    }
+  }
+  return true;
 }
 
 template <class SegmentImpl, class HardwareInterface>
 void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::stopMotion(const ros::Time& curr_uptime)
 {
+  pilz_control::ScopedDurationMeasurement measurement(stop_duration_);
   abortActiveGoal();
+  startStopMotion(curr_uptime);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::startStopMotion(const ros::Time& curr_uptime)
+{
+  rt_stop_trajectory_index_ = 1 - rt_stop_trajectory_index_;
+  const TrajectoryPtr& stop_traj{ stop_trajectories_[rt_stop_trajectory_index_] };
 
-  stop_traj_builder_->setStartTime(JointTrajectoryController::old_time_data_.uptime.toSec())
-      ->buildTrajectory(stop_traj_velocity_violation_.get());
+  stop_traj_builder_->setLimits(rt_limits_->acceleration, rt_limits_->jerk)
+      ->setStartTime(JointTrajectoryController::old_time_data_.uptime.toSec())
+      ->buildTrajectory(stop_traj.get());
   stop_traj_builder_->reset();
-  JointTrajectoryController::updateStates(curr_uptime, stop_traj_velocity_violation_.get());
+  JointTrajectoryController::updateStates(curr_uptime, stop_traj.get());
 
-  JointTrajectoryController::curr_trajectory_box_.set(stop_traj_velocity_violation_);
+  JointTrajectoryController::curr_trajectory_box_.set(stop_traj);
 }
 
 template <class SegmentImpl, class HardwareInterface>
-inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::cancelActiveGoal()
+inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::cancelActiveGoal(
+    const ResultConstPtr& result)
 {
+  std::lock_guard<std::mutex> lock(active_goal_mutex_);
+  activateExecutedGoal();
   RealtimeGoalHandlePtr active_goal(JointTrajectoryController::rt_active_goal_);
   if (!active_goal)
   {
     return;
   }
   JointTrajectoryController::rt_active_goal_.reset();
-  active_goal->gh_.setCanceled();
-  // TODO: Instead of the line above, I actually want to do this:
-  //      active_goal->preallocated_result_->error_code =
-  //      control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED;
-  //      active_goal->setCanceled(active_goal->preallocated_result_);
-  // Unfortunately this does not work because sometimes the goal does not seems to get cancelled.
-  // It has to be investigated why! -> Probably a threading problem. See also:
-  // https://github.com/ros-controls/ros_controllers/issues/174
+  goal_termination_worker_.requestCancel(active_goal, result);
 }
 
 template <class SegmentImpl, class HardwareInterface>
@@ -394,29 +1341,797 @@ inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::abort
   RealtimeGoalHandlePtr active_goal(JointTrajectoryController::rt_active_goal_);
   if (!active_goal)
   {
-    return;  // LCOV_EXCL_LINE
-             // Since the command topic is deactivated it is impossible to violate a limit without an active goal
+    rt_goal_to_abort_ = nullptr;
+    return;  // No goal is active while streaming setpoints are executed
   }
+  if (!goal_termination_worker_.requestAbort(active_goal, limit_violation_result_))
+  {
+    // Keeping the goal active ensures that the last reference is not released here
+    rt_goal_to_abort_ = active_goal.get();
+    return;
+  }
+  rt_goal_to_abort_ = nullptr;
   JointTrajectoryController::rt_active_goal_.reset();
-  active_goal->gh_.setAborted();
-  // TODO: Instead of the line above, I actually want to do this:
-  //      active_goal->preallocated_result_->error_code =
-  //      control_msgs::FollowJointTrajectoryResult::INVALID_GOAL;
-  //      active_goal->setAborted(active_goal->preallocated_result_);
-  // Unfortunately this does not work because sometimes the goal does not seems to get aborted.
-  // It has to be investigated why! -> Probably a threading problem. See also:
-  // https://github.com/ros-controls/ros_controllers/issues/174
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::goalCB(GoalHandle gh)
+{
+  // The goal callbacks are serialized by the action server
+  goal_update_counter_.fetch_add(1);
+  handleGoal(gh);
+  goal_update_counter_.fetch_add(1);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::handleGoal(GoalHandle gh)
+{
+  TrajectoryPtr curr_traj_ptr;
+  {
+    std::lock_guard<std::mutex> lock(active_goal_mutex_);
+    activateExecutedGoal();
+    JointTrajectoryController::curr_trajectory_box_.get(curr_traj_ptr);
+    const auto* time_data{ JointTrajectoryController::time_data_.readFromRT() };
+    const double min_blend_start_time{ (time_data->uptime + time_data->period).toSec() + MIN_BLEND_LEAD_TIME };
+
+    if (!goal_queue_enabled_ || !JointTrajectoryController::rt_active_goal_ || !curr_traj_ptr ||
+        curr_traj_ptr->empty() || curr_traj_ptr->front().empty() ||
+        curr_traj_ptr->front().back().endTime() < min_blend_start_time)
+    {
+      // Nothing to append to, the goal replaces the active goal
+      cancelQueuedGoals(replaced_result_);
+      JointTrajectoryController::goalCB(gh);
+      return;
+    }
+  }
+
+  std::string error_string;
+  if (!queueGoal(gh, curr_traj_ptr, &error_string))
+  {
+    ROS_ERROR_STREAM_NAMED(this->name_, "Rejected queued goal: " << error_string);
+    control_msgs::FollowJointTrajectoryResult result;
+    result.error_code = control_msgs::FollowJointTrajectoryResult::INVALID_GOAL;
+    result.error_string = error_string;
+    gh.setRejected(result);
+  }
+}
+
+template <class SegmentImpl, class HardwareInterface>
+bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::queueGoal(GoalHandle gh,
+                                                                              const TrajectoryPtr& curr_traj_ptr,
+                                                                              std::string* error_string)
+{
+  if (JointTrajectoryController::state_ != JointTrajectoryController::RUNNING)
+  {
+    *error_string = "Can't accept new action goals. Controller is not running.";
+    return false;
+  }
+  if (mode_->getCurrentMode() != TrajProcessingMode::unhold)
+  {
+    *error_string = "Controller is not in unhold mode.";
+    return false;
+  }
+  const auto goal{ gh.getGoal() };
+  const trajectory_msgs::JointTrajectory& msg{ goal->trajectory };
+  if (msg.points.empty())
+  {
+    *error_string = "Queued goals must contain at least one point.";
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(goal_queue_mutex_);
+    if (goal_queue_.size() >= GOAL_QUEUE_CAPACITY)
+    {
+      *error_string = "Goal queue is full.";
+      return false;
+    }
+  }
+
+  const auto* time_data{ JointTrajectoryController::time_data_.readFromRT() };
+  const ros::Time next_update_time{ time_data->time + time_data->period };
+  ros::Time next_update_uptime{ time_data->uptime + time_data->period };
+  const Trajectory& curr_traj{ *curr_traj_ptr };
+  const double junction_time{ curr_traj.front().back().endTime() };
+
+  // The goal starts from the end state of the current trajectory, which is provided by a single tail segment
+  Trajectory tail_traj(curr_traj.size());
+  std::vector<double> junction_positions(curr_traj.size());
+  typename Segment::State state(1);
+  for (std::size_t i = 0; i < curr_traj.size(); ++i)
+  {
+    curr_traj[i].back().sample(junction_time, state);
+    junction_positions[i] = state.position[0];
+    tail_traj[i].emplace_back(next_update_uptime.toSec(), state, junction_time, state);
+  }
+
+  RealtimeGoalHandlePtr rt_goal(new RealtimeGoalHandle(gh));
+  rt_goal->preallocated_feedback_->joint_names = JointTrajectoryController::joint_names_;
+
+  // Shift the goal to the end of the current trajectory
+  trajectory_msgs::JointTrajectory shifted_msg{ msg };
+  shifted_msg.header.stamp = next_update_time + ros::Duration(junction_time - next_update_uptime.toSec());
+
+  joint_trajectory_controller::InitJointTrajectoryOptions<Trajectory> options;
+  options.current_trajectory = &tail_traj;
+  options.other_time_base = &next_update_uptime;
+  options.joint_names = &JointTrajectoryController::joint_names_;
+  options.angle_wraparound = &JointTrajectoryController::angle_wraparound_;
+  options.rt_goal_handle = rt_goal;
+  options.default_tolerances = &JointTrajectoryController::default_tolerances_;
+  options.allow_partial_joints_goal = false;
+  options.error_string = error_string;
+
+  Trajectory next_traj;
+  try
+  {
+    next_traj = joint_trajectory_controller::initJointTrajectory<Trajectory>(shifted_msg, next_update_time, options);
+  }
+  catch (const std::exception& ex)
+  {
+    *error_string = ex.what();
+    return false;
+  }
+
+  // Only the segments of the goal are appended, the tail merely provides the start state
+  for (auto& joint_traj : next_traj)
+  {
+    joint_traj.erase(std::remove_if(joint_traj.begin(), joint_traj.end(),
+                                    [&next_update_uptime](const Segment& segment) {
+                                      return segment.startTime() <= next_update_uptime.toSec();
+                                    }),
+                     joint_traj.end());
+    if (joint_traj.empty())
+    {
+      if (error_string->empty())
+      {
+        *error_string = "Failed to create the trajectory of the goal.";
+      }
+      return false;
+    }
+  }
+
+  for (std::size_t i = 0; i < next_traj.size(); ++i)
+  {
+    trajectory_interface::sample(next_traj[i], junction_time, state);
+    if (std::abs(state.position[0] - junction_positions[i]) > QUEUED_GOAL_START_TOLERANCE)
+    {
+      *error_string = "Goal does not start at the end of the current trajectory.";
+      return false;
+    }
+  }
+
+  VelocityPathTolerances tolerances;
+  tolerances.goal = rt_goal.get();
+  tolerances.velocity = takeVelocityPathTolerances(next_traj, rt_goal);
+
+  ControllerLimits limits;
+  {
+    std::lock_guard<std::mutex> lock(limits_mutex_);
+    limits = limits_;
+  }
+  // A blend violating the limits would stop the robot, hence it is checked before the goal is accepted
+  const double uptime{ time_data->uptime.toSec() };
+  const TrajectoryPtr merged_traj_ptr{ trajectory_pool_->acquire(appendTrajectory(
+      curr_traj, next_traj, uptime, blend_radius_, uptime + MIN_BLEND_LEAD_TIME, limits.acceleration, limits.jerk)) };
+  if (merged_traj_ptr->empty())
+  {
+    *error_string = "Failed to append the trajectory of the goal.";  // LCOV_EXCL_LINE Both trajectories are valid
+    return false;                                                    // LCOV_EXCL_LINE
+  }
+
+  // The realtime thread does not overwrite a stop motion, which was triggered in the meantime
+  if (!mergeTrajectory(curr_traj_ptr, merged_traj_ptr, uptime + MIN_BLEND_LEAD_TIME))
+  {
+    *error_string = "Current trajectory changed while queuing the goal.";
+    return false;
+  }
+
+  // Accepted before it is queued, since a queued goal might be aborted right away, see runQueuedGoalsNonRealtime()
+  gh.setAccepted();
+  std::lock_guard<std::mutex> lock(goal_queue_mutex_);
+  goal_queue_.push_back(rt_goal);
+  velocity_path_tolerances_.push_back(tolerances);
+  publishVelocityPathTolerances();
+  return true;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::mergeTrajectory(
+    const TrajectoryPtr& base_traj_ptr, const TrajectoryPtr& merged_traj_ptr, const double& latest_install_time)
+{
+  const uint32_t pending{ static_cast<uint32_t>(TrajectoryMergeState::pending) };
+  trajectory_merge_request_.base_trajectory = base_traj_ptr;
+  trajectory_merge_request_.merged_trajectory = merged_traj_ptr;
+  trajectory_merge_request_.latest_install_time = latest_install_time;
+  trajectory_merge_state_.store(pending);
+
+  // stopping() might have passed before the request became pending
+  const bool withdraw{ JointTrajectoryController::state_ != JointTrajectoryController::RUNNING };
+  const std::chrono::steady_clock::time_point deadline{ std::chrono::steady_clock::now() +
+                                                        toNanoseconds(TRAJECTORY_MERGE_TIMEOUT) };
+  uint32_t state{ pending };
+  while (state == pending || state == static_cast<uint32_t>(TrajectoryMergeState::processing))
+  {
+    const std::chrono::nanoseconds remaining_time{ deadline - std::chrono::steady_clock::now() };
+    if (withdraw || remaining_time.count() <= 0)
+    {
+      // Fails if the realtime thread is processing the request right now, its decision follows immediately
+      uint32_t expected{ pending };
+      if (trajectory_merge_state_.compare_exchange_strong(expected,
+                                                          static_cast<uint32_t>(TrajectoryMergeState::rejected)))
+      {
+        if (!withdraw)
+        {
+          ROS_ERROR_STREAM_NAMED(this->name_, "Controller did not take over the trajectory of the queued goal within "
+                                                  << TRAJECTORY_MERGE_TIMEOUT << "s.");
+        }
+        break;
+      }
+    }
+    futexWait(trajectory_merge_state_, state, remaining_time);
+    state = trajectory_merge_state_.load(std::memory_order_acquire);
+  }
+
+  // The realtime thread does not access the request anymore
+  state = trajectory_merge_state_.exchange(static_cast<uint32_t>(TrajectoryMergeState::idle));
+  trajectory_merge_request_ = TrajectoryMergeRequest();
+  return state == static_cast<uint32_t>(TrajectoryMergeState::installed);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::processTrajectoryMergeRequest(
+    const typename JointTrajectoryController::Trajectory* curr_traj, const ros::Time& uptime)
+{
+  uint32_t expected{ static_cast<uint32_t>(TrajectoryMergeState::pending) };
+  if (!trajectory_merge_state_.compare_exchange_strong(
+          expected, static_cast<uint32_t>(TrajectoryMergeState::processing), std::memory_order_acquire))
+  {
+    return;
+  }
+
+  // The combined trajectory equals the base trajectory up to the latest install time
+  const TrajectoryMergeRequest& request{ trajectory_merge_request_ };
+  const bool install{ curr_traj && curr_traj == request.base_trajectory.get() &&
+                      mode_->getCurrentMode() == TrajProcessingMode::unhold &&
+                      JointTrajectoryController::rt_active_goal_ && uptime.toSec() <= request.latest_install_time };
+  if (install)
+  {
+    // The request keeps a reference to the base trajectory, hence it is not released here
+    JointTrajectoryController::curr_trajectory_box_.set(request.merged_trajectory);
+  }
+  trajectory_merge_state_.store(
+      static_cast<uint32_t>(install ? TrajectoryMergeState::installed : TrajectoryMergeState::rejected),
+      std::memory_order_release);
+  // The handing over thread always waits for the decision
+  futexWakeAll(trajectory_merge_state_);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::cancelCB(GoalHandle gh)
+{
+  bool is_known_goal{ false };
+  {
+    std::lock_guard<std::mutex> lock(active_goal_mutex_);
+    activateExecutedGoal();
+    RealtimeGoalHandlePtr active_goal(JointTrajectoryController::rt_active_goal_);
+    is_known_goal = active_goal && active_goal->gh_ == gh;
+  }
+  std::vector<RealtimeGoalHandlePtr> goal_queue;
+  {
+    std::lock_guard<std::mutex> lock(goal_queue_mutex_);
+    goal_queue = goal_queue_;
+  }
+  // Compared outside of the lock, since the comparison calls into actionlib
+  for (const auto& queued_goal : goal_queue)
+  {
+    is_known_goal = is_known_goal || queued_goal->gh_ == gh;
+  }
+  if (!is_known_goal)
+  {
+    return;
+  }
+
+  cancelQueuedGoals(client_cancel_result_);
+  // A queued goal might have become active in the meantime, which is considered by cancelActiveGoal()
+  cancelActiveGoal(client_cancel_result_);
+  triggerMovementToHoldPosition();
+  ROS_DEBUG_NAMED(this->name_, "Canceling the goals because cancel callback received from actionlib.");
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::updateQueuedGoals(
+    const typename JointTrajectoryController::Trajectory& curr_traj, const ros::Time& uptime)
+{
+  if (curr_traj.empty())
+  {
+    return;  // LCOV_EXCL_LINE Trajectories of the controller always contain all joints
+  }
+  const auto& segments{ curr_traj.front() };
+  // The cursor was already moved to the current segment by isTrajectoryExecuted()
+  const auto segment_it{ rt_segment_cursors_.front().findSegment(segments, uptime.toSec()) };
+  if (segment_it == segments.end())
+  {
+    return;
+  }
+  const RealtimeGoalHandle* const previous_goal{ rt_segment_goal_ };
+  rt_segment_goal_ = segment_it->getGoalHandle().get();
+  if (!previous_goal || rt_segment_goal_ == previous_goal)
+  {
+    return;
+  }
+
+  // Without a preceding segment of the previous goal the trajectory was replaced, which is handled by the parent
+  auto first_segment_it{ segment_it };
+  while (first_segment_it != segments.begin() && std::prev(first_segment_it)->getGoalHandle().get() != previous_goal)
+  {
+    --first_segment_it;
+  }
+  if (first_segment_it == segments.begin())
+  {
+    return;
+  }
+
+  // The predecessor is finished, including goals whose trajectories were passed within a single cycle
+  const bool within_tolerance{ isStateWithinGoalTolerance(curr_traj, uptime) };
+  for (auto it = std::prev(first_segment_it); it != segment_it; ++it)
+  {
+    const RealtimeGoalHandlePtr& goal{ it->getGoalHandle() };
+    if (!goal || goal == std::next(it)->getGoalHandle())
+    {
+      continue;
+    }
+    if (within_tolerance)
+    {
+      goal->preallocated_result_->error_code = control_msgs::FollowJointTrajectoryResult::SUCCESSFUL;
+      goal->setSucceeded(goal->preallocated_result_);
+      continue;
+    }
+    goal->preallocated_result_->error_code = control_msgs::FollowJointTrajectoryResult::GOAL_TOLERANCE_VIOLATED;
+    goal->setAborted(goal->preallocated_result_);
+  }
+  executed_goal_.store(segment_it->getGoalHandle().get(), std::memory_order_release);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::isStateWithinGoalTolerance(
+    const typename JointTrajectoryController::Trajectory& curr_traj, const ros::Time& uptime)
+{
+  const auto& state_error{ JointTrajectoryController::state_error_ };
+  for (std::size_t i = 0; i < curr_traj.size(); ++i)
+  {
+    const auto segment_it{ rt_segment_cursors_[i].findSegment(curr_traj[i], uptime.toSec()) };
+    if (segment_it == curr_traj[i].end() || segment_it == curr_traj[i].begin())
+    {
+      continue;  // LCOV_EXCL_LINE Queued goals are always preceded by the segments of their predecessor
+    }
+    rt_joint_state_error_.position[0] = state_error.position[i];
+    rt_joint_state_error_.velocity[0] = state_error.velocity[i];
+    rt_joint_state_error_.acceleration[0] = state_error.acceleration[i];
+    if (!joint_trajectory_controller::checkStateTolerancePerJoint(
+            rt_joint_state_error_, std::prev(segment_it)->getTolerances().goal_state_tolerance))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::activateExecutedGoal()
+{
+  RealtimeGoalHandle* executed_goal{ executed_goal_.load(std::memory_order_acquire) };
+  if (!executed_goal)
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(goal_queue_mutex_);
+    const auto executed_goal_it{ std::find_if(
+        goal_queue_.begin(), goal_queue_.end(),
+        [executed_goal](const RealtimeGoalHandlePtr& queued_goal) { return queued_goal.get() == executed_goal; }) };
+    // Ignored if the goal was canceled meanwhile or no goal is active anymore, see runQueuedGoalsNonRealtime()
+    if (executed_goal_it != goal_queue_.end() && JointTrajectoryController::rt_active_goal_)
+    {
+      finished_goals_.push_back(JointTrajectoryController::rt_active_goal_);
+      finished_goals_.insert(finished_goals_.end(), goal_queue_.begin(), executed_goal_it);
+      JointTrajectoryController::rt_active_goal_ = *executed_goal_it;
+      goal_queue_.erase(goal_queue_.begin(), std::next(executed_goal_it));
+
+      // Only the tolerances of the new active goal and the remaining queued goals are still needed
+      const RealtimeGoalHandle* active_goal{ JointTrajectoryController::rt_active_goal_.get() };
+      velocity_path_tolerances_.erase(
+          std::remove_if(velocity_path_tolerances_.begin(), velocity_path_tolerances_.end(),
+                         [this, active_goal](const VelocityPathTolerances& tolerances) {
+                           return tolerances.goal != active_goal &&
+                                  std::none_of(goal_queue_.begin(), goal_queue_.end(),
+                                               [&tolerances](const RealtimeGoalHandlePtr& queued_goal) {
+                                                 return queued_goal.get() == tolerances.goal;
+                                               });
+                         }),
+          velocity_path_tolerances_.end());
+      publishVelocityPathTolerances();
+    }
+  }
+  // Keeps a goal started by the realtime thread in the meantime
+  executed_goal_.compare_exchange_strong(executed_goal, nullptr);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::cancelQueuedGoals(const ResultConstPtr& result)
+{
+  std::lock_guard<std::mutex> lock(goal_queue_mutex_);
+  for (const auto& queued_goal : goal_queue_)
+  {
+    goal_termination_worker_.requestCancel(queued_goal, result);
+  }
+  goal_queue_.clear();
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::runQueuedGoalsNonRealtime(
+    const ros::TimerEvent& event)
+{
+  std::vector<RealtimeGoalHandlePtr> finished_goals;
+  {
+    std::lock_guard<std::mutex> lock(active_goal_mutex_);
+    activateExecutedGoal();
+    std::lock_guard<std::mutex> queue_lock(goal_queue_mutex_);
+    if (!JointTrajectoryController::rt_active_goal_)
+    {
+      for (const auto& queued_goal : goal_queue_)
+      {
+        queued_goal->setAborted(predecessor_aborted_result_);
+      }
+      finished_goals_.insert(finished_goals_.end(), goal_queue_.begin(), goal_queue_.end());
+      goal_queue_.clear();
+    }
+    finished_goals.swap(finished_goals_);
+  }
+
+  // actionlib is called outside of the locks, otherwise the goal callbacks could deadlock
+  for (const auto& finished_goal : finished_goals)
+  {
+    finished_goal->runNonRealtime(event);
+  }
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::requestHold(HoldModeListener* const listener)
+{
+  if (mode_->stopEvent(listener))
+  {
+    cancelQueuedGoals(hold_result_);
+    cancelActiveGoal(hold_result_);
+    triggerMovementToHoldPosition();
+  }
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::holdGoalCB(HoldGoalHandle gh)
+{
+  const auto goal{ gh.getGoal() };
+  const double timeout{ goal->timeout.toSec() > 0.0 ? goal->timeout.toSec() : hold_timeout_ };
+  gh.setAccepted();
+
+  PendingHoldGoal pending_goal;
+  pending_goal.goal_handle = gh;
+  pending_goal.listener = std::make_shared<HoldModeListener>();
+  pending_goal.deadline = std::chrono::steady_clock::now() + toNanoseconds(timeout);
+  requestHold(pending_goal.listener.get());
+
+  std::lock_guard<std::mutex> lock(pending_hold_goals_mutex_);
+  pending_hold_goals_.push_back(pending_goal);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::holdCancelCB(HoldGoalHandle gh)
+{
+  {
+    std::lock_guard<std::mutex> lock(pending_hold_goals_mutex_);
+    const auto it{ std::find_if(
+        pending_hold_goals_.begin(), pending_hold_goals_.end(),
+        [&gh](const PendingHoldGoal& pending_goal) { return pending_goal.goal_handle == gh; }) };
+    if (it == pending_hold_goals_.end())
+    {
+      return;  // Already terminated
+    }
+    pending_hold_goals_.erase(it);
+  }
+
+  pilz_control::HoldResult result;
+  result.message = "Stopped waiting for the holding mode, the stop motion is not affected";
+  gh.setCanceled(result);
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::monitorHoldGoals(const ros::WallTimerEvent&)
+{
+  const bool running{ JointTrajectoryController::state_ == JointTrajectoryController::RUNNING };
+  const std::chrono::steady_clock::time_point now{ std::chrono::steady_clock::now() };
+  std::vector<HoldGoalHandle> succeeded_goals;
+  std::vector<HoldGoalHandle> aborted_goals;
+  std::vector<HoldGoalHandle> waiting_goals;
+  {
+    std::lock_guard<std::mutex> lock(pending_hold_goals_mutex_);
+    auto it{ pending_hold_goals_.begin() };
+    while (it != pending_hold_goals_.end())
+    {
+      if (it->listener->waitFor(std::chrono::nanoseconds::zero()))
+      {
+        succeeded_goals.push_back(it->goal_handle);
+      }
+      else if (!running || now >= it->deadline)
+      {
+        aborted_goals.push_back(it->goal_handle);
+      }
+      else
+      {
+        waiting_goals.push_back(it->goal_handle);
+        ++it;
+        continue;
+      }
+      it = pending_hold_goals_.erase(it);
+    }
+  }
+
+  // actionlib is called outside of the lock, otherwise the goal callbacks could deadlock
+  pilz_control::HoldResult result;
+  result.message = "Holding mode enabled";
+  for (auto& gh : succeeded_goals)
+  {
+    gh.setSucceeded(result);
+  }
+
+  result.message =
+      running ? "Stop motion did not finish in time" : "Controller stopped before the stop motion finished";
+  for (auto& gh : aborted_goals)
+  {
+    ROS_ERROR_STREAM_NAMED(this->name_, "Hold action aborted: " << result.message);
+    gh.setAborted(result);
+  }
+
+  if (waiting_goals.empty())
+  {
+    return;
+  }
+  pilz_control::HoldFeedback feedback;
+  feedback.remaining_stop_time = ros::Duration(getRemainingStopTime());
+  for (auto& gh : waiting_goals)
+  {
+    gh.publishFeedback(feedback);
+  }
+}
+
+template <class SegmentImpl, class HardwareInterface>
+double PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::getRemainingStopTime()
+{
+  TrajectoryPtr curr_traj_ptr;
+  JointTrajectoryController::curr_trajectory_box_.get(curr_traj_ptr);
+  if (!curr_traj_ptr || curr_traj_ptr->empty() || curr_traj_ptr->front().empty())
+  {
+    return 0.0;  // LCOV_EXCL_LINE The controller always holds a trajectory after its start
+  }
+  // All joints of a stop trajectory come to a standstill at the same time
+  const double uptime{ JointTrajectoryController::time_data_.readFromRT()->uptime.toSec() };
+  return std::max(0.0, curr_traj_ptr->front().back().endTime() - uptime);
 }
 
 template <class SegmentImpl, class HardwareInterface>
 bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::handleMonitorCartesianSpeedRequest(
     std_srvs::SetBool::Request& req, std_srvs::SetBool::Response& res)
 {
-  cartesian_speed_limit_ = req.data ? SPEED_LIMIT_ACTIVATED : SPEED_LIMIT_NOT_ACTIVATED;
+  cartesian_speed_monitoring_active_ = req.data;
   res.success = true;
   return true;
 }
 
+template <class SegmentImpl, class HardwareInterface>
+bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::handleReloadLimitsRequest(
+    std_srvs::TriggerRequest&, std_srvs::TriggerResponse& response)
+{
+  try
+  {
+    // Validated before the swap, such that the realtime thread never sees invalid limits
+    const ControllerLimits limits{ getLimits(controller_nh_, JointTrajectoryController::joint_names_) };
+    limits_buffer_.writeFromNonRT(limits);
+    std::lock_guard<std::mutex> lock(limits_mutex_);
+    limits_ = limits;
+  }
+  catch (const ros::InvalidParameterException& ex)
+  {
+    ROS_ERROR_STREAM_NAMED(this->name_, "Failed to reload the limits: " << ex.what());
+    response.message = std::string("Previous limits kept, since the new limits are invalid: ") + ex.what();
+    response.success = false;
+    return true;
+  }
+
+  ROS_INFO_STREAM_NAMED(this->name_, "Reloaded the limits.");
+  response.message = "Limits reloaded";
+  response.success = true;
+  return true;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::setSpeedOverride(
+    const double& speed_override, const double& cartesian_speed_limit)
+{
+  // Negated comparisons in order to reject NaN as well
+  if (!(speed_override >= 0.0 && speed_override <= 1.0) || !(cartesian_speed_limit > 0.0))
+  {
+    return false;
+  }
+
+  SpeedOverrideCommand command;
+  command.speed_override = speed_override;
+  command.cartesian_speed_limit = cartesian_speed_limit;
+  speed_override_buffer_.writeFromNonRT(command);
+  return true;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::speedOverrideCB(
+    const pilz_control::SpeedOverrideConstPtr& msg)
+{
+  if (!setSpeedOverride(msg->speed_override, msg->cartesian_speed_limit))
+  {
+    ROS_WARN_STREAM_NAMED(this->name_, "Ignored invalid speed override " << msg->speed_override
+                                                                         << " with cartesian speed limit "
+                                                                         << msg->cartesian_speed_limit
+                                                                         << "m/s. Expected a speed override in "
+                                                                            "[0, 1] and a positive limit.");
+  }
+}
+
+template <class SegmentImpl, class HardwareInterface>
+bool PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::setStreamingSetpoint(
+    const std::vector<double>& positions, const std::vector<double>& velocities, std::string* error_string)
+{
+  const auto reject = [error_string](const std::string& reason) {
+    if (error_string)
+    {
+      *error_string = reason;
+    }
+    return false;
+  };
+
+  if (!streaming_enabled_)
+  {
+    return reject("The streaming interface is disabled.");
+  }
+  if (mode_->getCurrentMode() != TrajProcessingMode::unhold)
+  {
+    return reject("Controller is not in unhold mode.");
+  }
+  if (JointTrajectoryController::rt_active_goal_)
+  {
+    return reject("A goal is executed.");
+  }
+
+  const std::size_t number_of_joints{ JointTrajectoryController::getNumberOfJoints() };
+  if (positions.size() != number_of_joints || (!velocities.empty() && velocities.size() != number_of_joints))
+  {
+    return reject("Expected " + std::to_string(number_of_joints) + " positions and optionally as many velocities.");
+  }
+
+  StreamingSetpoint setpoint;
+  setpoint.goal_update_count = goal_update_counter_.load();
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    setpoint.positions[i] = positions[i];
+    setpoint.velocities[i] = velocities.empty() ? 0.0 : velocities[i];
+    if (!std::isfinite(setpoint.positions[i]) || !std::isfinite(setpoint.velocities[i]))
+    {
+      return reject("Expected finite positions and velocities.");
+    }
+  }
+
+  if (!streaming_setpoints_.push(setpoint))
+  {
+    return reject("Setpoint queue is full.");
+  }
+  return true;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::streamingSetpointCB(
+    const trajectory_msgs::JointTrajectoryPointConstPtr& msg)
+{
+  std::string error_string;
+  if (!setStreamingSetpoint(msg->positions, msg->velocities, &error_string))
+  {
+    ROS_WARN_STREAM_THROTTLE_NAMED(1, this->name_, "Ignored streaming setpoint: " << error_string);
+  }
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::processStreamingSetpoints()
+{
+  // Only the latest setpoint is of interest
+  while (streaming_setpoints_.pop(rt_streaming_setpoint_))
+  {
+    rt_streaming_setpoint_pending_ = true;
+  }
+  if (!rt_streaming_setpoint_pending_)
+  {
+    return;
+  }
+  // The check of setStreamingSetpoint() is repeated, since a stop or a goal might have been triggered meanwhile
+  const uint64_t goal_update_count{ goal_update_counter_.load() };
+  if (mode_->getCurrentMode() != TrajProcessingMode::unhold || JointTrajectoryController::rt_active_goal_ ||
+      rt_streaming_setpoint_.goal_update_count != goal_update_count || goal_update_count % 2 != 0)
+  {
+    // Setpoints received before a stop or a goal are discarded
+    rt_streaming_setpoint_pending_ = false;
+    return;
+  }
+
+  // Pick a trajectory, which is neither executed nor read by another thread
+  const auto buffer_it{ std::find_if(streaming_trajectories_.begin(), streaming_trajectories_.end(),
+                                     [](const TrajectoryPtr& trajectory) { return trajectory.use_count() == 1; }) };
+  if (buffer_it == streaming_trajectories_.end())
+  {
+    return;  // LCOV_EXCL_LINE Retried in the next cycle
+  }
+  // Synchronizes with the release of the last foreign reference
+  std::atomic_thread_fence(std::memory_order_acquire);
+  Trajectory& streaming_traj{ **buffer_it };
+
+  TrajectoryPtr curr_traj_ptr;
+  JointTrajectoryController::curr_trajectory_box_.get(curr_traj_ptr);
+  const Trajectory& curr_traj{ *curr_traj_ptr };
+  const double start_time{ JointTrajectoryController::time_data_.readFromRT()->uptime.toSec() };
+  const double target_time{ start_time + streaming_setpoint_period_ };
+  const std::size_t number_of_joints{ streaming_traj.size() };
+
+  // Without further setpoints all joints come to rest at the same time, see JerkLimitedStopTrajectoryBuilder
+  double rest_duration{ MIN_STOP_DURATION };
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    const double velocity{ rt_streaming_setpoint_.velocities[i] };
+    const double max_acceleration{ rt_limits_->acceleration[i] };
+    const double max_jerk{ rt_limits_->jerk[i] };
+    if (velocity != 0.0)
+    {
+      rest_duration = std::max(rest_duration, std::isfinite(max_acceleration) || std::isfinite(max_jerk) ?
+                                                  getMinStopDuration(velocity, 0.0, max_acceleration, max_jerk) :
+                                                  JointTrajectoryController::stop_trajectory_duration_);
+    }
+  }
+
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    trajectory_interface::sample(curr_traj[i], start_time, streaming_start_state_);
+
+    const double position{ rt_streaming_setpoint_.positions[i] };
+    const double velocity{ rt_streaming_setpoint_.velocities[i] };
+    streaming_target_state_.position[0] = position;
+    streaming_target_state_.velocity[0] = velocity;
+    streaming_target_state_.acceleration[0] = 0.0;
+
+    // End position of the cubic velocity profile
+    streaming_rest_state_.position[0] = position + velocity * rest_duration / 2.0;
+    streaming_rest_state_.velocity[0] = 0.0;
+    streaming_rest_state_.acceleration[0] = 0.0;
+
+    streaming_traj[i][0].init(start_time, streaming_start_state_, target_time, streaming_target_state_);
+    streaming_traj[i][1].init(target_time, streaming_target_state_, target_time + rest_duration,
+                              streaming_rest_state_);
+  }
+
+  JointTrajectoryController::curr_trajectory_box_.set(*buffer_it);
+  rt_streaming_setpoint_pending_ = false;
+}
+
+template <class SegmentImpl, class HardwareInterface>
+inline double PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::getCartesianSpeedLimit() const
+{
+  return cartesian_speed_monitoring_active_.load(std::memory_order_relaxed) ?
+             std::min(rt_limits_->cartesian_speed, rt_speed_override_->cartesian_speed_limit) :
+             SPEED_LIMIT_NOT_ACTIVATED;
+}
+
 template <class SegmentImpl, class HardwareInterface>
 void PilzJointTrajectoryController<SegmentImpl, HardwareInterface>::trajectoryCommandCB(
     const JointTrajectoryConstPtr& /*msg*/)
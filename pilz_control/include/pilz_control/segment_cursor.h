@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PILZ_CONTROL_SEGMENT_CURSOR_H
+#define PILZ_CONTROL_SEGMENT_CURSOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace pilz_joint_trajectory_controller
+{
+//! @brief Number of segments the cursor advances linearly before it switches to a binary search.
+static constexpr std::size_t SEGMENT_CURSOR_MAX_LINEAR_STEPS{ 8 };
+
+/**
+ * @brief Finds the segment of a trajectory which is active at a given time, starting at the previously found segment.
+ *
+ * Since the time of the controller moves forward in small steps, the active segment is mostly the previously found one
+ * or one of its successors. In this case the search is amortized O(1) instead of O(log n) for a binary search over
+ * the whole trajectory. If the time jumps backwards or the trajectory is replaced, the cursor falls back to a binary
+ * search. The result is always the same as for trajectory_interface::findSegment().
+ *
+ * @tparam Segment Needs to provide startTime().
+ */
+template <class Segment>
+class SegmentCursor
+{
+public:
+  using Trajectory = std::vector<Segment>;
+  using ConstIterator = typename Trajectory::const_iterator;
+
+  /**
+   * @brief Find the last segment starting at or before the given time. Does not allocate memory.
+   *
+   * @return Iterator to the segment or trajectory.end() if the trajectory is empty or starts after the given time.
+   */
+  ConstIterator findSegment(const Trajectory& trajectory, const double& time);
+
+private:
+  //! @brief Index of the previously found segment.
+  std::size_t index_{ 0 };
+};
+
+template <class Segment>
+typename SegmentCursor<Segment>::ConstIterator SegmentCursor<Segment>::findSegment(const Trajectory& trajectory,
+                                                                                   const double& time)
+{
+  if (trajectory.empty() || time < trajectory.front().startTime())
+  {
+    return trajectory.end();
+  }
+
+  if (index_ >= trajectory.size() || time < trajectory[index_].startTime())
+  {
+    index_ = 0;  // Time jumped backwards or the trajectory was replaced
+  }
+
+  std::size_t steps{ 0 };
+  while (index_ + 1 < trajectory.size() && !(time < trajectory[index_ + 1].startTime()))
+  {
+    if (++steps > SEGMENT_CURSOR_MAX_LINEAR_STEPS)
+    {
+      const auto is_before_segment = [](const double& t, const Segment& segment) { return t < segment.startTime(); };
+      const auto next_it{ std::upper_bound(trajectory.begin() + static_cast<std::ptrdiff_t>(index_ + 1),
+                                           trajectory.end(), time, is_before_segment) };
+      index_ = static_cast<std::size_t>(next_it - trajectory.begin()) - 1;
+      break;
+    }
+    ++index_;
+  }
+  return trajectory.begin() + static_cast<std::ptrdiff_t>(index_);
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+#endif  // PILZ_CONTROL_SEGMENT_CURSOR_H
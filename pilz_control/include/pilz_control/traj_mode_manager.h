@@ -17,11 +17,12 @@
 #ifndef TRAJPROCESSINGMODEMANAGER_H
 #define TRAJPROCESSINGMODEMANAGER_H
 
-#include <list>
-#include <memory>
-#include <mutex>
-#include <condition_variable>
-#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <pilz_control/futex.h>
 
 namespace pilz_joint_trajectory_controller
 {
@@ -35,6 +36,16 @@ enum class TrajProcessingMode
   hold
 };
 
+// "Simple" linear state machine: (start with stopping in accordance to the controller)
+//  x ->  |->  stopping  ->  hold  ->  unhold ->|
+//        |<-               <-                <-|
+//! @brief Successor of each TrajProcessingMode, indexed by the underlying value of the mode.
+static constexpr TrajProcessingMode TRAJ_PROCESSING_MODE_TRANSITIONS[]{
+  TrajProcessingMode::stopping,  // unhold
+  TrajProcessingMode::hold,      // stopping
+  TrajProcessingMode::unhold,    // hold
+};
+
 /**
  * @brief Stores the TrajProcessingMode state machine and can be used to determine if a transition is valid.
  */
@@ -45,39 +56,54 @@ public:
    * @brief Returns true if a transition between the current_mode and the requested_mode exists,
    * otherwise false.
    */
-  bool isTransitionValid(const TrajProcessingMode& current_mode, const TrajProcessingMode& requested_mode) const;
-
-private:
-  // "Simple" linear state machine: (start with stopping in accordance to the controller)
-  //  x ->  |->  stopping  ->  hold  ->  unhold ->|
-  //        |<-               <-                <-|
-  const std::unordered_map<TrajProcessingMode, TrajProcessingMode> mode_machine_{
-    { TrajProcessingMode::stopping, TrajProcessingMode::hold },
-    { TrajProcessingMode::hold, TrajProcessingMode::unhold },
-    { TrajProcessingMode::unhold, TrajProcessingMode::stopping },
-  };
+  constexpr bool isTransitionValid(const TrajProcessingMode& current_mode,
+                                   const TrajProcessingMode& requested_mode) const;
 };
 
 /**
  * @brief Listener to wait for the hold mode to be reached.
+ *
+ * Once registered via TrajProcessingModeManager::stopEvent() the listener waits on the state word of the manager
+ * directly, hence reaching the hold mode does not need to visit any listener.
  */
 class HoldModeListener
 {
 public:
   void wait();
+  /**
+   * @brief Wait for the hold mode, but at most for the given timeout.
+   * @return True if the hold mode is reached, false on timeout.
+   */
+  bool waitFor(const std::chrono::nanoseconds& timeout);
   //! @brief Notify the listener that the hold mode is reached.
   void triggerListener();
 
 private:
-  std::mutex mutex_;
-  std::condition_variable cond_variable_;
-  bool cond_fulfilled_{ false };
+  friend class TrajProcessingModeManager;
+
+  //! @param deadline No deadline if nullptr.
+  bool waitUntil(const std::chrono::steady_clock::time_point* deadline);
+
+  //! @brief Wait for the next entry of the hold mode, after the given number of entries.
+  void listenTo(std::atomic<uint32_t>* manager_state, std::atomic<uint32_t>* number_of_waiting_listeners,
+                const uint32_t& number_of_hold_entries);
+  bool isHoldReached(const uint32_t& manager_state) const;
+
+private:
+  std::atomic<uint32_t> triggered_{ 0 };
+  std::atomic<uint32_t>* manager_state_{ nullptr };
+  std::atomic<uint32_t>* number_of_waiting_listeners_{ nullptr };
+  uint32_t number_of_hold_entries_{ 0 };
 };
 
 /**
  * @brief Encapsulates a state machine managing the current Trajectory-Processing-Mode.
  *
- * All public methods are mutually exclusive. Initial mode is stopping in accordance to the controller.
+ * The mode and the number of entries of the hold mode are packed into one atomic state word. Transitions are
+ * performed via compare-and-swap, hence all methods are lock-free and can be called from the realtime thread.
+ * Reading the current mode via getCurrentMode() and isHolding() is wait-free. Listeners block on the state word via
+ * a futex; reaching the hold mode only issues a (non-blocking) wakeup if a listener is waiting.
+ * Initial mode is stopping in accordance to the controller.
  */
 class TrajProcessingModeManager
 {
@@ -90,48 +116,137 @@ public:
   bool startEvent();
 
 public:
-  //! @brief Check if in state stopping or hold.
+  //! @brief Check if in state stopping or hold. Wait-free.
   bool isHolding();
+  //! @brief Wait-free.
   TrajProcessingMode getCurrentMode();
 
 private:
+  friend class HoldModeListener;
+
+  static constexpr unsigned int MODE_BITS{ 2 };
+  static constexpr uint32_t MODE_MASK{ (1U << MODE_BITS) - 1U };
+
+  static constexpr TrajProcessingMode getMode(const uint32_t& state);
+  static constexpr uint32_t getNumberOfHoldEntries(const uint32_t& state);
+  static constexpr uint32_t makeState(const TrajProcessingMode& mode, const uint32_t& number_of_hold_entries);
+
   /**
    * @brief Perform transition if possible.
+   * @param state Set to the state after the attempt.
    * @return True if transition was performed, otherwise false.
    */
-  bool switchTo(const TrajProcessingMode& mode);
-  void registerListener(HoldModeListener* const listener);
-  //! @brief Triggers all registered listeners whose target mode is reached.
-  void callListener();
+  bool switchTo(const TrajProcessingMode& mode, uint32_t& state);
 
 private:
   const TrajProcessingModeStateMachine mode_state_machine_{};
-  TrajProcessingMode current_mode_{ TrajProcessingMode::stopping };
-  std::list<HoldModeListener*> listener_;
-  //! @brief Used to make all public methods mutually exclusive in order to protect the member variables.
-  std::mutex mutex_;
+  std::atomic<uint32_t> state_{ makeState(TrajProcessingMode::stopping, 0) };
+  //! @brief Number of listeners blocked on state_, only if non-zero a wakeup is needed.
+  std::atomic<uint32_t> number_of_waiting_listeners_{ 0 };
 };
 
-inline bool TrajProcessingModeStateMachine::isTransitionValid(const TrajProcessingMode& current_mode,
-                                                              const TrajProcessingMode& requested_mode) const
+constexpr bool TrajProcessingModeStateMachine::isTransitionValid(const TrajProcessingMode& current_mode,
+                                                                 const TrajProcessingMode& requested_mode) const
 {
-  return mode_machine_.at(current_mode) == requested_mode;
+  return TRAJ_PROCESSING_MODE_TRANSITIONS[static_cast<std::size_t>(current_mode)] == requested_mode;
 }
 
+static_assert(TrajProcessingModeStateMachine{}.isTransitionValid(TrajProcessingMode::stopping,
+                                                                 TrajProcessingMode::hold) &&
+                  TrajProcessingModeStateMachine{}.isTransitionValid(TrajProcessingMode::hold,
+                                                                     TrajProcessingMode::unhold) &&
+                  TrajProcessingModeStateMachine{}.isTransitionValid(TrajProcessingMode::unhold,
+                                                                     TrajProcessingMode::stopping),
+              "Invalid transition table");
+
 inline void HoldModeListener::wait()
 {
-  std::unique_lock<std::mutex> lk(mutex_);
-  while (!cond_fulfilled_)
+  waitUntil(nullptr);
+}
+
+inline bool HoldModeListener::waitFor(const std::chrono::nanoseconds& timeout)
+{
+  const std::chrono::steady_clock::time_point deadline{ std::chrono::steady_clock::now() + timeout };
+  return waitUntil(&deadline);
+}
+
+inline bool HoldModeListener::waitUntil(const std::chrono::steady_clock::time_point* deadline)
+{
+  std::atomic<uint32_t>& word{ manager_state_ ? *manager_state_ : triggered_ };
+  // Registered before the state is read, such that a concurrent transition to hold either is seen or wakes us
+  if (number_of_waiting_listeners_)
+  {
+    number_of_waiting_listeners_->fetch_add(1);
+  }
+
+  bool hold_reached{ false };
+  while (true)
+  {
+    const uint32_t value{ word.load() };
+    hold_reached = triggered_.load() || (manager_state_ && isHoldReached(value));
+    if (hold_reached)
+    {
+      break;
+    }
+    if (!deadline)
+    {
+      futexWait(word, value);
+      continue;
+    }
+    const std::chrono::nanoseconds remaining_time{ *deadline - std::chrono::steady_clock::now() };
+    if (remaining_time <= std::chrono::nanoseconds::zero())
+    {
+      break;
+    }
+    futexWait(word, value, remaining_time);
+  }
+
+  if (number_of_waiting_listeners_)
   {
-    cond_variable_.wait(lk);
+    number_of_waiting_listeners_->fetch_sub(1);
   }
+  return hold_reached;
 }
 
 inline void HoldModeListener::triggerListener()
 {
-  std::lock_guard<std::mutex> lk(mutex_);
-  cond_fulfilled_ = true;
-  cond_variable_.notify_one();
+  triggered_.store(1);
+  futexWakeAll(triggered_);
+  if (manager_state_)
+  {
+    futexWakeAll(*manager_state_);
+  }
+}
+
+inline void HoldModeListener::listenTo(std::atomic<uint32_t>* manager_state,
+                                       std::atomic<uint32_t>* number_of_waiting_listeners,
+                                       const uint32_t& number_of_hold_entries)
+{
+  manager_state_ = manager_state;
+  number_of_waiting_listeners_ = number_of_waiting_listeners;
+  number_of_hold_entries_ = number_of_hold_entries;
+}
+
+inline bool HoldModeListener::isHoldReached(const uint32_t& manager_state) const
+{
+  // Any further entry of the hold mode counts, even if the mode was already left again
+  return TrajProcessingModeManager::getNumberOfHoldEntries(manager_state) != number_of_hold_entries_;
+}
+
+constexpr TrajProcessingMode TrajProcessingModeManager::getMode(const uint32_t& state)
+{
+  return static_cast<TrajProcessingMode>(state & MODE_MASK);
+}
+
+constexpr uint32_t TrajProcessingModeManager::getNumberOfHoldEntries(const uint32_t& state)
+{
+  return state >> MODE_BITS;
+}
+
+constexpr uint32_t TrajProcessingModeManager::makeState(const TrajProcessingMode& mode,
+                                                        const uint32_t& number_of_hold_entries)
+{
+  return (number_of_hold_entries << MODE_BITS) | static_cast<uint32_t>(mode);
 }
 
 inline bool TrajProcessingModeManager::isHolding()
@@ -142,71 +257,58 @@ inline bool TrajProcessingModeManager::isHolding()
 
 inline TrajProcessingMode TrajProcessingModeManager::getCurrentMode()
 {
-  std::lock_guard<std::mutex> lk(mutex_);
-  return current_mode_;
+  return getMode(state_.load());
 }
 
-inline bool TrajProcessingModeManager::switchTo(const TrajProcessingMode& mode)
+inline bool TrajProcessingModeManager::switchTo(const TrajProcessingMode& mode, uint32_t& state)
 {
-  if (mode_state_machine_.isTransitionValid(current_mode_, mode))
+  state = state_.load();
+  uint32_t new_state;
+  do
   {
-    current_mode_ = mode;
-    return true;
-  }
-  return false;
-}
-
-inline void TrajProcessingModeManager::registerListener(HoldModeListener* const listener)
-{
-  listener_.emplace_back(listener);
+    if (!mode_state_machine_.isTransitionValid(getMode(state), mode))
+    {
+      return false;
+    }
+    const uint32_t number_of_hold_entries{ getNumberOfHoldEntries(state) +
+                                           (mode == TrajProcessingMode::hold ? 1U : 0U) };
+    new_state = makeState(mode, number_of_hold_entries);
+  } while (!state_.compare_exchange_weak(state, new_state));
+  state = new_state;
+  return true;
 }
 
-inline void TrajProcessingModeManager::callListener()
+inline bool TrajProcessingModeManager::stopEvent(HoldModeListener* const listener)
 {
-  std::list<HoldModeListener*>::iterator it = listener_.begin();
-  while (it != listener_.end())
+  uint32_t state;
+  bool transition_performed{ switchTo(TrajProcessingMode::stopping, state) };
+  if (listener)
   {
-    HoldModeListener* listener{ (*it) };
-    if (listener)
+    if (getMode(state) == TrajProcessingMode::hold)
     {
       listener->triggerListener();
-      it = listener_.erase(it);
     }
     else
     {
-      ++it;
+      listener->listenTo(&state_, &number_of_waiting_listeners_, getNumberOfHoldEntries(state));
     }
   }
-}
-
-inline bool TrajProcessingModeManager::stopEvent(HoldModeListener* const listener)
-{
-  std::lock_guard<std::mutex> lk(mutex_);
-  bool transition_performed{ switchTo(TrajProcessingMode::stopping) };
-  registerListener(listener);
-  if (current_mode_ == TrajProcessingMode::hold)
-  {
-    callListener();
-  }
   return transition_performed;
 }
 
 inline bool TrajProcessingModeManager::startEvent()
 {
-  std::lock_guard<std::mutex> lk(mutex_);
-  if (current_mode_ == TrajProcessingMode::unhold || switchTo(TrajProcessingMode::unhold))
-  {
-    return true;
-  }
-  return false;
+  uint32_t state;
+  return switchTo(TrajProcessingMode::unhold, state) || getMode(state) == TrajProcessingMode::unhold;
 }
 
 inline void TrajProcessingModeManager::stopMotionFinishedEvent()
 {
-  std::lock_guard<std::mutex> lk(mutex_);
-  if (switchTo(TrajProcessingMode::hold))
+  uint32_t state;
+  // Sequentially consistent, such that either a waiting listener is seen here or the listener sees the new state
+  if (switchTo(TrajProcessingMode::hold, state) && number_of_waiting_listeners_.load() > 0)
   {
-    callListener();
+    futexWakeAll(state_);
   }
 }
 
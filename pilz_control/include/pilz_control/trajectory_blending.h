@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PILZ_CONTROL_TRAJECTORY_BLENDING_H
+#define PILZ_CONTROL_TRAJECTORY_BLENDING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <trajectory_interface/trajectory_interface.h>
+
+namespace pilz_joint_trajectory_controller
+{
+//! @brief Step size[s] for searching the start of a blend on the current trajectory.
+static constexpr double BLEND_SEARCH_STEP{ 1e-3 };
+//! @brief Step size[s] for sampling a blend segment during the check of the limits.
+static constexpr double BLEND_CHECK_STEP{ 1e-3 };
+
+/**
+ * @brief Get the joint space distance between the given positions and the positions of a trajectory at a time.
+ *
+ * @param state Preallocated single joint state, used for sampling.
+ */
+template <class Segment>
+double getJointSpaceDistance(const std::vector<std::vector<Segment>>& trajectory, const typename Segment::Time& time,
+                             const std::vector<double>& positions, typename Segment::State& state)
+{
+  double squared_distance{ 0.0 };
+  for (std::size_t i = 0; i < trajectory.size(); ++i)
+  {
+    trajectory_interface::sample(trajectory[i], time, state);
+    const double delta{ state.position[0] - positions[i] };
+    squared_distance += delta * delta;
+  }
+  return std::sqrt(squared_distance);
+}
+
+/**
+ * @brief Check the acceleration and jerk of a single joint segment, sampled with BLEND_CHECK_STEP.
+ *
+ * @param state Preallocated single joint state, used for sampling.
+ *
+ * @returns False if a limit is exceeded, otherwise true.
+ */
+template <class Segment>
+bool isSegmentWithinLimits(const Segment& segment, const double& max_acceleration, const double& max_jerk,
+                           typename Segment::State& state)
+{
+  segment.sample(segment.startTime(), state);
+  double previous_acceleration{ state.acceleration[0] };
+  typename Segment::Time previous_time{ segment.startTime() };
+  while (previous_time < segment.endTime())
+  {
+    const typename Segment::Time time{ std::min(previous_time + BLEND_CHECK_STEP, segment.endTime()) };
+    segment.sample(time, state);
+    if (std::abs(state.acceleration[0]) > max_acceleration ||
+        std::abs(state.acceleration[0] - previous_acceleration) > max_jerk * (time - previous_time))
+    {
+      return false;
+    }
+    previous_acceleration = state.acceleration[0];
+    previous_time = time;
+  }
+  return true;
+}
+
+/**
+ * @brief Append the trajectory of a queued goal to the currently executed trajectory.
+ *
+ * Without blending the robot executes both trajectories one after the other. With a positive blend radius the parts
+ * of both trajectories within this (joint space) distance around the junction are replaced by a single segment. The
+ * segment keeps position, velocity and acceleration continuous and takes as long as the replaced parts, hence the
+ * robot passes the junction without stopping. The blend ends at a segment boundary of the appended trajectory and
+ * belongs to the appended goal.
+ *
+ * If the blend segment exceeds the acceleration or jerk limit of a joint, the trajectories are appended without
+ * blending. A smaller radius does not help in general, since the blend still ends at the same segment boundary.
+ *
+ * @param curr_traj Currently executed trajectory. Segments which ended before the given time are dropped.
+ * @param next_traj Trajectory to append, must start at the end of curr_traj.
+ * @param time Current time of the trajectories.
+ * @param blend_radius Radius[rad] around the junction which is blended. Zero disables blending.
+ * @param min_blend_start_time The blend does not start before this time, since the preceding part of curr_traj might
+ * already be executed once the result is in use.
+ * @param max_accelerations Acceleration limit of each joint, infinity if the joint has no limit.
+ * @param max_jerks Jerk limit of each joint, infinity if the joint has no limit.
+ *
+ * @return The combined trajectory. Empty if a trajectory is empty or the number of joints differs.
+ */
+template <class Segment>
+std::vector<std::vector<Segment>> appendTrajectory(const std::vector<std::vector<Segment>>& curr_traj,
+                                                   const std::vector<std::vector<Segment>>& next_traj,
+                                                   const typename Segment::Time& time, const double& blend_radius,
+                                                   const typename Segment::Time& min_blend_start_time,
+                                                   const std::vector<double>& max_accelerations,
+                                                   const std::vector<double>& max_jerks)
+{
+  using Trajectory = std::vector<std::vector<Segment>>;
+  const std::size_t number_of_joints{ curr_traj.size() };
+  if (number_of_joints == 0 || next_traj.size() != number_of_joints ||
+      max_accelerations.size() != number_of_joints || max_jerks.size() != number_of_joints)
+  {
+    return Trajectory();
+  }
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    if (curr_traj[i].empty() || next_traj[i].empty())
+    {
+      return Trajectory();
+    }
+  }
+
+  typename Segment::State state(1);
+  const typename Segment::Time junction_time{ curr_traj.front().back().endTime() };
+  std::vector<double> junction_positions(number_of_joints);
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    trajectory_interface::sample(curr_traj[i], junction_time, state);
+    junction_positions[i] = state.position[0];
+  }
+
+  // Search backwards for the last time outside of the blend radius
+  typename Segment::Time blend_start_time{ junction_time };
+  if (blend_radius > 0.0)
+  {
+    while (blend_start_time > min_blend_start_time &&
+           getJointSpaceDistance(curr_traj, blend_start_time, junction_positions, state) < blend_radius)
+    {
+      blend_start_time -= BLEND_SEARCH_STEP;
+    }
+    blend_start_time = std::max(blend_start_time, min_blend_start_time);
+  }
+
+  // The blend ends with the first segment of next_traj which leaves the blend radius
+  std::size_t blend_end_index{ 0 };
+  const std::vector<Segment>& next_segments{ next_traj.front() };
+  while (blend_end_index + 1 < next_segments.size() &&
+         getJointSpaceDistance(next_traj, next_segments[blend_end_index].endTime(), junction_positions, state) <
+             blend_radius)
+  {
+    ++blend_end_index;
+  }
+  const typename Segment::Time blend_end_time{ next_segments[blend_end_index].endTime() };
+
+  std::vector<Segment> blend_segments;
+  if (blend_start_time < junction_time)
+  {
+    typename Segment::State blend_start_state(1);
+    typename Segment::State blend_end_state(1);
+    blend_segments.reserve(number_of_joints);
+    for (std::size_t i = 0; i < number_of_joints; ++i)
+    {
+      trajectory_interface::sample(curr_traj[i], blend_start_time, blend_start_state);
+      trajectory_interface::sample(next_traj[i], blend_end_time, blend_end_state);
+      blend_segments.emplace_back(blend_start_time, blend_start_state, blend_end_time, blend_end_state);
+      if (!isSegmentWithinLimits(blend_segments.back(), max_accelerations[i], max_jerks[i], state))
+      {
+        blend_segments.clear();
+        break;
+      }
+    }
+  }
+  const bool blending{ !blend_segments.empty() };
+
+  Trajectory result(number_of_joints);
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    auto first_segment{ trajectory_interface::findSegment(curr_traj[i], time) };
+    if (first_segment == curr_traj[i].end())
+    {
+      first_segment = curr_traj[i].begin();
+    }
+    for (auto it = first_segment; it != curr_traj[i].end() && (!blending || it->startTime() < blend_start_time); ++it)
+    {
+      result[i].push_back(*it);
+    }
+
+    if (!blending)
+    {
+      result[i].insert(result[i].end(), next_traj[i].begin(), next_traj[i].end());
+      continue;
+    }
+
+    Segment& blend_segment{ blend_segments[i] };
+    blend_segment.setGoalHandle(next_traj[i].front().getGoalHandle());
+    blend_segment.setTolerances(next_traj[i].front().getTolerances());
+    result[i].push_back(blend_segment);
+    result[i].insert(result[i].end(), next_traj[i].begin() + blend_end_index + 1, next_traj[i].end());
+  }
+  return result;
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+#endif  // PILZ_CONTROL_TRAJECTORY_BLENDING_H
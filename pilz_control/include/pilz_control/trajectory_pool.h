@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PILZ_CONTROL_TRAJECTORY_POOL_H
+#define PILZ_CONTROL_TRAJECTORY_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace pilz_joint_trajectory_controller
+{
+/**
+ * @brief Fixed number of slots, which keep a reference to the trajectories handed over to the realtime thread.
+ *
+ * A slot is free again as soon as the pool holds the only reference to it, i.e. after the realtime thread switched to
+ * another trajectory. The trajectory stored in a slot is only released once the slot is reused, hence the realtime
+ * thread never frees the memory of a trajectory.
+ *
+ * The pool does not avoid the allocations needed for building a trajectory. If all slots are in use, acquire() falls
+ * back to a trajectory which is not part of the pool.
+ */
+template <class Segment>
+class TrajectoryPool
+{
+public:
+  using Trajectory = std::vector<std::vector<Segment>>;
+  using TrajectoryPtr = std::shared_ptr<Trajectory>;
+
+  //! @param capacity Number of slots.
+  explicit TrajectoryPool(const std::size_t& capacity);
+
+  /**
+   * @brief Move the trajectory into a free slot. Not realtime-safe.
+   *
+   * The trajectory previously stored in the slot is released here.
+   */
+  TrajectoryPtr acquire(Trajectory&& trajectory);
+
+  std::size_t getCapacity() const;
+
+  //! @brief Number of trajectories allocated outside of the pool, because all slots were in use.
+  std::size_t getNumberOfFallbackAllocations() const;
+
+private:
+  std::vector<TrajectoryPtr> trajectories_;
+  //! @brief Slots are searched round-robin, starting behind the last acquired slot.
+  std::size_t next_index_{ 0 };
+  std::size_t number_of_fallback_allocations_{ 0 };
+  mutable std::mutex mutex_;
+};
+
+template <class Segment>
+TrajectoryPool<Segment>::TrajectoryPool(const std::size_t& capacity)
+{
+  trajectories_.reserve(capacity);
+  for (std::size_t k = 0; k < capacity; ++k)
+  {
+    trajectories_.push_back(TrajectoryPtr(new Trajectory()));
+  }
+}
+
+template <class Segment>
+typename TrajectoryPool<Segment>::TrajectoryPtr TrajectoryPool<Segment>::acquire(Trajectory&& trajectory)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::size_t k = 0; k < trajectories_.size(); ++k)
+  {
+    const std::size_t index{ (next_index_ + k) % trajectories_.size() };
+    // Further references can only be obtained via the pool, hence a free slot stays free
+    if (trajectories_[index].use_count() != 1)
+    {
+      continue;
+    }
+    // Synchronizes with the release of the last foreign reference
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    next_index_ = (index + 1) % trajectories_.size();
+    *trajectories_[index] = std::move(trajectory);
+    return trajectories_[index];
+  }
+
+  ++number_of_fallback_allocations_;
+  return TrajectoryPtr(new Trajectory(std::move(trajectory)));
+}
+
+template <class Segment>
+std::size_t TrajectoryPool<Segment>::getCapacity() const
+{
+  return trajectories_.size();
+}
+
+template <class Segment>
+std::size_t TrajectoryPool<Segment>::getNumberOfFallbackAllocations() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return number_of_fallback_allocations_;
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+#endif  // PILZ_CONTROL_TRAJECTORY_POOL_H
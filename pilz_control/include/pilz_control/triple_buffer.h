@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PILZ_CONTROL_TRIPLE_BUFFER_H
+#define PILZ_CONTROL_TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace pilz_control
+{
+/**
+ * @brief Passes values from non-realtime threads to a single realtime thread, which reads them wait-free.
+ *
+ * The reader and the writers each own one of three buffers, the third buffer is the exchange buffer. A writer fills
+ * its buffer and swaps it with the exchange buffer. The reader swaps its buffer with the exchange buffer only if it
+ * contains a newer value. Both swaps are a single atomic exchange, so the reader never waits and never observes a
+ * partially written value. In contrast to realtime_tools::RealtimeBuffer the reader always gets the latest value.
+ *
+ * @note The reference returned by readFromRT() stays valid until the next call of readFromRT().
+ */
+template <class T>
+class TripleBuffer
+{
+public:
+  explicit TripleBuffer(const T& initial_value = T());
+
+  /**
+   * @brief Publish a new value. Not realtime-safe, since the copy may allocate memory.
+   *
+   * Can be called from several threads, the writers are serialized.
+   */
+  void writeFromNonRT(const T& value);
+
+  /**
+   * @brief Get the latest value. Wait-free.
+   *
+   * @note Only a single thread (the realtime thread) is allowed to call this function.
+   */
+  const T& readFromRT();
+
+private:
+  static constexpr uint8_t INDEX_MASK{ 0x3 };
+  //! @brief Marks the exchange buffer to contain a value, which was not read yet.
+  static constexpr uint8_t NEW_VALUE_FLAG{ 0x4 };
+
+  std::array<T, 3> buffers_;
+  //! @brief Index of the exchange buffer, combined with the NEW_VALUE_FLAG.
+  std::atomic<uint8_t> exchange_index_{ 1 };
+  //! @brief Only accessed by the reader.
+  uint8_t read_index_{ 0 };
+  //! @brief Only accessed while holding writer_mutex_.
+  uint8_t write_index_{ 2 };
+  std::mutex writer_mutex_;
+};
+
+template <class T>
+TripleBuffer<T>::TripleBuffer(const T& initial_value) : buffers_{ { initial_value, initial_value, initial_value } }
+{
+}
+
+template <class T>
+void TripleBuffer<T>::writeFromNonRT(const T& value)
+{
+  std::lock_guard<std::mutex> lock(writer_mutex_);
+  buffers_[write_index_] = value;
+  const uint8_t previous_exchange_index{ exchange_index_.exchange(write_index_ | NEW_VALUE_FLAG,
+                                                                  std::memory_order_acq_rel) };
+  write_index_ = previous_exchange_index & INDEX_MASK;
+}
+
+template <class T>
+const T& TripleBuffer<T>::readFromRT()
+{
+  if (exchange_index_.load(std::memory_order_relaxed) & NEW_VALUE_FLAG)
+  {
+    read_index_ = exchange_index_.exchange(read_index_, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+  return buffers_[read_index_];
+}
+
+}  // namespace pilz_control
+
+#endif  // PILZ_CONTROL_TRIPLE_BUFFER_H
@@ -15,6 +15,8 @@
  */
 
 #include <algorithm>
+#include <sstream>
+#include <stdexcept>
 
 #include <pilz_control/cartesian_speed_monitor.h>
 #include <pilz_control/cartesian_speed_monitor_exception.h>
@@ -65,8 +67,20 @@ CartesianSpeedMonitor::CartesianSpeedMonitor(const std::vector<std::string>& joi
   }
 }
 
-void CartesianSpeedMonitor::init()
+void CartesianSpeedMonitor::init(const unsigned int& number_of_sub_samples,
+                                 const std::vector<MonitoredPoint>& additional_points)
 {
+  if (number_of_sub_samples == 0)
+  {
+    throw std::invalid_argument("The number of sub-samples of the cartesian speed monitoring must be positive.");
+  }
+
+  monitored_links_.clear();
+  point_speed_limits_.clear();
+  point_descriptions_.clear();
+  std::vector<const robot_model::LinkModel*> point_links;
+  std::vector<Eigen::Vector3d> point_offsets;
+
   const auto& links = kinematic_model_->getLinkModels();
 
   for (const auto& link : links)
@@ -74,12 +88,47 @@ void CartesianSpeedMonitor::init()
     if (!hasOnlyFixedParentJoints(link) && !isEndEffectorLink(link, kinematic_model_))
     {
       monitored_links_.push_back(link);
+      point_links.push_back(link);
+      point_offsets.push_back(Eigen::Vector3d::Zero());
+      point_speed_limits_.push_back(std::numeric_limits<double>::infinity());
+      point_descriptions_.push_back("link '" + link->getName() + "'");
       ROS_INFO_STREAM("Monitoring cartesian speed of link " << link->getName());
     }
   }
 
-  state_current_.reset(new robot_state::RobotState(kinematic_model_));
-  state_desired_.reset(new robot_state::RobotState(kinematic_model_));
+  for (const auto& point : additional_points)
+  {
+    if (!kinematic_model_->hasLinkModel(point.link_name))
+    {
+      throw UnknownLinkName(point.link_name);
+    }
+    if (!(point.speed_limit > 0.0))
+    {
+      throw std::invalid_argument("The speed limit of a monitored point must be positive.");
+    }
+
+    std::ostringstream description;
+    description << "point (" << point.offset.x() << ", " << point.offset.y() << ", " << point.offset.z()
+                << ") of link '" << point.link_name << "'";
+
+    point_links.push_back(kinematic_model_->getLinkModel(point.link_name));
+    point_offsets.push_back(point.offset);
+    point_speed_limits_.push_back(point.speed_limit);
+    point_descriptions_.push_back(description.str());
+    ROS_INFO_STREAM("Monitoring cartesian speed of " << description.str() << " with speed limit " << point.speed_limit
+                                                     << "m/s");
+  }
+
+  kinematic_chain_.reset(new KinematicChainEvaluator(kinematic_model_, joint_names_, point_links, point_offsets));
+  kinematic_chain_->reserveSamples(number_of_sub_samples);
+
+  for (auto& positions : point_positions_)
+  {
+    positions.resize(point_links.size());
+  }
+  sample_positions_.assign(number_of_sub_samples, PointPositions(point_links.size()));
+  cached_position_.resize(joint_names_.size());
+  cache_valid_ = false;
 }
 
 bool CartesianSpeedMonitor::cartesianSpeedIsBelowLimit(const std::vector<double>& current_position,
@@ -91,25 +140,78 @@ bool CartesianSpeedMonitor::cartesianSpeedIsBelowLimit(const std::vector<double>
     return true;
   }
 
-  state_current_->setVariablePositions(joint_names_, current_position);
-  state_desired_->setVariablePositions(joint_names_, desired_position);
-
-  state_current_->updateLinkTransforms();
-  state_desired_->updateLinkTransforms();
+  const std::size_t current_slot{ cached_slot_ };
+  const std::size_t desired_slot{ 1 - cached_slot_ };
 
-  for (const auto& link : monitored_links_)
+  if (!cache_valid_ || current_position != cached_position_)
   {
-    const auto& speed = linkSpeed(state_current_.get(), state_desired_.get(), link, time_delta);
+    kinematic_chain_->computePointPositions(current_position, point_positions_[current_slot]);
+  }
+  kinematic_chain_->computeInterpolatedPointPositions(current_position, desired_position, sample_positions_);
+
+  const PointPositions& desired_positions{ sample_positions_.back() };
+  PointPositions& cached_positions{ point_positions_[desired_slot] };
+  std::copy(desired_positions.x.begin(), desired_positions.x.end(), cached_positions.x.begin());
+  std::copy(desired_positions.y.begin(), desired_positions.y.end(), cached_positions.y.begin());
+  std::copy(desired_positions.z.begin(), desired_positions.z.end(), cached_positions.z.begin());
+  std::copy(desired_position.begin(), desired_position.end(), cached_position_.begin());
+  cached_slot_ = desired_slot;
+  cache_valid_ = true;
 
-    if (speed > speed_limit)
+  const double sample_time_delta{ time_delta / static_cast<double>(sample_positions_.size()) };
+  const PointPositions* previous_positions{ &point_positions_[current_slot] };
+  for (const auto& positions : sample_positions_)
+  {
+    if (!pointSpeedsAreBelowLimit(*previous_positions, positions, sample_time_delta, speed_limit))
     {
-      ROS_ERROR_STREAM("Speed limit violated by link '" << link->getName() << "'! Desired Speed: " << speed
-                                                        << "m/s, speed_limit: " << speed_limit << "m/s");
+      reportSpeedLimitViolation(*previous_positions, positions, sample_time_delta, speed_limit);
       return false;
     }
+    previous_positions = &positions;
   }
 
   return true;
 }
 
+bool CartesianSpeedMonitor::pointSpeedsAreBelowLimit(const PointPositions& start, const PointPositions& end,
+                                                     const double& time_delta, const double& speed_limit) const
+{
+  const std::size_t number_of_points{ point_speed_limits_.size() };
+  const double* x0{ start.x.data() };
+  const double* y0{ start.y.data() };
+  const double* z0{ start.z.data() };
+  const double* x1{ end.x.data() };
+  const double* y1{ end.y.data() };
+  const double* z1{ end.z.data() };
+  const double* limits{ point_speed_limits_.data() };
+
+  // Compare squared distances and count the violations without branching, such that the loop can be vectorized
+  std::size_t number_of_violations{ 0 };
+  for (std::size_t i = 0; i < number_of_points; ++i)
+  {
+    const double dx{ x1[i] - x0[i] };
+    const double dy{ y1[i] - y0[i] };
+    const double dz{ z1[i] - z0[i] };
+    const double max_distance{ std::min(limits[i], speed_limit) * time_delta };
+    number_of_violations += (dx * dx + dy * dy + dz * dz > max_distance * max_distance) ? 1 : 0;
+  }
+  return number_of_violations == 0;
+}
+
+void CartesianSpeedMonitor::reportSpeedLimitViolation(const PointPositions& start, const PointPositions& end,
+                                                      const double& time_delta, const double& speed_limit) const
+{
+  for (std::size_t i = 0; i < point_speed_limits_.size(); ++i)
+  {
+    const auto speed{ (end.getPosition(i) - start.getPosition(i)).norm() / time_delta };
+    const auto limit{ std::min(point_speed_limits_[i], speed_limit) };
+    if (speed > limit)
+    {
+      ROS_ERROR_STREAM("Speed limit violated by " << point_descriptions_[i] << "! Desired Speed: " << speed
+                                                  << "m/s, speed_limit: " << limit << "m/s");
+      return;
+    }
+  }
+}
+
 }  // namespace pilz_control
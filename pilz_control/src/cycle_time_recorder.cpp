@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pilz_control/cycle_time_recorder.h>
+
+#include <algorithm>
+
+namespace pilz_control
+{
+CycleTimeRecorder::CycleTimeRecorder(const double& overrun_threshold, const std::size_t& buffer_size,
+                                     const std::vector<double>& bin_upper_bounds)
+  : overrun_threshold_(overrun_threshold)
+  , bin_upper_bounds_(bin_upper_bounds)
+  , samples_(buffer_size)
+  , extension_histogram_(bin_upper_bounds.size() + 1, 0)
+  , speed_monitoring_histogram_(bin_upper_bounds.size() + 1, 0)
+  , stop_histogram_(bin_upper_bounds.size() + 1, 0)
+{
+}
+
+bool CycleTimeRecorder::record(const CycleTimeSample& sample)
+{
+  if (!samples_.push(sample))
+  {
+    dropped_cycles_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void CycleTimeRecorder::processSamples()
+{
+  samples_.consume_all([this](const CycleTimeSample& sample) { accumulate(sample); });
+}
+
+void CycleTimeRecorder::accumulate(const CycleTimeSample& sample)
+{
+  ++cycles_;
+  if (sample.extension_duration > overrun_threshold_)
+  {
+    ++overruns_;
+  }
+  if (sample.extension_duration > worst_cycle_.extension_duration)
+  {
+    worst_cycle_ = sample;
+  }
+
+  addToHistogram(sample.extension_duration, extension_histogram_);
+  addToHistogram(sample.speed_monitoring_duration, speed_monitoring_histogram_);
+  if (sample.stop_duration > 0.0)
+  {
+    addToHistogram(sample.stop_duration, stop_histogram_);
+  }
+}
+
+void CycleTimeRecorder::addToHistogram(const double& duration, std::vector<uint64_t>& histogram) const
+{
+  const auto bin{ std::lower_bound(bin_upper_bounds_.begin(), bin_upper_bounds_.end(), duration) -
+                  bin_upper_bounds_.begin() };
+  ++histogram[static_cast<std::size_t>(bin)];
+}
+
+void CycleTimeRecorder::getStatistics(CycleTimeStatistics& statistics) const
+{
+  statistics.cycles = cycles_;
+  statistics.overruns = overruns_;
+  statistics.overrun_threshold = overrun_threshold_;
+  statistics.dropped_cycles = dropped_cycles_.load(std::memory_order_relaxed);
+
+  statistics.bin_upper_bounds = bin_upper_bounds_;
+  statistics.extension_histogram = extension_histogram_;
+  statistics.speed_monitoring_histogram = speed_monitoring_histogram_;
+  statistics.stop_histogram = stop_histogram_;
+
+  statistics.worst_extension_duration = worst_cycle_.extension_duration;
+  statistics.worst_cycle_uptime = worst_cycle_.uptime;
+}
+
+}  // namespace pilz_control
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pilz_control/futex.h>
+
+#include <cerrno>
+#include <climits>
+#include <system_error>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace pilz_joint_trajectory_controller
+{
+// The kernel operates on the address of the atomic, which therefore has to be a plain lock-free 32 bit word
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex requires a 32 bit word");
+static_assert(alignof(std::atomic<uint32_t>) == alignof(uint32_t), "Futex requires a 4 byte aligned word");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "Futex requires a lock-free word");
+
+static long futex(std::atomic<uint32_t>& word, const int& operation, const uint32_t& value,
+                  const struct timespec* timeout)
+{
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), operation, value, timeout, nullptr, 0);
+}
+
+static void checkWaitResult(const long& result)
+{
+  // EAGAIN: The value differed from the expected value, EINTR: Interrupted by a signal, ETIMEDOUT: Timeout expired
+  if (result == -1 && errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT)
+  {
+    throw std::system_error(errno, std::generic_category(), "Failed to wait on futex");
+  }
+}
+
+void futexWait(std::atomic<uint32_t>& word, const uint32_t& expected)
+{
+  checkWaitResult(futex(word, FUTEX_WAIT_PRIVATE, expected, nullptr));
+}
+
+void futexWait(std::atomic<uint32_t>& word, const uint32_t& expected, const std::chrono::nanoseconds& timeout)
+{
+  // A negative timeout is rejected by the kernel
+  if (timeout <= std::chrono::nanoseconds::zero())
+  {
+    return;
+  }
+  const std::chrono::seconds seconds{ std::chrono::duration_cast<std::chrono::seconds>(timeout) };
+  struct timespec relative_timeout;
+  relative_timeout.tv_sec = static_cast<time_t>(seconds.count());
+  relative_timeout.tv_nsec = static_cast<long>((timeout - seconds).count());
+  checkWaitResult(futex(word, FUTEX_WAIT_PRIVATE, expected, &relative_timeout));
+}
+
+void futexWakeAll(std::atomic<uint32_t>& word)
+{
+  if (futex(word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr) == -1)
+  {
+    throw std::system_error(errno, std::generic_category(), "Failed to wake futex waiters");
+  }
+}
+
+}  // namespace pilz_joint_trajectory_controller
@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+
+#include <Eigen/Geometry>
+
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+
+#include <pilz_control/cartesian_speed_monitor_exception.h>
+#include <pilz_control/kinematic_chain_evaluator.h>
+
+namespace pilz_control
+{
+constexpr std::size_t KinematicChainEvaluator::FRAME_SIZE;
+constexpr std::size_t KinematicChainEvaluator::AXIS_SIZE;
+
+namespace
+{
+//! @brief Store an isometry as frame (3x3 rotation in row-major order followed by the translation).
+void toFrame(const Eigen::Isometry3d& transform, double* frame)
+{
+  for (std::size_t row = 0; row < 3; ++row)
+  {
+    for (std::size_t col = 0; col < 3; ++col)
+    {
+      frame[3 * row + col] = transform.linear()(row, col);
+    }
+    frame[9 + row] = transform.translation()(row);
+  }
+}
+
+//! @brief result = lhs * rhs
+inline void multiplyFrames(const double* lhs, const double* rhs, double* result)
+{
+  for (std::size_t row = 0; row < 3; ++row)
+  {
+    const double* l{ lhs + 3 * row };
+    for (std::size_t col = 0; col < 3; ++col)
+    {
+      result[3 * row + col] = l[0] * rhs[col] + l[1] * rhs[3 + col] + l[2] * rhs[6 + col];
+    }
+    result[9 + row] = l[0] * rhs[9] + l[1] * rhs[10] + l[2] * rhs[11] + lhs[9 + row];
+  }
+}
+
+//! @brief Rotate the frame about the given (normalized) axis, i.e. frame = frame * Rot(axis, angle).
+inline void rotateFrame(const double* axis, const double& angle, double* frame)
+{
+  const double c{ std::cos(angle) };
+  const double s{ std::sin(angle) };
+  const double v{ 1.0 - c };
+  const double x{ axis[0] };
+  const double y{ axis[1] };
+  const double z{ axis[2] };
+
+  const double rot[9]{ x * x * v + c,     x * y * v - z * s, x * z * v + y * s,
+                       y * x * v + z * s, y * y * v + c,     y * z * v - x * s,
+                       z * x * v - y * s, z * y * v + x * s, z * z * v + c };
+
+  for (std::size_t row = 0; row < 3; ++row)
+  {
+    const double f0{ frame[3 * row] };
+    const double f1{ frame[3 * row + 1] };
+    const double f2{ frame[3 * row + 2] };
+    for (std::size_t col = 0; col < 3; ++col)
+    {
+      frame[3 * row + col] = f0 * rot[col] + f1 * rot[3 + col] + f2 * rot[6 + col];
+    }
+  }
+}
+
+//! @brief Translate the frame along the given axis, i.e. frame = frame * Trans(axis * distance).
+inline void translateFrame(const double* axis, const double& distance, double* frame)
+{
+  for (std::size_t row = 0; row < 3; ++row)
+  {
+    frame[9 + row] +=
+        distance * (frame[3 * row] * axis[0] + frame[3 * row + 1] * axis[1] + frame[3 * row + 2] * axis[2]);
+  }
+}
+
+//! @brief Compute the global position of a point given by its offset in the frame.
+inline void transformPoint(const double* frame, const double* offset, double& x, double& y, double& z)
+{
+  x = frame[0] * offset[0] + frame[1] * offset[1] + frame[2] * offset[2] + frame[9];
+  y = frame[3] * offset[0] + frame[4] * offset[1] + frame[5] * offset[2] + frame[10];
+  z = frame[6] * offset[0] + frame[7] * offset[1] + frame[8] * offset[2] + frame[11];
+}
+
+//! @brief Batched version of multiplyFrames() for n samples. The rhs is the same for all samples.
+inline void multiplyBatchFrames(const double* lhs, const double* rhs, const std::size_t& n, double* result)
+{
+  for (std::size_t row = 0; row < 3; ++row)
+  {
+    const double* l0{ lhs + (3 * row) * n };
+    const double* l1{ lhs + (3 * row + 1) * n };
+    const double* l2{ lhs + (3 * row + 2) * n };
+    for (std::size_t col = 0; col < 3; ++col)
+    {
+      double* r{ result + (3 * row + col) * n };
+      for (std::size_t s = 0; s < n; ++s)
+      {
+        r[s] = l0[s] * rhs[col] + l1[s] * rhs[3 + col] + l2[s] * rhs[6 + col];
+      }
+    }
+    const double* t{ lhs + (9 + row) * n };
+    double* r{ result + (9 + row) * n };
+    for (std::size_t s = 0; s < n; ++s)
+    {
+      r[s] = l0[s] * rhs[9] + l1[s] * rhs[10] + l2[s] * rhs[11] + t[s];
+    }
+  }
+}
+
+//! @brief Batched version of rotateFrame() for n samples with individual angles.
+inline void rotateBatchFrames(const double* axis, const double* angles, const std::size_t& n, double* frames)
+{
+  const double x{ axis[0] };
+  const double y{ axis[1] };
+  const double z{ axis[2] };
+  for (std::size_t s = 0; s < n; ++s)
+  {
+    const double c{ std::cos(angles[s]) };
+    const double sn{ std::sin(angles[s]) };
+    const double v{ 1.0 - c };
+    const double rot[9]{ x * x * v + c,      x * y * v - z * sn, x * z * v + y * sn,
+                         y * x * v + z * sn, y * y * v + c,      y * z * v - x * sn,
+                         z * x * v - y * sn, z * y * v + x * sn, z * z * v + c };
+    for (std::size_t row = 0; row < 3; ++row)
+    {
+      const double f0{ frames[(3 * row) * n + s] };
+      const double f1{ frames[(3 * row + 1) * n + s] };
+      const double f2{ frames[(3 * row + 2) * n + s] };
+      for (std::size_t col = 0; col < 3; ++col)
+      {
+        frames[(3 * row + col) * n + s] = f0 * rot[col] + f1 * rot[3 + col] + f2 * rot[6 + col];
+      }
+    }
+  }
+}
+
+//! @brief Batched version of translateFrame() for n samples with individual distances.
+inline void translateBatchFrames(const double* axis, const double* distances, const std::size_t& n, double* frames)
+{
+  for (std::size_t row = 0; row < 3; ++row)
+  {
+    const double* f0{ frames + (3 * row) * n };
+    const double* f1{ frames + (3 * row + 1) * n };
+    const double* f2{ frames + (3 * row + 2) * n };
+    double* t{ frames + (9 + row) * n };
+    for (std::size_t s = 0; s < n; ++s)
+    {
+      t[s] += distances[s] * (f0[s] * axis[0] + f1[s] * axis[1] + f2[s] * axis[2]);
+    }
+  }
+}
+
+}  // namespace
+
+KinematicChainEvaluator::KinematicChainEvaluator(const robot_model::RobotModelConstPtr& kinematic_model,
+                                                 const std::vector<std::string>& joint_names,
+                                                 const std::vector<const robot_model::LinkModel*>& links,
+                                                 const std::vector<Eigen::Vector3d>& offsets)
+{
+  if (!offsets.empty() && offsets.size() != links.size())
+  {
+    throw std::invalid_argument("The number of point offsets does not match the number of links.");
+  }
+
+  std::map<std::string, int> position_index_of_joint;
+  for (std::size_t i = 0; i < joint_names.size(); ++i)
+  {
+    if (!kinematic_model->hasJointModel(joint_names[i]))
+    {
+      throw RobotModelVariableNamesMismatch();
+    }
+    position_index_of_joint[joint_names[i]] = static_cast<int>(i);
+  }
+
+  // Collect all links needed to compute the requested links
+  std::vector<bool> is_needed(kinematic_model->getLinkModelCount(), false);
+  for (const auto& link : links)
+  {
+    auto needed_link{ link };
+    while (needed_link != nullptr && !is_needed[needed_link->getLinkIndex()])
+    {
+      is_needed[needed_link->getLinkIndex()] = true;
+      needed_link = needed_link->getParentLinkModel();
+    }
+  }
+
+  // The links of the robot model are ordered such that parents precede their children
+  std::vector<int> frame_index_of_link(kinematic_model->getLinkModelCount(), -1);
+  std::vector<double> default_positions(kinematic_model->getVariableCount());
+  kinematic_model->getVariableDefaultPositions(default_positions.data());
+
+  for (const auto& link : kinematic_model->getLinkModels())
+  {
+    if (!is_needed[link->getLinkIndex()])
+    {
+      continue;
+    }
+    frame_index_of_link[link->getLinkIndex()] = static_cast<int>(parent_.size());
+
+    const auto parent_link{ link->getParentLinkModel() };
+    parent_.push_back(parent_link ? frame_index_of_link[parent_link->getLinkIndex()] : -1);
+
+    const auto joint{ link->getParentJointModel() };
+    const auto controlling_joint{ joint->getMimic() ? joint->getMimic() : joint };
+    const auto position_index_it{ position_index_of_joint.find(controlling_joint->getName()) };
+
+    Eigen::Isometry3d offset{ link->getJointOriginTransform() };
+    if (position_index_it == position_index_of_joint.end())
+    {
+      // Not controlled, therefore the joint is considered to be fixed at its default position
+      if (joint->getVariableCount() > 0)
+      {
+        Eigen::Isometry3d joint_transform;
+        joint->computeTransform(default_positions.data() + joint->getFirstVariableIndex(), joint_transform);
+        offset = offset * joint_transform;
+      }
+      joint_type_.push_back(JointType::fixed);
+      axis_.insert(axis_.end(), AXIS_SIZE, 0.0);
+      position_index_.push_back(-1);
+      position_factor_.push_back(0.0);
+      position_offset_.push_back(0.0);
+    }
+    else
+    {
+      Eigen::Vector3d axis;
+      if (joint->getType() == robot_model::JointModel::REVOLUTE)
+      {
+        joint_type_.push_back(JointType::revolute);
+        axis = static_cast<const robot_model::RevoluteJointModel*>(joint)->getAxis();
+      }
+      else if (joint->getType() == robot_model::JointModel::PRISMATIC)
+      {
+        joint_type_.push_back(JointType::prismatic);
+        axis = static_cast<const robot_model::PrismaticJointModel*>(joint)->getAxis();
+      }
+      else
+      {
+        throw UnsupportedJointType(joint->getName());
+      }
+      axis_.insert(axis_.end(), axis.data(), axis.data() + AXIS_SIZE);
+      position_index_.push_back(position_index_it->second);
+      position_factor_.push_back(joint->getMimic() ? joint->getMimicFactor() : 1.0);
+      position_offset_.push_back(joint->getMimic() ? joint->getMimicOffset() : 0.0);
+    }
+
+    offset_.resize(offset_.size() + FRAME_SIZE);
+    toFrame(offset, &offset_[offset_.size() - FRAME_SIZE]);
+  }
+
+  for (std::size_t i = 0; i < links.size(); ++i)
+  {
+    point_frame_index_.push_back(static_cast<std::size_t>(frame_index_of_link[links[i]->getLinkIndex()]));
+    const Eigen::Vector3d offset{ offsets.empty() ? Eigen::Vector3d::Zero() : offsets[i] };
+    point_offset_.insert(point_offset_.end(), offset.data(), offset.data() + AXIS_SIZE);
+  }
+
+  frames_.resize(parent_.size() * FRAME_SIZE);
+}
+
+void KinematicChainEvaluator::computeFrames(const std::vector<double>& position)
+{
+  for (std::size_t i = 0; i < parent_.size(); ++i)
+  {
+    double* frame{ &frames_[i * FRAME_SIZE] };
+    const double* offset{ &offset_[i * FRAME_SIZE] };
+    if (parent_[i] < 0)
+    {
+      std::copy(offset, offset + FRAME_SIZE, frame);
+    }
+    else
+    {
+      multiplyFrames(&frames_[static_cast<std::size_t>(parent_[i]) * FRAME_SIZE], offset, frame);
+    }
+
+    if (joint_type_[i] == JointType::fixed)
+    {
+      continue;
+    }
+
+    const double joint_value{ position_factor_[i] * position[static_cast<std::size_t>(position_index_[i])] +
+                              position_offset_[i] };
+    if (joint_type_[i] == JointType::revolute)
+    {
+      rotateFrame(&axis_[i * AXIS_SIZE], joint_value, frame);
+    }
+    else
+    {
+      translateFrame(&axis_[i * AXIS_SIZE], joint_value, frame);
+    }
+  }
+}
+
+void KinematicChainEvaluator::computePointPositions(const std::vector<double>& position, PointPositions& points)
+{
+  computeFrames(position);
+  for (std::size_t i = 0; i < point_frame_index_.size(); ++i)
+  {
+    transformPoint(&frames_[point_frame_index_[i] * FRAME_SIZE], &point_offset_[i * AXIS_SIZE], points.x[i],
+                   points.y[i], points.z[i]);
+  }
+}
+
+void KinematicChainEvaluator::reserveSamples(const std::size_t& number_of_samples)
+{
+  batch_frames_.resize(parent_.size() * FRAME_SIZE * number_of_samples);
+  batch_joint_values_.resize(number_of_samples);
+}
+
+void KinematicChainEvaluator::computeBatchFrames(const std::vector<double>& start, const std::vector<double>& end,
+                                                 const std::size_t& n)
+{
+  if (batch_joint_values_.size() < n)
+  {
+    reserveSamples(n);
+  }
+
+  for (std::size_t i = 0; i < parent_.size(); ++i)
+  {
+    double* frames{ &batch_frames_[i * FRAME_SIZE * n] };
+    const double* offset{ &offset_[i * FRAME_SIZE] };
+    if (parent_[i] < 0)
+    {
+      for (std::size_t c = 0; c < FRAME_SIZE; ++c)
+      {
+        std::fill(frames + c * n, frames + (c + 1) * n, offset[c]);
+      }
+    }
+    else
+    {
+      multiplyBatchFrames(&batch_frames_[static_cast<std::size_t>(parent_[i]) * FRAME_SIZE * n], offset, n, frames);
+    }
+
+    if (joint_type_[i] == JointType::fixed)
+    {
+      continue;
+    }
+
+    const std::size_t position_index{ static_cast<std::size_t>(position_index_[i]) };
+    const double start_value{ start[position_index] };
+    const double delta{ end[position_index] - start_value };
+    for (std::size_t s = 0; s + 1 < n; ++s)
+    {
+      batch_joint_values_[s] = start_value + delta * static_cast<double>(s + 1) / static_cast<double>(n);
+    }
+    batch_joint_values_[n - 1] = end[position_index];
+    for (std::size_t s = 0; s < n; ++s)
+    {
+      batch_joint_values_[s] = position_factor_[i] * batch_joint_values_[s] + position_offset_[i];
+    }
+
+    if (joint_type_[i] == JointType::revolute)
+    {
+      rotateBatchFrames(&axis_[i * AXIS_SIZE], batch_joint_values_.data(), n, frames);
+    }
+    else
+    {
+      translateBatchFrames(&axis_[i * AXIS_SIZE], batch_joint_values_.data(), n, frames);
+    }
+  }
+}
+
+void KinematicChainEvaluator::computeInterpolatedPointPositions(const std::vector<double>& start,
+                                                                const std::vector<double>& end,
+                                                                std::vector<PointPositions>& samples)
+{
+  const std::size_t n{ samples.size() };
+  if (n == 0)
+  {
+    return;
+  }
+
+  computeBatchFrames(start, end, n);
+  for (std::size_t i = 0; i < point_frame_index_.size(); ++i)
+  {
+    const double* frames{ &batch_frames_[point_frame_index_[i] * FRAME_SIZE * n] };
+    const double* offset{ &point_offset_[i * AXIS_SIZE] };
+    for (std::size_t s = 0; s < n; ++s)
+    {
+      samples[s].x[i] = frames[0 * n + s] * offset[0] + frames[1 * n + s] * offset[1] + frames[2 * n + s] * offset[2] +
+                        frames[9 * n + s];
+      samples[s].y[i] = frames[3 * n + s] * offset[0] + frames[4 * n + s] * offset[1] + frames[5 * n + s] * offset[2] +
+                        frames[10 * n + s];
+      samples[s].z[i] = frames[6 * n + s] * offset[0] + frames[7 * n + s] * offset[1] + frames[8 * n + s] * offset[2] +
+                        frames[11 * n + s];
+    }
+  }
+}
+
+}  // namespace pilz_control
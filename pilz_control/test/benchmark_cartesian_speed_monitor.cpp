@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ * @brief Benchmark of the cartesian speed monitoring for the PRBT model.
+ *
+ * The model is loaded from the parameter server, see benchmark_cartesian_speed_monitor.launch, which loads the robot
+ * description of prbt_support. The cartesian speed monitoring has to fit into a per-cycle budget of 50 µs. For each
+ * number of sub-samples the cycles exceeding the budget are reported, and the benchmark fails if the 99th percentile
+ * of the cycle times exceeds the budget. BM_RobotStateTwoPasses resembles the former implementation (two complete
+ * forward kinematics passes per cycle) for comparison.
+ *
+ * Run: roslaunch pilz_control benchmark_cartesian_speed_monitor.launch
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <ros/ros.h>
+
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_state/robot_state.h>
+
+#include <pilz_control/cartesian_speed_monitor.h>
+
+namespace pilz_control_benchmark
+{
+static const std::string ROBOT_DESCRIPTION_PARAM_NAME{ "robot_description" };
+
+static constexpr double CYCLE_TIME{ 0.001 };
+static constexpr double MOTION_AMPLITUDE{ 1.0 };
+static constexpr double MOTION_FREQUENCY{ 0.5 };
+//! Chosen high enough to avoid logging of speed limit violations.
+static constexpr double SPEED_LIMIT{ 100.0 };
+
+//! Max time[s] the cartesian speed monitoring may take per control cycle.
+static constexpr double CYCLE_TIME_BUDGET{ 50e-6 };
+static constexpr double BUDGET_PERCENTILE{ 0.99 };
+static constexpr double SEC_TO_USEC{ 1e6 };
+
+using Clock = std::chrono::steady_clock;
+
+//! Set if a benchmark exceeded the per-cycle budget, determines the exit code.
+static bool budget_exceeded{ false };
+
+static std::vector<double> positionAtCycle(const std::size_t& number_of_joints, const std::size_t& cycle)
+{
+  std::vector<double> position(number_of_joints);
+  for (std::size_t i = 0; i < number_of_joints; ++i)
+  {
+    position[i] = MOTION_AMPLITUDE * std::sin(2.0 * M_PI * MOTION_FREQUENCY * CYCLE_TIME * cycle + i);
+  }
+  return position;
+}
+
+//! @brief Precompute the positions of consecutive cycles in order to exclude them from the measurement.
+static std::vector<std::vector<double>> generateCycles(const std::size_t& number_of_joints)
+{
+  const std::size_t number_of_cycles{ static_cast<std::size_t>(1.0 / (MOTION_FREQUENCY * CYCLE_TIME)) };
+  std::vector<std::vector<double>> cycles;
+  for (std::size_t cycle = 0; cycle < number_of_cycles; ++cycle)
+  {
+    cycles.push_back(positionAtCycle(number_of_joints, cycle));
+  }
+  return cycles;
+}
+
+//! @brief Two complete forward kinematics passes per cycle, as done by the former implementation.
+static void BM_RobotStateTwoPasses(benchmark::State& state, const moveit::core::RobotModelConstPtr& model)
+{
+  const auto& joint_names{ model->getVariableNames() };
+  const auto cycles{ generateCycles(joint_names.size()) };
+
+  robot_state::RobotState state_current(model);
+  robot_state::RobotState state_desired(model);
+  state_current.setToDefaultValues();
+  state_desired.setToDefaultValues();
+
+  std::size_t cycle{ 1 };
+  for (auto _ : state)
+  {
+    state_current.setVariablePositions(joint_names, cycles[cycle - 1]);
+    state_desired.setVariablePositions(joint_names, cycles[cycle]);
+    state_current.updateLinkTransforms();
+    state_desired.updateLinkTransforms();
+
+    double max_distance{ 0.0 };
+    for (const auto& link : model->getLinkModels())
+    {
+      const double distance{ (state_desired.getGlobalLinkTransform(link).translation() -
+                              state_current.getGlobalLinkTransform(link).translation())
+                                 .norm() };
+      max_distance = std::max(max_distance, distance);
+    }
+    benchmark::DoNotOptimize(max_distance);
+
+    cycle = cycle + 1 < cycles.size() ? cycle + 1 : 1;
+  }
+}
+
+/**
+ * @brief Consecutive cycles of the cartesian speed monitoring. The argument is the number of sub-samples.
+ *
+ * Each cycle is timed individually in order to compare the cycle times with the budget.
+ */
+static void BM_CartesianSpeedMonitor(benchmark::State& state, const moveit::core::RobotModelConstPtr& model)
+{
+  const auto& joint_names{ model->getVariableNames() };
+  const auto cycles{ generateCycles(joint_names.size()) };
+
+  pilz_control::CartesianSpeedMonitor monitor(joint_names, model);
+  monitor.init(static_cast<unsigned int>(state.range(0)));
+
+  std::vector<double> cycle_times;
+  cycle_times.reserve(static_cast<std::size_t>(state.max_iterations));
+  std::size_t cycle{ 1 };
+  for (auto _ : state)
+  {
+    const auto start{ Clock::now() };
+    benchmark::DoNotOptimize(
+        monitor.cartesianSpeedIsBelowLimit(cycles[cycle - 1], cycles[cycle], CYCLE_TIME, SPEED_LIMIT));
+    const double cycle_time{ std::chrono::duration<double>(Clock::now() - start).count() };
+    state.SetIterationTime(cycle_time);
+    cycle_times.push_back(cycle_time);
+    cycle = cycle + 1 < cycles.size() ? cycle + 1 : 1;
+  }
+  if (cycle_times.empty())
+  {
+    return;
+  }
+
+  std::sort(cycle_times.begin(), cycle_times.end());
+  const double percentile_cycle_time{
+    cycle_times[static_cast<std::size_t>(BUDGET_PERCENTILE * static_cast<double>(cycle_times.size() - 1))]
+  };
+  state.counters["p99_us"] = SEC_TO_USEC * percentile_cycle_time;
+  state.counters["max_us"] = SEC_TO_USEC * cycle_times.back();
+  state.counters["over_budget_cycles"] = static_cast<double>(
+      cycle_times.end() - std::upper_bound(cycle_times.begin(), cycle_times.end(), CYCLE_TIME_BUDGET));
+  if (percentile_cycle_time > CYCLE_TIME_BUDGET)
+  {
+    budget_exceeded = true;
+    state.SkipWithError("99th percentile of the cycle times exceeds the budget of 50us.");
+  }
+}
+
+}  // namespace pilz_control_benchmark
+
+int main(int argc, char** argv)
+{
+  using namespace pilz_control_benchmark;
+
+  ros::init(argc, argv, "benchmark_cartesian_speed_monitor");
+  ros::NodeHandle nh;
+
+  robot_model_loader::RobotModelLoader model_loader(ROBOT_DESCRIPTION_PARAM_NAME, false);
+  const moveit::core::RobotModelConstPtr model{ model_loader.getModel() };
+  if (!model)
+  {
+    ROS_ERROR_STREAM("Failed to load the robot model from " << ROBOT_DESCRIPTION_PARAM_NAME << ".");
+    return EXIT_FAILURE;
+  }
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RegisterBenchmark("BM_RobotStateTwoPasses", BM_RobotStateTwoPasses, model)
+      ->Unit(benchmark::kMicrosecond);
+  benchmark::RegisterBenchmark("BM_CartesianSpeedMonitor", BM_CartesianSpeedMonitor, model)
+      ->Arg(1)
+      ->Arg(2)
+      ->Arg(4)
+      ->Arg(8)
+      ->UseManualTime()
+      ->Unit(benchmark::kMicrosecond);
+  benchmark::RunSpecifiedBenchmarks();
+  return budget_exceeded ? EXIT_FAILURE : EXIT_SUCCESS;
+}
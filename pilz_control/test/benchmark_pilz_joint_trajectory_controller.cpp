@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ * @brief Benchmark of the control cycle of the PilzJointTrajectoryController.
+ *
+ * The controller is driven by the RobotDriverMock with simulated time while executing a synthetic trajectory. For
+ * each cycle the latency of the complete update is measured as well as the latencies of the joint acceleration check,
+ * the cartesian speed check and the lookahead check. The median, the 99th percentile and the maximum of each latency
+ * are reported as counters (in µs).
+ *
+ * Run: roslaunch pilz_control benchmark_pilz_joint_trajectory_controller.launch
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <ros/ros.h>
+
+#include <hardware_interface/joint_command_interface.h>
+#include <trajectory_interface/quintic_spline_segment.h>
+#include <trajectory_msgs/JointTrajectory.h>
+
+#include <pilz_control/pilz_joint_trajectory_controller.h>
+#include <pilz_control/pilz_joint_trajectory_controller_impl.h>
+
+#include "pjtc_manager_mock.h"
+#include "pjtc_test_helper.h"
+#include "robot_driver_mock.h"
+
+namespace pilz_joint_trajectory_controller_benchmark
+{
+static const std::string CONTROLLER_NAMESPACE{ "/controller_ns" };
+
+static constexpr double CYCLE_TIME_SEC{ 0.001 };
+static constexpr std::size_t NUMBER_OF_CYCLES{ 20000 };
+
+static constexpr double TRAJECTORY_DURATION_SEC{ 5.0 };
+static constexpr double TRAJECTORY_POINT_PERIOD_SEC{ 0.05 };
+//! Chosen such that neither the acceleration limit nor the cartesian speed limit is violated.
+static constexpr double MOTION_AMPLITUDE{ 0.02 };
+static constexpr double MOTION_FREQUENCY{ 1.0 };
+
+static constexpr double SEC_TO_USEC{ 1e6 };
+
+using HWInterface = hardware_interface::PositionJointInterface;
+using Segment = trajectory_interface::QuinticSplineSegment<double>;
+using Controller = pilz_joint_trajectory_controller::PilzJointTrajectoryController<Segment, HWInterface>;
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(const Clock::time_point& start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}  // namespace pilz_joint_trajectory_controller_benchmark
+
+namespace pilz_joint_trajectory_controller
+{
+/**
+ * @brief Measures the execution times of the checks performed by the controller in the last control cycle.
+ *
+ * The checks only depend on the desired states, the period and the current trajectory, which do not change until the
+ * next cycle. Hence they are repeated after the cycle with the same inputs.
+ */
+class ControllerCheckProbe
+{
+public:
+  using Controller = pilz_joint_trajectory_controller_benchmark::Controller;
+
+  explicit ControllerCheckProbe(Controller& controller);
+
+  //! @brief Discard all measurements and preallocate the memory for the given number of cycles.
+  void resetMeasurements(const std::size_t& number_of_cycles);
+
+  //! @brief Start the execution of a trajectory without an action goal.
+  bool sendTrajectory(const trajectory_msgs::JointTrajectoryConstPtr& trajectory);
+
+  //! @brief Measure the checks of the last cycle. Must be called between two cycles.
+  void measureChecks();
+
+public:
+  std::vector<double> acceleration_check_durations_;
+  std::vector<double> cartesian_speed_check_durations_;
+  std::vector<double> lookahead_check_durations_;
+
+private:
+  Controller& controller_;
+};
+
+ControllerCheckProbe::ControllerCheckProbe(Controller& controller) : controller_(controller)
+{
+}
+
+void ControllerCheckProbe::resetMeasurements(const std::size_t& number_of_cycles)
+{
+  for (auto durations : { &acceleration_check_durations_, &cartesian_speed_check_durations_,
+                          &lookahead_check_durations_ })
+  {
+    durations->clear();
+    durations->reserve(number_of_cycles);
+  }
+}
+
+bool ControllerCheckProbe::sendTrajectory(const trajectory_msgs::JointTrajectoryConstPtr& trajectory)
+{
+  return controller_.updateTrajectoryCommand(trajectory, Controller::RealtimeGoalHandlePtr());
+}
+
+void ControllerCheckProbe::measureChecks()
+{
+  using pilz_joint_trajectory_controller_benchmark::secondsSince;
+  using pilz_joint_trajectory_controller_benchmark::Clock;
+
+  const auto* time_data{ controller_.time_data_.readFromRT() };
+  Controller::TrajectoryPtr curr_traj_ptr;
+  controller_.curr_trajectory_box_.get(curr_traj_ptr);
+
+  auto start{ Clock::now() };
+  controller_.isPlannedJointAccelerationOK(time_data->period);
+  acceleration_check_durations_.push_back(secondsSince(start));
+
+  start = Clock::now();
+  controller_.isPlannedCartesianVelocityOK(time_data->period);
+  cartesian_speed_check_durations_.push_back(secondsSince(start));
+
+  start = Clock::now();
+  controller_.isLookaheadOK(*curr_traj_ptr, time_data->uptime);
+  lookahead_check_durations_.push_back(secondsSince(start));
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+namespace pilz_joint_trajectory_controller_benchmark
+{
+using Manager = pilz_joint_trajectory_controller_test::PJTCManagerMock<Segment, HWInterface>;
+using RobotDriver = pilz_joint_trajectory_controller_test::RobotDriverMock<Manager>;
+
+/**
+ * @brief Generate a smooth periodic motion of all joints starting at rest in the given positions.
+ */
+static trajectory_msgs::JointTrajectoryConstPtr generateTrajectory(const std::vector<double>& start_positions)
+{
+  trajectory_msgs::JointTrajectoryPtr trajectory{ new trajectory_msgs::JointTrajectory() };
+  trajectory->joint_names = std::vector<std::string>(JOINT_NAMES.begin(), JOINT_NAMES.end());
+
+  const double omega{ 2.0 * M_PI * MOTION_FREQUENCY };
+  const auto number_of_points{ static_cast<std::size_t>(std::lround(TRAJECTORY_DURATION_SEC /
+                                                                     TRAJECTORY_POINT_PERIOD_SEC)) };
+  for (std::size_t k = 1; k <= number_of_points; ++k)
+  {
+    const double t{ static_cast<double>(k) * TRAJECTORY_POINT_PERIOD_SEC };
+    trajectory_msgs::JointTrajectoryPoint point;
+    point.time_from_start = ros::Duration(t);
+    for (const auto& start_position : start_positions)
+    {
+      point.positions.push_back(start_position + MOTION_AMPLITUDE * (1.0 - std::cos(omega * t)));
+      point.velocities.push_back(MOTION_AMPLITUDE * omega * std::sin(omega * t));
+      point.accelerations.push_back(MOTION_AMPLITUDE * omega * omega * std::cos(omega * t));
+    }
+    trajectory->points.push_back(point);
+  }
+  return trajectory;
+}
+
+/**
+ * @brief Add median, 99th percentile and maximum of the durations[s] as counters[µs] with the given prefix.
+ */
+static void addLatencyCounters(benchmark::State& state, const std::string& prefix, std::vector<double> durations)
+{
+  if (durations.empty())
+  {
+    return;
+  }
+  std::sort(durations.begin(), durations.end());
+  const auto percentile = [&durations](const double& fraction) {
+    const auto index{ static_cast<std::size_t>(fraction * static_cast<double>(durations.size() - 1)) };
+    return SEC_TO_USEC * durations[index];
+  };
+  state.counters[prefix + "_p50_us"] = percentile(0.5);
+  state.counters[prefix + "_p99_us"] = percentile(0.99);
+  state.counters[prefix + "_max_us"] = SEC_TO_USEC * durations.back();
+}
+
+//! @brief Control cycles during trajectory execution. The argument (de-)activates the lookahead.
+static void BM_ControlCycle(benchmark::State& state)
+{
+  using namespace pilz_joint_trajectory_controller_test;
+
+  setControllerParameters(CONTROLLER_NAMESPACE);
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  controller_nh.setParam(LOOKAHEAD_ENABLED_PARAMETER, state.range(0) != 0);
+  startSimTime();
+
+  RobotDriver robot_driver{ CONTROLLER_NAMESPACE };
+  if (!performFullControllerStartup(&robot_driver))
+  {
+    state.SkipWithError("Failed to start the controller.");
+    return;
+  }
+  pilz_joint_trajectory_controller::ControllerCheckProbe probe{ *robot_driver.getManager()->controller_ };
+  const auto trajectory{ generateTrajectory(robot_driver.getJointPositions()) };
+
+  const auto number_of_cycles{ static_cast<std::size_t>(state.max_iterations) };
+  std::vector<double> update_durations;
+  update_durations.reserve(number_of_cycles);
+  probe.resetMeasurements(number_of_cycles);
+
+  ros::Time trajectory_end;
+  for (auto _ : state)
+  {
+    if (ros::Time::now() >= trajectory_end)
+    {
+      if (!probe.sendTrajectory(trajectory))
+      {
+        state.SkipWithError("Failed to send the trajectory.");
+        break;
+      }
+      trajectory_end = ros::Time::now() + ros::Duration(TRAJECTORY_DURATION_SEC);
+    }
+    progressInTime(ros::Duration(CYCLE_TIME_SEC));
+
+    const auto start{ Clock::now() };
+    robot_driver.update();
+    const double update_duration{ secondsSince(start) };
+
+    state.SetIterationTime(update_duration);
+    update_durations.push_back(update_duration);
+    probe.measureChecks();
+  }
+
+  addLatencyCounters(state, "update", update_durations);
+  addLatencyCounters(state, "acceleration_check", probe.acceleration_check_durations_);
+  addLatencyCounters(state, "cartesian_speed_check", probe.cartesian_speed_check_durations_);
+  addLatencyCounters(state, "lookahead_check", probe.lookahead_check_durations_);
+}
+BENCHMARK(BM_ControlCycle)
+    ->ArgName("lookahead")
+    ->Arg(0)
+    ->Arg(1)
+    ->Iterations(NUMBER_OF_CYCLES)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace pilz_joint_trajectory_controller_benchmark
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "benchmark_pilz_joint_trajectory_controller");
+  ros::NodeHandle nh;
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -48,6 +48,7 @@ public:
 
   bool loadController();
   void startController();
+  void stopController();
   //! Perform controller update at current (simulated) time.
   void update();
 
@@ -101,6 +102,13 @@ void PJTCManagerMock<SegmentImpl, HWInterface>::startController()
   last_update_time_ = current_time;
 }
 
+template <class SegmentImpl, class HWInterface>
+void PJTCManagerMock<SegmentImpl, HWInterface>::stopController()
+{
+  controller_->stopping(ros::Time::now());
+  controller_->state_ = controller_->STOPPED;
+}
+
 template <class SegmentImpl, class HWInterface>
 void PJTCManagerMock<SegmentImpl, HWInterface>::update()
 {
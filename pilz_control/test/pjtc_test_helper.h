@@ -40,11 +40,23 @@ static const std::string JOINTS_PARAMETER{ "joints" };
 static const std::string JOINT_LIMITS_NAMESPACE{ "limits" };
 static const std::string HAS_ACCELERATION_PARAMETER{ "has_acceleration_limits" };
 static const std::string MAX_ACCELERATION_PARAMETER{ "max_acceleration" };
+static const std::string HAS_JERK_PARAMETER{ "has_jerk_limits" };
+static const std::string MAX_JERK_PARAMETER{ "max_jerk" };
+static const std::string LOOKAHEAD_ENABLED_PARAMETER{ "lookahead/enabled" };
+static const std::string LOOKAHEAD_HORIZON_PARAMETER{ "lookahead/horizon" };
+static const std::string GOAL_QUEUE_ENABLED_PARAMETER{ "goal_queue/enabled" };
+static const std::string GOAL_QUEUE_BLEND_RADIUS_PARAMETER{ "goal_queue/blend_radius" };
+static const std::string STREAMING_ENABLED_PARAMETER{ "streaming/enabled" };
+static const std::string STREAMING_SETPOINT_PERIOD_PARAMETER{ "streaming/setpoint_period" };
+static const std::string HOLD_TIMEOUT_PARAMETER{ "hold/timeout" };
+static const std::string CARTESIAN_SPEED_LIMIT_PARAMETER{ "cartesian_speed_monitoring/speed_limit" };
 
 static constexpr double DEFAULT_GOAL_DURATION_SEC{ 1.0 };
 static constexpr double STOP_TRAJECTORY_DURATION_SEC{ 0.2 };
 static constexpr double GOAL_TIME_TOLERANCE_SEC{ 0.01 };
 static constexpr double MAX_JOINT_ACCELERATION{ 5.0 };
+static constexpr double CARTESIAN_SPEED_LIMIT{ 0.25 };
+static constexpr double HOLD_TIMEOUT_SEC{ 3.0 };
 
 static constexpr double TIME_SIMULATION_START_SEC{ 0.1 };
 static constexpr double DEFAULT_UPDATE_PERIOD_SEC{ 0.008 };
@@ -83,6 +95,12 @@ static void setControllerParameters(const std::string& controller_ns)
   controller_nh_.setParam(JOINTS_PARAMETER, joint_names);
   controller_nh_.setParam(STOP_TRAJECTORY_DURATION_PARAMETER, STOP_TRAJECTORY_DURATION_SEC);
   controller_nh_.setParam(GOAL_TIME_TOLERANCE_PARAMETER, GOAL_TIME_TOLERANCE_SEC);
+  controller_nh_.setParam(LOOKAHEAD_ENABLED_PARAMETER, false);
+  controller_nh_.setParam(GOAL_QUEUE_ENABLED_PARAMETER, false);
+  controller_nh_.setParam(GOAL_QUEUE_BLEND_RADIUS_PARAMETER, 0.0);
+  controller_nh_.setParam(STREAMING_ENABLED_PARAMETER, false);
+  controller_nh_.setParam(HOLD_TIMEOUT_PARAMETER, HOLD_TIMEOUT_SEC);
+  controller_nh_.setParam(CARTESIAN_SPEED_LIMIT_PARAMETER, CARTESIAN_SPEED_LIMIT);
 
   ros::NodeHandle limits_nh(controller_nh_, JOINT_LIMITS_NAMESPACE);
   for (const auto& joint_name : joint_names)
@@ -93,6 +111,7 @@ static void setControllerParameters(const std::string& controller_ns)
     std::stringstream max_acceleration_full_name;
     max_acceleration_full_name << joint_name << "/" << MAX_ACCELERATION_PARAMETER;
     limits_nh.setParam(max_acceleration_full_name.str(), MAX_JOINT_ACCELERATION);
+    limits_nh.setParam(joint_name + "/" + HAS_JERK_PARAMETER, false);
   }
 }
 
@@ -60,6 +60,9 @@ public:
   //! @brief Only pass through from action client.
   ResultConstPtr getResult() const;
 
+  //! @brief Only pass through from action client.
+  actionlib::SimpleClientGoalState getState() const;
+
   //! @brief Wait independently of ros::Time opposed to actionlib function waitForServer().
   bool waitForActionServer(
       const std::chrono::milliseconds& timeout = std::chrono::milliseconds(WAIT_FOR_ACTION_SERVER_TIMEOUT_MSEC));
@@ -96,6 +99,11 @@ inline TrajectoryActionClientWrapper::ResultConstPtr TrajectoryActionClientWrapp
   return action_client_->getResult();
 }
 
+inline actionlib::SimpleClientGoalState TrajectoryActionClientWrapper::getState() const
+{
+  return action_client_->getState();
+}
+
 inline bool TrajectoryActionClientWrapper::waitForActionServer(const std::chrono::milliseconds& timeout)
 {
   return waitFor([this]() { return action_client_->isServerConnected(); }, timeout);
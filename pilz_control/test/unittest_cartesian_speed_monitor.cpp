@@ -17,6 +17,7 @@
 
 #include <cmath>
 #include <math.h>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -33,9 +34,11 @@
 
 #include <pilz_control/cartesian_speed_monitor.h>
 #include <pilz_control/cartesian_speed_monitor_exception.h>
+#include <pilz_control/kinematic_chain_evaluator.h>
 
 static constexpr double SPEED_COMPARISON_TOLERANCE{ 0.001 };
 static constexpr double SMALL_SKIP{ 0.01 };
+static constexpr double TRANSLATION_COMPARISON_TOLERANCE{ 1e-12 };
 
 static void buildTestModel(moveit::core::RobotModelConstPtr& model)
 {
@@ -73,7 +76,26 @@ static void buildTestModel(moveit::core::RobotModelConstPtr& model)
   model = builder.build();
 }
 
+/**
+ * @brief Compute the cartesian speed of a single robot link.
+ *
+ * @param current_state Current state of the robot. The link transforms have to be up-to-date.
+ * @param desired_state Desired state of the robot in the future. The link transforms have to be up-to-date.
+ * @param link Robot link under observation.
+ * @param time_delta Time[s] for reaching the desired state.
+ * @returns Cartesian speed[m/s].
+ */
+static double linkSpeed(const robot_state::RobotState* current_state, const robot_state::RobotState* desired_state,
+                        const moveit::core::LinkModel* link, const double& time_delta)
+{
+  const auto p1_cart{ current_state->getGlobalLinkTransform(link) };
+  const auto p2_cart{ desired_state->getGlobalLinkTransform(link) };
+
+  return (p2_cart.translation() - p1_cart.translation()).norm() / time_delta;
+}
+
 using pilz_control::CartesianSpeedMonitor;
+using pilz_control::KinematicChainEvaluator;
 
 class CartesianSpeedMonitorTest : public testing::Test
 {
@@ -110,11 +132,11 @@ TEST_F(CartesianSpeedMonitorTest, testLinkSpeedNoMovement)
   const moveit::core::LinkModel* link = model_->getLinkModel("link2");
   const double time_delta = 1.0;
 
-  double speed = pilz_control::linkSpeed(state.get(), state.get(), link, time_delta);
+  double speed = linkSpeed(state.get(), state.get(), link, time_delta);
   EXPECT_NEAR(speed, 0.0, SPEED_COMPARISON_TOLERANCE);
 
   link = model_->getLinkModel("link3");
-  speed = pilz_control::linkSpeed(state.get(), state.get(), link, time_delta);
+  speed = linkSpeed(state.get(), state.get(), link, time_delta);
   EXPECT_NEAR(speed, 0.0, SPEED_COMPARISON_TOLERANCE);
 }
 
@@ -140,12 +162,12 @@ TEST_F(CartesianSpeedMonitorTest, testLinkSpeedMoveSingleJoint)
     state2->updateLinkTransforms();
 
     const moveit::core::LinkModel* link = model_->getLinkModel("link2");
-    double speed = pilz_control::linkSpeed(state.get(), state2.get(), link, time_delta);
+    double speed = linkSpeed(state.get(), state2.get(), link, time_delta);
     double expected_velocity = (joint_name == "base-link1-joint") ? (angular_displacement / time_delta) : 0.0;
     EXPECT_NEAR(speed, expected_velocity, SPEED_COMPARISON_TOLERANCE);
 
     link = model_->getLinkModel("link3");
-    speed = pilz_control::linkSpeed(state.get(), state2.get(), link, time_delta);
+    speed = linkSpeed(state.get(), state2.get(), link, time_delta);
     expected_velocity = angular_displacement / time_delta;
     EXPECT_NEAR(speed, expected_velocity, SPEED_COMPARISON_TOLERANCE);
   }
@@ -171,11 +193,11 @@ TEST_F(CartesianSpeedMonitorTest, testLinkSpeedLinearScalingInTime)
   const moveit::core::LinkModel* link = model_->getLinkModel("link3");
   double time_delta = 0.1;
 
-  const double speed = pilz_control::linkSpeed(state.get(), state2.get(), link, time_delta);
+  const double speed = linkSpeed(state.get(), state2.get(), link, time_delta);
 
   const double factor = 2.0;
   time_delta *= factor;
-  const double speed2 = pilz_control::linkSpeed(state.get(), state2.get(), link, time_delta);
+  const double speed2 = linkSpeed(state.get(), state2.get(), link, time_delta);
 
   EXPECT_NEAR(speed2 * factor, speed, SPEED_COMPARISON_TOLERANCE);
 }
@@ -227,6 +249,247 @@ TEST_F(CartesianSpeedMonitorTest, testBelowLimitLinksNotPerpendicular)
       monitor.cartesianSpeedIsBelowLimit({ 0.0, 0.5 * M_PI }, { angular_displacement, 0.5 * M_PI }, time_delta, limit));
 }
 
+/**
+ * @tests{Monitor_speed_of_all_links_until_TCP,
+ * Tests monitoring consecutive cycles, where the current positions equal the previous desired positions.
+ * }
+ */
+TEST_F(CartesianSpeedMonitorTest, testBelowLimitConsecutiveCycles)
+{
+  CartesianSpeedMonitor monitor(joint_names_, model_);
+  monitor.init();
+
+  const double angular_displacement = 0.1;
+  const double time_delta = 0.2;
+  const double limit = angular_displacement / time_delta + SMALL_SKIP;
+
+  const std::vector<double> position0{ 0.0, 0.0 };
+  const std::vector<double> position1{ angular_displacement, 0.0 };
+  const std::vector<double> position2{ 3.0 * angular_displacement, 0.0 };
+  const std::vector<double> position3{ 4.0 * angular_displacement, 0.0 };
+
+  EXPECT_TRUE(monitor.cartesianSpeedIsBelowLimit(position0, position1, time_delta, limit));
+  EXPECT_FALSE(monitor.cartesianSpeedIsBelowLimit(position1, position2, time_delta, limit));
+  EXPECT_TRUE(monitor.cartesianSpeedIsBelowLimit(position2, position3, time_delta, limit));
+
+  // current positions differ from the previous desired positions
+  EXPECT_FALSE(monitor.cartesianSpeedIsBelowLimit(position1, position3, time_delta, limit));
+  EXPECT_TRUE(monitor.cartesianSpeedIsBelowLimit(position0, position1, time_delta, limit));
+}
+
+/**
+ * @tests{Monitor_speed_of_all_links_until_TCP,
+ * Tests that sub-sampling detects a speed limit violation in the middle of a cycle.
+ * }
+ */
+TEST_F(CartesianSpeedMonitorTest, testBelowLimitSubSampling)
+{
+  // Half a turn of joint1 moves link2 (distance 1.0 to the rotation axis) on an arc of length pi,
+  // whereas the straight-line distance between start and end is only 2.0
+  const double time_delta = 1.0;
+  const double limit = 2.5;
+  const std::vector<double> current_positions{ 0.0, 0.0 };
+  const std::vector<double> desired_positions{ M_PI, 0.0 };
+
+  CartesianSpeedMonitor monitor(joint_names_, model_);
+  monitor.init();
+  EXPECT_TRUE(monitor.cartesianSpeedIsBelowLimit(current_positions, desired_positions, time_delta, limit));
+
+  const unsigned int number_of_sub_samples{ 8 };
+  CartesianSpeedMonitor sub_sampling_monitor(joint_names_, model_);
+  sub_sampling_monitor.init(number_of_sub_samples);
+  EXPECT_FALSE(
+      sub_sampling_monitor.cartesianSpeedIsBelowLimit(current_positions, desired_positions, time_delta, limit));
+  EXPECT_TRUE(sub_sampling_monitor.cartesianSpeedIsBelowLimit(current_positions, desired_positions, time_delta,
+                                                              M_PI + SMALL_SKIP));
+}
+
+/**
+ * @tests{Monitor_speed_of_all_links_until_TCP,
+ * Tests that an additional point is monitored with the lower one of its individual and the global speed limit.
+ * }
+ */
+TEST_F(CartesianSpeedMonitorTest, testBelowLimitAdditionalPoint)
+{
+  const double angular_displacement = 0.1;
+  const double time_delta = 0.2;
+  const double link_speed = angular_displacement / time_delta;
+  const std::vector<double> current_positions{ 0.0, 0.0 };
+  const std::vector<double> desired_positions{ angular_displacement, 0.0 };
+
+  // The offset is parallel to the axis of joint1, therefore the point moves as fast as the link origins
+  pilz_control::MonitoredPoint point;
+  point.link_name = "link3";
+  point.offset = Eigen::Vector3d(0.0, 1.0, 0.0);
+  point.speed_limit = link_speed - SMALL_SKIP;
+
+  CartesianSpeedMonitor monitor(joint_names_, model_);
+  monitor.init(1, { point });
+  EXPECT_FALSE(
+      monitor.cartesianSpeedIsBelowLimit(current_positions, desired_positions, time_delta, link_speed + SMALL_SKIP));
+
+  // A deactivated monitoring deactivates the individual limits as well
+  EXPECT_TRUE(monitor.cartesianSpeedIsBelowLimit(current_positions, desired_positions, time_delta, -1.0));
+
+  point.speed_limit = link_speed + SMALL_SKIP;
+  CartesianSpeedMonitor relaxed_monitor(joint_names_, model_);
+  relaxed_monitor.init(1, { point });
+  EXPECT_TRUE(relaxed_monitor.cartesianSpeedIsBelowLimit(current_positions, desired_positions, time_delta,
+                                                         link_speed + SMALL_SKIP));
+}
+
+TEST_F(CartesianSpeedMonitorTest, testAdditionalPointUnknownLink)
+{
+  pilz_control::MonitoredPoint point;
+  point.link_name = "invalid_link_name";
+
+  CartesianSpeedMonitor monitor(joint_names_, model_);
+  EXPECT_THROW(monitor.init(1, { point }), pilz_control::UnknownLinkName);
+}
+
+TEST_F(CartesianSpeedMonitorTest, testAdditionalPointInvalidSpeedLimit)
+{
+  pilz_control::MonitoredPoint point;
+  point.link_name = "link3";
+  point.speed_limit = 0.0;
+
+  CartesianSpeedMonitor monitor(joint_names_, model_);
+  EXPECT_THROW(monitor.init(1, { point }), std::invalid_argument);
+}
+
+TEST_F(CartesianSpeedMonitorTest, testInitWithoutSubSamples)
+{
+  CartesianSpeedMonitor monitor(joint_names_, model_);
+  EXPECT_THROW(monitor.init(0), std::invalid_argument);
+}
+
+/**
+ * @brief Compare the interpolated translations of the KinematicChainEvaluator with the ones of a MoveIt RobotState.
+ */
+TEST_F(CartesianSpeedMonitorTest, testKinematicChainEvaluatorInterpolation)
+{
+  const std::vector<const moveit::core::LinkModel*> links{ model_->getLinkModel("link2"),
+                                                           model_->getLinkModel("link3") };
+  KinematicChainEvaluator evaluator(model_, joint_names_, links);
+  evaluator.reserveSamples(4);
+
+  const std::vector<double> start{ -0.3, 1.2 };
+  const std::vector<double> end{ 0.5, -0.4 };
+  std::vector<pilz_control::PointPositions> samples(4, pilz_control::PointPositions(links.size()));
+  evaluator.computeInterpolatedPointPositions(start, end, samples);
+
+  robot_state::RobotState state(model_);
+  state.setToDefaultValues();
+  for (std::size_t k = 0; k < samples.size(); ++k)
+  {
+    const double fraction{ static_cast<double>(k + 1) / static_cast<double>(samples.size()) };
+    state.setVariablePositions(joint_names_, { start[0] + fraction * (end[0] - start[0]),
+                                               start[1] + fraction * (end[1] - start[1]) });
+    state.updateLinkTransforms();
+    for (std::size_t i = 0; i < links.size(); ++i)
+    {
+      EXPECT_LT((samples[k].getPosition(i) - state.getGlobalLinkTransform(links[i]).translation()).norm(),
+                TRANSLATION_COMPARISON_TOLERANCE);
+    }
+  }
+}
+
+/**
+ * @brief Compare the translations computed by the KinematicChainEvaluator with the ones of a MoveIt RobotState.
+ */
+TEST_F(CartesianSpeedMonitorTest, testKinematicChainEvaluatorMatchesRobotState)
+{
+  const std::vector<const moveit::core::LinkModel*> links{ model_->getLinkModel("link2"),
+                                                           model_->getLinkModel("link3"),
+                                                           model_->getLinkModel("link1") };
+  KinematicChainEvaluator evaluator(model_, joint_names_, links);
+  ASSERT_EQ(evaluator.getNumberOfPoints(), links.size());
+
+  robot_state::RobotState state(model_);
+  state.setToDefaultValues();
+  pilz_control::PointPositions points(links.size());
+
+  const std::vector<std::vector<double>> positions{
+    { 0.0, 0.0 }, { 0.1, 0.0 }, { 0.0, -0.7 }, { 1.3, 0.5 * M_PI }, { -2.9, 2.1 }, { M_PI, -M_PI }
+  };
+  for (const auto& position : positions)
+  {
+    state.setVariablePositions(joint_names_, position);
+    state.updateLinkTransforms();
+    evaluator.computePointPositions(position, points);
+
+    for (std::size_t i = 0; i < links.size(); ++i)
+    {
+      const Eigen::Vector3d expected{ state.getGlobalLinkTransform(links[i]).translation() };
+      EXPECT_LT((points.getPosition(i) - expected).norm(), TRANSLATION_COMPARISON_TOLERANCE)
+          << "Mismatch for link " << links[i]->getName() << ": " << points.getPosition(i).transpose() << " vs. "
+          << expected.transpose();
+    }
+  }
+}
+
+/**
+ * @brief Joints which are not controlled have to be considered at their default position.
+ */
+TEST_F(CartesianSpeedMonitorTest, testKinematicChainEvaluatorUncontrolledJoint)
+{
+  const std::vector<const moveit::core::LinkModel*> links{ model_->getLinkModel("link3") };
+  const std::vector<std::string> controlled_joints{ joint_names_.back() };
+  KinematicChainEvaluator evaluator(model_, controlled_joints, links);
+
+  robot_state::RobotState state(model_);
+  state.setToDefaultValues();
+  const std::vector<double> position{ 0.4 };
+  state.setVariablePositions(controlled_joints, position);
+  state.updateLinkTransforms();
+
+  pilz_control::PointPositions points(links.size());
+  evaluator.computePointPositions(position, points);
+
+  EXPECT_LT((points.getPosition(0) - state.getGlobalLinkTransform(links.front()).translation()).norm(),
+            TRANSLATION_COMPARISON_TOLERANCE);
+}
+
+/**
+ * @brief Compare the positions of points with offsets with the ones computed from a MoveIt RobotState.
+ */
+TEST_F(CartesianSpeedMonitorTest, testKinematicChainEvaluatorPointOffsets)
+{
+  const std::vector<const moveit::core::LinkModel*> links{ model_->getLinkModel("link1"),
+                                                           model_->getLinkModel("link3") };
+  const std::vector<Eigen::Vector3d> offsets{ Eigen::Vector3d(0.1, -0.2, 0.3), Eigen::Vector3d(-0.5, 0.4, 0.0) };
+  KinematicChainEvaluator evaluator(model_, joint_names_, links, offsets);
+
+  const std::vector<double> position{ 0.7, -1.1 };
+  robot_state::RobotState state(model_);
+  state.setToDefaultValues();
+  state.setVariablePositions(joint_names_, position);
+  state.updateLinkTransforms();
+
+  pilz_control::PointPositions points(links.size());
+  evaluator.computePointPositions(position, points);
+  for (std::size_t i = 0; i < links.size(); ++i)
+  {
+    EXPECT_LT((points.getPosition(i) - state.getGlobalLinkTransform(links[i]) * offsets[i]).norm(),
+              TRANSLATION_COMPARISON_TOLERANCE);
+  }
+}
+
+TEST_F(CartesianSpeedMonitorTest, testKinematicChainEvaluatorOffsetsMismatch)
+{
+  const std::vector<const moveit::core::LinkModel*> links{ model_->getLinkModel("link3") };
+  EXPECT_THROW(KinematicChainEvaluator evaluator(model_, joint_names_, links, { Eigen::Vector3d::Zero(),
+                                                                                 Eigen::Vector3d::Zero() }),
+               std::invalid_argument);
+}
+
+TEST_F(CartesianSpeedMonitorTest, testKinematicChainEvaluatorUnmatchedJointNames)
+{
+  joint_names_.push_back("invalid_joint_name");
+  EXPECT_THROW(KinematicChainEvaluator evaluator(model_, joint_names_, {}),
+               pilz_control::RobotModelVariableNamesMismatch);
+}
+
 TEST_F(CartesianSpeedMonitorTest, testD0Destructor)
 {
   std::shared_ptr<CartesianSpeedMonitor> monitor{ new CartesianSpeedMonitor(joint_names_, model_) };
@@ -238,6 +501,18 @@ TEST_F(CartesianSpeedMonitorTest, testD0DestructorException)
   std::shared_ptr<RobotModelVariableNamesMismatch> monitor{ new RobotModelVariableNamesMismatch() };
 }
 
+TEST_F(CartesianSpeedMonitorTest, testD0DestructorUnsupportedJointTypeException)
+{
+  using pilz_control::UnsupportedJointType;
+  std::shared_ptr<UnsupportedJointType> exception{ new UnsupportedJointType("joint") };
+}
+
+TEST_F(CartesianSpeedMonitorTest, testD0DestructorUnknownLinkNameException)
+{
+  using pilz_control::UnknownLinkName;
+  std::shared_ptr<UnknownLinkName> exception{ new UnknownLinkName("link") };
+}
+
 int main(int argc, char* argv[])
 {
   testing::InitGoogleTest(&argc, argv);
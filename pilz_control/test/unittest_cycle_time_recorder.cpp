@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <pilz_control/cycle_time_recorder.h>
+#include <pilz_control/CycleTimeStatistics.h>
+
+namespace pilz_control
+{
+static constexpr double OVERRUN_THRESHOLD{ 50e-6 };
+static constexpr std::size_t BUFFER_SIZE{ 8 };
+static const std::vector<double> BIN_UPPER_BOUNDS{ 10e-6, 100e-6 };
+
+static CycleTimeSample createSample(const double& uptime, const double& extension_duration,
+                                    const double& speed_monitoring_duration = 0.0, const double& stop_duration = 0.0)
+{
+  CycleTimeSample sample;
+  sample.uptime = ros::Time(uptime);
+  sample.extension_duration = extension_duration;
+  sample.speed_monitoring_duration = speed_monitoring_duration;
+  sample.stop_duration = stop_duration;
+  return sample;
+}
+
+TEST(CycleTimeRecorderTest, testEmptyStatistics)
+{
+  CycleTimeRecorder recorder(OVERRUN_THRESHOLD, BUFFER_SIZE, BIN_UPPER_BOUNDS);
+  recorder.processSamples();
+
+  CycleTimeStatistics statistics;
+  recorder.getStatistics(statistics);
+  EXPECT_EQ(0u, statistics.cycles);
+  EXPECT_EQ(0u, statistics.overruns);
+  EXPECT_EQ(0u, statistics.dropped_cycles);
+  EXPECT_DOUBLE_EQ(OVERRUN_THRESHOLD, statistics.overrun_threshold);
+  EXPECT_EQ(BIN_UPPER_BOUNDS, statistics.bin_upper_bounds);
+  EXPECT_EQ(std::vector<uint64_t>(BIN_UPPER_BOUNDS.size() + 1, 0), statistics.extension_histogram);
+  EXPECT_DOUBLE_EQ(0.0, statistics.worst_extension_duration);
+}
+
+/**
+ * @brief Check that histograms, overruns and the worst cycle are accumulated from the recorded samples.
+ */
+TEST(CycleTimeRecorderTest, testStatistics)
+{
+  CycleTimeRecorder recorder(OVERRUN_THRESHOLD, BUFFER_SIZE, BIN_UPPER_BOUNDS);
+  EXPECT_TRUE(recorder.record(createSample(1.0, 5e-6, 2e-6)));
+  EXPECT_TRUE(recorder.record(createSample(2.0, 200e-6, 20e-6, 150e-6)));
+  EXPECT_TRUE(recorder.record(createSample(3.0, 60e-6, 5e-6)));
+
+  CycleTimeStatistics statistics;
+  recorder.getStatistics(statistics);
+  EXPECT_EQ(0u, statistics.cycles) << "Samples are not accumulated before processing";
+
+  recorder.processSamples();
+  recorder.getStatistics(statistics);
+  EXPECT_EQ(3u, statistics.cycles);
+  EXPECT_EQ(2u, statistics.overruns);
+  EXPECT_EQ(0u, statistics.dropped_cycles);
+  EXPECT_EQ((std::vector<uint64_t>{ 1, 1, 1 }), statistics.extension_histogram);
+  EXPECT_EQ((std::vector<uint64_t>{ 2, 1, 0 }), statistics.speed_monitoring_histogram);
+  EXPECT_EQ((std::vector<uint64_t>{ 0, 0, 1 }), statistics.stop_histogram)
+      << "Cycles without stop must not be counted";
+  EXPECT_DOUBLE_EQ(200e-6, statistics.worst_extension_duration);
+  EXPECT_EQ(ros::Time(2.0), statistics.worst_cycle_uptime);
+}
+
+/**
+ * @brief Check that the statistics are accumulated over several processings.
+ */
+TEST(CycleTimeRecorderTest, testAccumulationOverSeveralProcessings)
+{
+  CycleTimeRecorder recorder(OVERRUN_THRESHOLD, BUFFER_SIZE, BIN_UPPER_BOUNDS);
+  for (std::size_t i = 0; i < 3 * BUFFER_SIZE; ++i)
+  {
+    ASSERT_TRUE(recorder.record(createSample(static_cast<double>(i), 1e-6)));
+    if ((i + 1) % BUFFER_SIZE == 0)
+    {
+      recorder.processSamples();
+    }
+  }
+
+  CycleTimeStatistics statistics;
+  recorder.getStatistics(statistics);
+  EXPECT_EQ(3 * BUFFER_SIZE, statistics.cycles);
+  EXPECT_EQ(0u, statistics.dropped_cycles);
+}
+
+/**
+ * @brief Check that samples exceeding the buffer size are counted as dropped.
+ */
+TEST(CycleTimeRecorderTest, testBufferFull)
+{
+  CycleTimeRecorder recorder(OVERRUN_THRESHOLD, BUFFER_SIZE, BIN_UPPER_BOUNDS);
+  for (std::size_t i = 0; i < BUFFER_SIZE; ++i)
+  {
+    ASSERT_TRUE(recorder.record(createSample(static_cast<double>(i), 1e-6)));
+  }
+  EXPECT_FALSE(recorder.record(createSample(100.0, 1e-3)));
+
+  recorder.processSamples();
+  CycleTimeStatistics statistics;
+  recorder.getStatistics(statistics);
+  EXPECT_EQ(BUFFER_SIZE, statistics.cycles);
+  EXPECT_EQ(1u, statistics.dropped_cycles);
+  EXPECT_DOUBLE_EQ(1e-6, statistics.worst_extension_duration);
+}
+
+/**
+ * @brief Record from one thread while processing in another thread, no sample must get lost.
+ */
+TEST(CycleTimeRecorderTest, testConcurrentRecordingAndProcessing)
+{
+  static constexpr std::size_t NUMBER_OF_SAMPLES{ 1000 };
+  CycleTimeRecorder recorder(OVERRUN_THRESHOLD, BUFFER_SIZE, BIN_UPPER_BOUNDS);
+
+  std::thread producer([&recorder]() {
+    for (std::size_t i = 0; i < NUMBER_OF_SAMPLES; ++i)
+    {
+      while (!recorder.record(createSample(static_cast<double>(i), 1e-6)))
+      {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  CycleTimeStatistics statistics;
+  while (statistics.cycles < NUMBER_OF_SAMPLES)
+  {
+    recorder.processSamples();
+    recorder.getStatistics(statistics);
+  }
+  producer.join();
+
+  EXPECT_EQ(NUMBER_OF_SAMPLES, statistics.cycles);
+}
+
+}  // namespace pilz_control
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -37,6 +38,11 @@ static const std::string CONTROLLER_NAMESPACE{ "/controller_ns" };
 static const std::string JOINT_WITH_HAS_ACC_LIM_FALSE{ "joint_with_has_acc_lim_false" };
 static const std::string JOINT_WITH_UNDEFINED_MAX_ACC{ "joint_with_undefined_max_acc" };
 static const std::string JOINT_WITH_UNDEFINED_HAS_ACC_LIM{ "joint_with_undefined_has_acc_lim" };
+static const std::string JOINT_WITH_JERK_LIM{ "joint_with_jerk_lim" };
+static const std::string JOINT_WITH_UNDEFINED_MAX_JERK{ "joint_with_undefined_max_jerk" };
+static const std::string JOINT_WITH_UNDEFINED_HAS_JERK_LIM{ "joint_with_undefined_has_jerk_lim" };
+
+static constexpr double MAX_JOINT_JERK{ 50.0 };
 
 using namespace pilz_joint_trajectory_controller;
 
@@ -156,6 +162,93 @@ TEST_F(GetJointAccelerationLimitsTest, testUndefinedHasLimits)
   EXPECT_THROW(runGetJointAccelerationLimits(nh, { JOINT_WITH_UNDEFINED_HAS_ACC_LIM }), ros::InvalidParameterException);
 }
 
+/**
+ * @brief Test if parameters for jerk limits are correctly read.
+ */
+TEST_F(GetJointAccelerationLimitsTest, testJerkLimits)
+{
+  ros::NodeHandle nh{ "~" };
+  nh.setParam(JOINT_WITH_JERK_LIM + "/" + HAS_JERK_PARAMETER, true);
+  nh.setParam(JOINT_WITH_JERK_LIM + "/" + MAX_JERK_PARAMETER, MAX_JOINT_JERK);
+
+  const std::vector<boost::optional<double>> jerk_limits =
+      PilzJointTrajectoryController<DummySegmentImpl, DummyHardwareInterface>::getJointJerkLimits(
+          nh, { JOINT_WITH_JERK_LIM });
+  ASSERT_EQ(1U, jerk_limits.size());
+  ASSERT_TRUE(jerk_limits.at(0));
+  EXPECT_DOUBLE_EQ(MAX_JOINT_JERK, *jerk_limits.at(0));
+}
+
+/**
+ * @brief Test that the jerk limits are optional, i.e. a missing has_jerk_limits flag means no limit.
+ */
+TEST_F(GetJointAccelerationLimitsTest, testUndefinedHasJerkLimits)
+{
+  ros::NodeHandle nh{ "~" };
+  nh.setParam(JOINT_WITH_UNDEFINED_HAS_JERK_LIM + "/" + MAX_JERK_PARAMETER, MAX_JOINT_JERK);
+
+  const std::vector<boost::optional<double>> jerk_limits =
+      PilzJointTrajectoryController<DummySegmentImpl, DummyHardwareInterface>::getJointJerkLimits(
+          nh, { JOINT_WITH_UNDEFINED_HAS_JERK_LIM });
+  ASSERT_EQ(1U, jerk_limits.size());
+  EXPECT_FALSE(jerk_limits.at(0));
+}
+
+/**
+ * @brief Test if correct errors are thrown if the jerk limit is activated but not given.
+ */
+TEST_F(GetJointAccelerationLimitsTest, testUndefinedJerkLimit)
+{
+  ros::NodeHandle nh{ "~" };
+  nh.setParam(JOINT_WITH_UNDEFINED_MAX_JERK + "/" + HAS_JERK_PARAMETER, true);
+
+  EXPECT_THROW(PilzJointTrajectoryController<DummySegmentImpl, DummyHardwareInterface>::getJointJerkLimits(
+                   nh, { JOINT_WITH_UNDEFINED_MAX_JERK }),
+               ros::InvalidParameterException);
+}
+
+/**
+ * @brief Test if all limits checked by the controller are correctly read.
+ */
+TEST_F(GetJointAccelerationLimitsTest, testGetLimits)
+{
+  const ControllerLimits limits{ PilzJointTrajectoryController<DummySegmentImpl, DummyHardwareInterface>::getLimits(
+      controller_nh_, controller_joint_names_) };
+  ASSERT_EQ(controller_joint_names_.size(), limits.acceleration.size());
+  ASSERT_EQ(controller_joint_names_.size(), limits.jerk.size());
+  EXPECT_DOUBLE_EQ(MAX_JOINT_ACCELERATION, limits.acceleration.at(0));
+  EXPECT_EQ(std::numeric_limits<double>::infinity(), limits.jerk.at(0)) << "Joint without jerk limit expected.";
+  EXPECT_DOUBLE_EQ(CARTESIAN_SPEED_LIMIT, limits.cartesian_speed);
+}
+
+/**
+ * @brief Test that non-positive joint limits are rejected.
+ */
+TEST_F(GetJointAccelerationLimitsTest, testGetLimitsNonPositiveJointLimit)
+{
+  ros::NodeHandle limits_nh(controller_nh_, LIMITS_NAMESPACE);
+  limits_nh.setParam(controller_joint_names_.front() + "/" + MAX_ACCELERATION_PARAMETER, 0.0);
+
+  EXPECT_THROW(PilzJointTrajectoryController<DummySegmentImpl, DummyHardwareInterface>::getLimits(
+                   controller_nh_, controller_joint_names_),
+               ros::InvalidParameterException);
+}
+
+/**
+ * @brief Test that cartesian speed limits which are non-positive or exceed the T1 limit are rejected.
+ */
+TEST_F(GetJointAccelerationLimitsTest, testGetLimitsInvalidCartesianSpeedLimit)
+{
+  for (const double speed_limit : { -1.0, 0.0, 2 * CARTESIAN_SPEED_LIMIT })
+  {
+    controller_nh_.setParam(CARTESIAN_SPEED_LIMIT_PARAMETER, speed_limit);
+    EXPECT_THROW(PilzJointTrajectoryController<DummySegmentImpl, DummyHardwareInterface>::getLimits(
+                     controller_nh_, controller_joint_names_),
+                 ros::InvalidParameterException)
+        << "Speed limit: " << speed_limit;
+  }
+}
+
 }  // namespace pilz_joint_trajectory_controller_test
 
 int main(int argc, char** argv)
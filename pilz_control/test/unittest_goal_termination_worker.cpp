@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <pilz_control/goal_termination_worker.h>
+
+namespace pilz_joint_trajectory_controller
+{
+static constexpr std::chrono::milliseconds WAIT_FOR_TERMINATION_TIMEOUT{ 1000 };
+static constexpr std::chrono::milliseconds SLEEP_TIME{ 1 };
+
+//! @brief Mimics a control_msgs::FollowJointTrajectoryResult.
+struct ResultMock
+{
+  int error_code{ 0 };
+  std::string error_string;
+};
+
+//! @brief Mimics the goal handle member of a realtime_tools::RealtimeServerGoalHandle.
+class ServerGoalHandleMock
+{
+public:
+  void setAborted(const ResultMock& result, const std::string& text)
+  {
+    last_error_code_ = result.error_code;
+    last_text_ = text;
+    ++aborted_;
+  }
+  void setCanceled(const ResultMock& result, const std::string& text)
+  {
+    last_error_code_ = result.error_code;
+    last_text_ = text;
+    ++canceled_;
+  }
+
+public:
+  std::atomic<unsigned int> aborted_{ 0 };
+  std::atomic<unsigned int> canceled_{ 0 };
+  //! Only valid after a termination has been observed via aborted_ or canceled_.
+  int last_error_code_{ 0 };
+  std::string last_text_;
+};
+
+struct RealtimeGoalHandleMock
+{
+  ServerGoalHandleMock gh_;
+};
+
+using GoalHandlePtr = std::shared_ptr<RealtimeGoalHandleMock>;
+using ResultConstPtr = std::shared_ptr<const ResultMock>;
+using Worker = GoalTerminationWorker<GoalHandlePtr, ResultConstPtr>;
+
+static const ResultConstPtr RESULT{ new ResultMock() };
+
+static bool waitForCount(const std::atomic<unsigned int>& count, unsigned int expected)
+{
+  const auto start{ std::chrono::steady_clock::now() };
+  while (count != expected)
+  {
+    if (std::chrono::steady_clock::now() - start > WAIT_FOR_TERMINATION_TIMEOUT)
+    {
+      return false;
+    }
+    std::this_thread::sleep_for(SLEEP_TIME);
+  }
+  return true;
+}
+
+TEST(GoalTerminationWorkerTest, testAbort)
+{
+  Worker worker;
+  worker.start();
+
+  GoalHandlePtr goal_handle{ new RealtimeGoalHandleMock() };
+  EXPECT_TRUE(worker.requestAbort(goal_handle, RESULT));
+
+  EXPECT_TRUE(waitForCount(goal_handle->gh_.aborted_, 1U));
+  EXPECT_EQ(goal_handle->gh_.canceled_, 0U);
+}
+
+TEST(GoalTerminationWorkerTest, testCancel)
+{
+  Worker worker;
+  worker.start();
+
+  GoalHandlePtr goal_handle{ new RealtimeGoalHandleMock() };
+  worker.requestCancel(goal_handle, RESULT);
+
+  EXPECT_TRUE(waitForCount(goal_handle->gh_.canceled_, 1U));
+  EXPECT_EQ(goal_handle->gh_.aborted_, 0U);
+}
+
+/**
+ * @brief Check that the reference to the goal handle is released by the worker and not by the requesting thread.
+ */
+TEST(GoalTerminationWorkerTest, testGoalHandleReleasedByWorker)
+{
+  Worker worker;
+
+  GoalHandlePtr goal_handle{ new RealtimeGoalHandleMock() };
+  std::weak_ptr<RealtimeGoalHandleMock> observer{ goal_handle };
+  ASSERT_TRUE(worker.requestAbort(goal_handle, RESULT));
+  goal_handle.reset();
+
+  EXPECT_FALSE(observer.expired());
+  worker.start();
+  worker.stop();
+  EXPECT_TRUE(observer.expired());
+}
+
+TEST(GoalTerminationWorkerTest, testPendingRequestsProcessedOnStop)
+{
+  GoalHandlePtr goal_handle{ new RealtimeGoalHandleMock() };
+  {
+    Worker worker;
+    ASSERT_TRUE(worker.requestAbort(goal_handle, RESULT));
+    worker.requestCancel(goal_handle, RESULT);
+  }
+  EXPECT_EQ(goal_handle->gh_.aborted_, 1U);
+  EXPECT_EQ(goal_handle->gh_.canceled_, 1U);
+}
+
+TEST(GoalTerminationWorkerTest, testQueueFull)
+{
+  Worker worker;
+  GoalHandlePtr goal_handle{ new RealtimeGoalHandleMock() };
+  for (std::size_t i = 0; i < GOAL_TERMINATION_QUEUE_CAPACITY; ++i)
+  {
+    ASSERT_TRUE(worker.requestAbort(goal_handle, RESULT));
+  }
+  EXPECT_FALSE(worker.requestAbort(goal_handle, RESULT));
+}
+
+/**
+ * @brief Check that an abort request, which is rejected due to a full queue, succeeds once the worker processed the
+ * queue. No request is lost.
+ */
+TEST(GoalTerminationWorkerTest, testAbortRetryAfterQueueOverflow)
+{
+  Worker worker;
+  GoalHandlePtr goal_handle{ new RealtimeGoalHandleMock() };
+  for (std::size_t i = 0; i < GOAL_TERMINATION_QUEUE_CAPACITY; ++i)
+  {
+    ASSERT_TRUE(worker.requestAbort(goal_handle, RESULT));
+  }
+  GoalHandlePtr overflowing_goal_handle{ new RealtimeGoalHandleMock() };
+  ASSERT_FALSE(worker.requestAbort(overflowing_goal_handle, RESULT));
+
+  worker.start();
+  const auto start{ std::chrono::steady_clock::now() };
+  while (!worker.requestAbort(overflowing_goal_handle, RESULT))
+  {
+    ASSERT_LT(std::chrono::steady_clock::now() - start, WAIT_FOR_TERMINATION_TIMEOUT);
+    std::this_thread::sleep_for(SLEEP_TIME);
+  }
+
+  EXPECT_TRUE(waitForCount(goal_handle->gh_.aborted_, GOAL_TERMINATION_QUEUE_CAPACITY));
+  EXPECT_TRUE(waitForCount(overflowing_goal_handle->gh_.aborted_, 1U));
+}
+
+/**
+ * @brief Check that the number of cancel requests is not limited by the capacity of the abort queue.
+ */
+TEST(GoalTerminationWorkerTest, testCancelRequestsBeyondQueueCapacity)
+{
+  static constexpr std::size_t NUMBER_OF_REQUESTS{ 4 * GOAL_TERMINATION_QUEUE_CAPACITY };
+  GoalHandlePtr goal_handle{ new RealtimeGoalHandleMock() };
+  {
+    Worker worker;
+    for (std::size_t i = 0; i < NUMBER_OF_REQUESTS; ++i)
+    {
+      worker.requestCancel(goal_handle, RESULT);
+    }
+  }
+  EXPECT_EQ(goal_handle->gh_.canceled_, NUMBER_OF_REQUESTS);
+}
+
+/**
+ * @brief Check that the result of a request is passed to the client, with the error string as status text.
+ */
+TEST(GoalTerminationWorkerTest, testResultPassed)
+{
+  Worker worker;
+  worker.start();
+
+  ResultMock abort_result;
+  abort_result.error_code = -1;
+  abort_result.error_string = "Aborted for testing";
+  GoalHandlePtr aborted_goal_handle{ new RealtimeGoalHandleMock() };
+  ASSERT_TRUE(worker.requestAbort(aborted_goal_handle, std::make_shared<const ResultMock>(abort_result)));
+
+  ResultMock cancel_result;
+  cancel_result.error_code = -2;
+  cancel_result.error_string = "Canceled for testing";
+  GoalHandlePtr canceled_goal_handle{ new RealtimeGoalHandleMock() };
+  worker.requestCancel(canceled_goal_handle, std::make_shared<const ResultMock>(cancel_result));
+
+  ASSERT_TRUE(waitForCount(aborted_goal_handle->gh_.aborted_, 1U));
+  EXPECT_EQ(aborted_goal_handle->gh_.last_error_code_, abort_result.error_code);
+  EXPECT_EQ(aborted_goal_handle->gh_.last_text_, abort_result.error_string);
+
+  ASSERT_TRUE(waitForCount(canceled_goal_handle->gh_.canceled_, 1U));
+  EXPECT_EQ(canceled_goal_handle->gh_.last_error_code_, cancel_result.error_code);
+  EXPECT_EQ(canceled_goal_handle->gh_.last_text_, cancel_result.error_string);
+}
+
+/**
+ * @brief Check that the worker wakes up for each request, also after it has been waiting for a while.
+ */
+TEST(GoalTerminationWorkerTest, testWakeUpAfterIdle)
+{
+  static constexpr unsigned int NUMBER_OF_REQUESTS{ 3 };
+  Worker worker;
+  worker.start();
+
+  GoalHandlePtr goal_handle{ new RealtimeGoalHandleMock() };
+  for (unsigned int i = 1; i <= NUMBER_OF_REQUESTS; ++i)
+  {
+    std::this_thread::sleep_for(10 * SLEEP_TIME);
+    ASSERT_TRUE(worker.requestAbort(goal_handle, RESULT));
+    EXPECT_TRUE(waitForCount(goal_handle->gh_.aborted_, i));
+  }
+}
+
+TEST(GoalTerminationWorkerTest, testDoubleStart)
+{
+  Worker worker;
+  worker.start();
+  worker.start();
+
+  GoalHandlePtr goal_handle{ new RealtimeGoalHandleMock() };
+  EXPECT_TRUE(worker.requestAbort(goal_handle, RESULT));
+  EXPECT_TRUE(waitForCount(goal_handle->gh_.aborted_, 1U));
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
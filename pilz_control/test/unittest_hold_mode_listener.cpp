@@ -52,6 +52,29 @@ TEST(HoldModeListenerTest, testTriggerBeforeWait)
   EXPECT_EQ(wait_future.wait_for(timeout), std::future_status::ready);
 }
 
+TEST(HoldModeListenerTest, testWaitForTimeout)
+{
+  HoldModeListener listener;
+  const auto start{ std::chrono::steady_clock::now() };
+  EXPECT_FALSE(listener.waitFor(std::chrono::milliseconds(100)));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+
+  listener.triggerListener();
+  EXPECT_TRUE(listener.waitFor(std::chrono::nanoseconds::zero()));
+}
+
+TEST(HoldModeListenerTest, testWaitForTrigger)
+{
+  HoldModeListener listener;
+  std::future<bool> wait_future{ std::async(std::launch::async, [&listener]() {
+    return listener.waitFor(std::chrono::seconds(10 * WAIT_FOR_RESULT_TIMEOUT));
+  }) };
+
+  listener.triggerListener();
+  ASSERT_EQ(wait_future.wait_for(std::chrono::seconds(WAIT_FOR_RESULT_TIMEOUT)), std::future_status::ready);
+  EXPECT_TRUE(wait_future.get());
+}
+
 }  // namespace pilz_joint_trajectory_controller
 
 int main(int argc, char* argv[])
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <joint_trajectory_controller/joint_trajectory_segment.h>
+#include <trajectory_interface/quintic_spline_segment.h>
+
+#include <pilz_control/jerk_limited_stop_trajectory_builder.h>
+
+namespace pilz_joint_trajectory_controller
+{
+using SegmentImpl = trajectory_interface::QuinticSplineSegment<double>;
+using Segment = joint_trajectory_controller::JointTrajectorySegment<SegmentImpl>;
+using TrajectoryPerJoint = std::vector<Segment>;
+using Trajectory = std::vector<TrajectoryPerJoint>;
+
+static constexpr double INF{ std::numeric_limits<double>::infinity() };
+static constexpr double DEFAULT_STOP_DURATION{ 0.2 };
+static constexpr double START_TIME{ 10.0 };
+static constexpr unsigned int NUMBER_OF_SAMPLES{ 1000 };
+static constexpr double EPSILON{ 1e-9 };
+//! @brief Relative tolerance of the jerk, which is approximated by finite differences.
+static constexpr double JERK_TOLERANCE{ 1e-3 };
+
+static Trajectory createTrajectory(const std::size_t& number_of_joints)
+{
+  const Segment::State joint_state(1);
+  return Trajectory(number_of_joints, TrajectoryPerJoint(1, Segment(0.0, joint_state, 0.0, joint_state)));
+}
+
+static Segment::State createState(const std::vector<double>& positions, const std::vector<double>& velocities,
+                                  const std::vector<double>& accelerations)
+{
+  Segment::State state(positions.size());
+  state.position = positions;
+  state.velocity = velocities;
+  state.acceleration = accelerations;
+  return state;
+}
+
+TEST(JerkLimitedStopTrajectoryBuilderTest, testMinStopDurationWithoutAcceleration)
+{
+  // Acceleration limit is decisive
+  EXPECT_NEAR(1.5 * 1.0 / 2.0, getMinStopDuration(1.0, 0.0, 2.0, 100.0), EPSILON);
+  // Jerk limit is decisive
+  EXPECT_NEAR(std::sqrt(6.0 * 1.0 / 4.0), getMinStopDuration(-1.0, 0.0, 2.0, 4.0), EPSILON);
+}
+
+TEST(JerkLimitedStopTrajectoryBuilderTest, testMinStopDurationWithoutLimits)
+{
+  EXPECT_EQ(0.0, getMinStopDuration(1.0, 1.0, INF, INF));
+}
+
+/**
+ * @brief Check that the duration stays finite if the initial acceleration is close to the limit and that a braking
+ * joint does not stop later than the velocity allows without changing its sign.
+ */
+TEST(JerkLimitedStopTrajectoryBuilderTest, testMinStopDurationWithAccelerationAtLimit)
+{
+  // Accelerating
+  const double accelerating_duration{ getMinStopDuration(1.0, 1.9, 2.0, INF) };
+  EXPECT_NEAR(3.0 / (2.0 - 1.9 + std::sqrt(2.0 * 3.9)), accelerating_duration, EPSILON);
+  EXPECT_TRUE(std::isfinite(getMinStopDuration(1.0, 2.0, 2.0, INF)));
+  EXPECT_TRUE(std::isfinite(getMinStopDuration(-1.0, -2.0, 2.0, INF)));
+
+  // Braking
+  EXPECT_NEAR(3.0 / (2.0 + 1.9 + std::sqrt(2.0 * 0.1)), getMinStopDuration(1.0, -1.9, 2.0, INF), EPSILON);
+  EXPECT_NEAR(3.0 / 2.0 / 2.0, getMinStopDuration(-1.0, 2.0, 2.0, INF), EPSILON);
+  EXPECT_LE(getMinStopDuration(1.0, -1.9, 2.0, 100.0), getMaxStopDuration(1.0, -1.9));
+
+  // The jerk limit cannot be met without moving backwards, the velocity is decisive
+  EXPECT_NEAR(getMaxStopDuration(0.01, -2.0), getMinStopDuration(0.01, -2.0, 2.0, 10.0), EPSILON);
+}
+
+TEST(JerkLimitedStopTrajectoryBuilderTest, testMaxStopDuration)
+{
+  EXPECT_NEAR(1.5, getMaxStopDuration(1.0, -2.0), EPSILON);
+  EXPECT_NEAR(1.5, getMaxStopDuration(-1.0, 2.0), EPSILON);
+  EXPECT_EQ(INF, getMaxStopDuration(1.0, 2.0));
+  EXPECT_EQ(INF, getMaxStopDuration(-1.0, -2.0));
+  EXPECT_EQ(INF, getMaxStopDuration(0.0, 2.0));
+  EXPECT_EQ(INF, getMaxStopDuration(1.0, 0.0));
+}
+
+/**
+ * @brief Check that the stop trajectory starts at the given state, respects the limits and ends at rest.
+ */
+TEST(JerkLimitedStopTrajectoryBuilderTest, testStopTrajectoryRespectsLimits)
+{
+  const Segment::State start_state{ createState({ 0.1, -0.2, 0.3, 0.0 }, { 1.0, -0.5, 0.2, 0.0 },
+                                                { 0.5, 3.0, -1.0, 1.0 }) };
+  const std::vector<double> max_acceleration{ 2.0, 5.0, 4.5, 2.0 };
+  const std::vector<double> max_jerk{ 10.0, 50.0, 20.0, 100.0 };
+
+  JerkLimitedStopTrajectoryBuilder<SegmentImpl> builder(DEFAULT_STOP_DURATION, start_state);
+  Trajectory trajectory{ createTrajectory(start_state.position.size()) };
+  ASSERT_TRUE(builder.setLimits(max_acceleration, max_jerk)->setStartTime(START_TIME)->buildTrajectory(&trajectory));
+
+  const double duration{ builder.getStopDuration() };
+  ASSERT_GT(duration, 0.0);
+  const double sample_period{ duration / NUMBER_OF_SAMPLES };
+
+  Segment::State joint_state(1);
+  for (std::size_t i = 0; i < start_state.position.size(); ++i)
+  {
+    const Segment& segment{ trajectory.at(i).front() };
+    EXPECT_NEAR(START_TIME, segment.startTime(), EPSILON);
+    // Braking joints stop early instead of moving backwards
+    EXPECT_NEAR(START_TIME + std::min(duration, getMaxStopDuration(start_state.velocity.at(i),
+                                                                   start_state.acceleration.at(i))),
+                segment.endTime(), EPSILON)
+        << "Joints are not synchronized";
+
+    segment.sample(START_TIME, joint_state);
+    EXPECT_NEAR(start_state.position.at(i), joint_state.position.at(0), EPSILON);
+    EXPECT_NEAR(start_state.velocity.at(i), joint_state.velocity.at(0), EPSILON);
+    EXPECT_NEAR(start_state.acceleration.at(i), joint_state.acceleration.at(0), EPSILON);
+
+    double last_acceleration{ joint_state.acceleration.at(0) };
+    for (unsigned int k = 1; k <= NUMBER_OF_SAMPLES; ++k)
+    {
+      segment.sample(START_TIME + k * sample_period, joint_state);
+      const double acceleration{ joint_state.acceleration.at(0) };
+      EXPECT_LE(std::abs(acceleration), max_acceleration.at(i) + EPSILON);
+      EXPECT_LE(std::abs(acceleration - last_acceleration) / sample_period,
+                max_jerk.at(i) * (1.0 + JERK_TOLERANCE));
+      EXPECT_GE(joint_state.velocity.at(0) * start_state.velocity.at(i), -EPSILON) << "Joint moves backwards";
+      last_acceleration = acceleration;
+    }
+    EXPECT_NEAR(0.0, joint_state.velocity.at(0), EPSILON);
+    EXPECT_NEAR(0.0, joint_state.acceleration.at(0), EPSILON);
+  }
+}
+
+/**
+ * @brief Check that a single joint stops in the shortest duration, if the acceleration limit is decisive.
+ */
+TEST(JerkLimitedStopTrajectoryBuilderTest, testStopDurationIsMinimal)
+{
+  const Segment::State start_state{ createState({ 0.0 }, { 1.0 }, { 0.0 }) };
+  const std::vector<double> max_acceleration{ 2.0 };
+  const std::vector<double> max_jerk{ 100.0 };
+
+  JerkLimitedStopTrajectoryBuilder<SegmentImpl> builder(DEFAULT_STOP_DURATION, start_state);
+  Trajectory trajectory{ createTrajectory(1) };
+  ASSERT_TRUE(builder.setLimits(max_acceleration, max_jerk)->setStartTime(START_TIME)->buildTrajectory(&trajectory));
+  EXPECT_NEAR(1.5 * 1.0 / 2.0, builder.getStopDuration(), EPSILON);
+
+  // The acceleration limit is reached in the middle of the stop motion
+  Segment::State joint_state(1);
+  trajectory.front().front().sample(START_TIME + builder.getStopDuration() / 2.0, joint_state);
+  EXPECT_NEAR(-max_acceleration.front(), joint_state.acceleration.front(), EPSILON);
+}
+
+/**
+ * @brief Check the stop motion of joints, whose acceleration is close to the limit, both braking and accelerating.
+ *
+ * A braking joint must not move backwards, i.e. its position ends between the start position and the position
+ * reached by keeping the initial velocity for the whole stop duration. An accelerating joint must not exceed the
+ * acceleration limit while reversing its acceleration.
+ */
+TEST(JerkLimitedStopTrajectoryBuilderTest, testStopWithAccelerationAtLimit)
+{
+  const Segment::State start_state{ createState({ 0.0, 0.0, 0.0, 0.0 }, { 1.0, -1.0, 1.0, -1.0 },
+                                                { -1.9, 1.9, 1.9, -2.0 }) };
+  const std::vector<double> max_acceleration(4, 2.0);
+  const std::vector<double> max_jerk(4, 100.0);
+
+  JerkLimitedStopTrajectoryBuilder<SegmentImpl> builder(DEFAULT_STOP_DURATION, start_state);
+  Trajectory trajectory{ createTrajectory(start_state.position.size()) };
+  ASSERT_TRUE(builder.setLimits(max_acceleration, max_jerk)->setStartTime(START_TIME)->buildTrajectory(&trajectory));
+  ASSERT_TRUE(std::isfinite(builder.getStopDuration()));
+
+  Segment::State joint_state(1);
+  for (std::size_t i = 0; i < start_state.position.size(); ++i)
+  {
+    const Segment& segment{ trajectory.at(i).front() };
+    const double duration{ segment.endTime() - segment.startTime() };
+    const double sample_period{ duration / NUMBER_OF_SAMPLES };
+    const double start_velocity{ start_state.velocity.at(i) };
+    const bool braking{ start_velocity * start_state.acceleration.at(i) < 0.0 };
+
+    for (unsigned int k = 0; k <= NUMBER_OF_SAMPLES; ++k)
+    {
+      segment.sample(START_TIME + k * sample_period, joint_state);
+      EXPECT_LE(std::abs(joint_state.acceleration.at(0)), max_acceleration.at(i) + EPSILON);
+      EXPECT_GE(joint_state.velocity.at(0) * start_velocity, -EPSILON) << "Joint " << i << " moves backwards";
+      if (braking)
+      {
+        EXPECT_LE(std::abs(joint_state.velocity.at(0)), std::abs(start_velocity) + EPSILON);
+      }
+    }
+    EXPECT_NEAR(0.0, joint_state.velocity.at(0), EPSILON);
+    EXPECT_NEAR(0.0, joint_state.acceleration.at(0), EPSILON);
+
+    const double distance{ joint_state.position.at(0) - start_state.position.at(i) };
+    EXPECT_GE(distance * start_velocity, 0.0);
+    if (braking)
+    {
+      EXPECT_LE(std::abs(distance), std::abs(start_velocity) * duration);
+    }
+  }
+}
+
+TEST(JerkLimitedStopTrajectoryBuilderTest, testDefaultDurationWithoutLimits)
+{
+  const Segment::State start_state{ createState({ 0.0 }, { 1.0 }, { 0.0 }) };
+  const std::vector<double> max_acceleration{ INF };
+  const std::vector<double> max_jerk{ INF };
+
+  JerkLimitedStopTrajectoryBuilder<SegmentImpl> builder(DEFAULT_STOP_DURATION, start_state);
+  Trajectory trajectory{ createTrajectory(1) };
+  ASSERT_TRUE(builder.setLimits(max_acceleration, max_jerk)->setStartTime(START_TIME)->buildTrajectory(&trajectory));
+  EXPECT_NEAR(DEFAULT_STOP_DURATION, builder.getStopDuration(), EPSILON);
+  EXPECT_NEAR(START_TIME + DEFAULT_STOP_DURATION, trajectory.front().front().endTime(), EPSILON);
+}
+
+TEST(JerkLimitedStopTrajectoryBuilderTest, testRobotAtRest)
+{
+  const Segment::State start_state{ createState({ 0.5, -0.5 }, { 0.0, 0.0 }, { 0.0, 0.0 }) };
+  const std::vector<double> max_acceleration{ 1.0, 1.0 };
+  const std::vector<double> max_jerk{ 1.0, 1.0 };
+
+  JerkLimitedStopTrajectoryBuilder<SegmentImpl> builder(DEFAULT_STOP_DURATION, start_state);
+  Trajectory trajectory{ createTrajectory(2) };
+  ASSERT_TRUE(builder.setLimits(max_acceleration, max_jerk)->setStartTime(START_TIME)->buildTrajectory(&trajectory));
+  EXPECT_NEAR(MIN_STOP_DURATION, builder.getStopDuration(), EPSILON);
+
+  Segment::State joint_state(1);
+  for (std::size_t i = 0; i < start_state.position.size(); ++i)
+  {
+    trajectory.at(i).front().sample(START_TIME + MIN_STOP_DURATION, joint_state);
+    EXPECT_NEAR(start_state.position.at(i), joint_state.position.at(0), EPSILON);
+  }
+}
+
+TEST(JerkLimitedStopTrajectoryBuilderTest, testInvalidLimits)
+{
+  const Segment::State start_state{ createState({ 0.0, 0.0 }, { 1.0, 1.0 }, { 0.0, 0.0 }) };
+  JerkLimitedStopTrajectoryBuilder<SegmentImpl> builder(DEFAULT_STOP_DURATION, start_state);
+  Trajectory trajectory{ createTrajectory(2) };
+  EXPECT_FALSE(builder.buildTrajectory(&trajectory)) << "Limits not set";
+
+  const std::vector<double> limits_too_short{ 1.0 };
+  const std::vector<double> limits{ 1.0, 1.0 };
+  EXPECT_FALSE(builder.setLimits(limits_too_short, limits)->buildTrajectory(&trajectory));
+  EXPECT_FALSE(builder.setLimits(limits, limits_too_short)->buildTrajectory(&trajectory));
+}
+
+TEST(JerkLimitedStopTrajectoryBuilderTest, testInvalidTrajectory)
+{
+  const Segment::State start_state{ createState({ 0.0, 0.0 }, { 1.0, 1.0 }, { 0.0, 0.0 }) };
+  const std::vector<double> limits{ 1.0, 1.0 };
+  JerkLimitedStopTrajectoryBuilder<SegmentImpl> builder(DEFAULT_STOP_DURATION, start_state);
+  Trajectory trajectory{ createTrajectory(1) };
+  EXPECT_FALSE(builder.setLimits(limits, limits)->buildTrajectory(&trajectory));
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
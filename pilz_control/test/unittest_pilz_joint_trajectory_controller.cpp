@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -27,6 +30,8 @@
 
 #include <ros/ros.h>
 
+#include <actionlib/client/simple_action_client.h>
+
 #include <trajectory_msgs/JointTrajectory.h>
 #include <std_srvs/Trigger.h>
 
@@ -35,6 +40,8 @@
 
 #include <pilz_control/pilz_joint_trajectory_controller.h>
 #include <pilz_control/pilz_joint_trajectory_controller_impl.h>
+#include <pilz_control/ExecutionState.h>
+#include <pilz_control/HoldAction.h>
 
 #include "pjtc_manager_mock.h"
 #include "pjtc_test_helper.h"
@@ -47,8 +54,10 @@ static const std::string CONTROLLER_NAMESPACE{ "/controller_ns" };
 static const std::string TRAJECTORY_ACTION{ "/follow_joint_trajectory" };
 static const std::string HOLD_SERVICE{ "/hold" };
 static const std::string UNHOLD_SERVICE{ "/unhold" };
+static const std::string HOLD_ACTION{ "/hold_action" };
 static const std::string IS_EXECUTING_SERVICE{ "/is_executing" };
 static const std::string TRAJECTORY_COMMAND_TOPIC{ "/command" };
+static const std::string EXECUTION_STATE_TOPIC{ "/execution_state" };
 
 using HWInterface = hardware_interface::PositionJointInterface;
 using Segment = trajectory_interface::QuinticSplineSegment<double>;
@@ -329,6 +338,12 @@ TEST_F(PilzJointTrajectoryControllerTest, testHoldDuringGoalExecution)
   std::future<bool> hold_future = manager_->triggerHoldAsync(req, resp);
   EXPECT_TRUE(updateUntilHoldMode<RobotDriver>(&robot_driver_, hold_future));
   EXPECT_TRUE(resp.success);
+
+  ASSERT_TRUE(action_client_.waitForActionResult());
+  EXPECT_EQ(action_client_.getState(), actionlib::SimpleClientGoalState::PREEMPTED);
+  EXPECT_EQ(action_client_.getResult()->error_code,
+            control_msgs::FollowJointTrajectoryResult::PATH_TOLERANCE_VIOLATED);
+
   EXPECT_TRUE(isControllerInHoldMode());
 
   EXPECT_TRUE(action_client_.waitForActionResult());
@@ -400,6 +415,84 @@ TEST_F(PilzJointTrajectoryControllerTest, testTrajCommandExecution)
   BARRIER({ LOG_MSG_RECEIVED_EVENT_WARN, LOG_MSG_RECEIVED_EVENT_INFO });
 }
 
+static constexpr double SHORT_HOLD_TIMEOUT_SEC{ 0.5 };
+
+/**
+ * @brief Check that the hold service returns, if the stop motion does not finish in time.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testHoldTimeout)
+{
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  controller_nh.setParam(HOLD_TIMEOUT_PARAMETER, SHORT_HOLD_TIMEOUT_SEC);
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  std_srvs::TriggerRequest req;
+  std_srvs::TriggerResponse resp;
+  // Without updates the stop motion does not finish
+  EXPECT_TRUE(manager_->triggerHold(req, resp));
+  EXPECT_FALSE(resp.success);
+
+  std::future<bool> hold_future = manager_->triggerHoldAsync(req, resp);
+  EXPECT_TRUE(updateUntilHoldMode<RobotDriver>(&robot_driver_, hold_future));
+  EXPECT_TRUE(resp.success);
+  EXPECT_TRUE(isControllerInHoldMode());
+}
+
+/**
+ * @brief Check that the hold service returns, if the controller is stopped during the stop motion.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testHoldFailsIfControllerIsStopped)
+{
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  std_srvs::TriggerRequest req;
+  std_srvs::TriggerResponse resp;
+  std::future<bool> hold_future = manager_->triggerHoldAsync(req, resp);
+  manager_->stopController();
+
+  EXPECT_TRUE(waitFor([&hold_future]() { return isFutureReady(hold_future); }, HOLD_TIMEOUT));
+  EXPECT_FALSE(resp.success);
+}
+
+TEST_F(PilzJointTrajectoryControllerTest, testHoldAction)
+{
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  actionlib::SimpleActionClient<pilz_control::HoldAction> hold_client(CONTROLLER_NAMESPACE + HOLD_ACTION, true);
+  ASSERT_TRUE(waitFor([&hold_client]() { return hold_client.isServerConnected(); }, HOLD_TIMEOUT));
+
+  hold_client.sendGoal(pilz_control::HoldGoal());
+  EXPECT_TRUE(waitFor([&hold_client]() { return hold_client.getState().isDone(); }, HOLD_TIMEOUT,
+                      [this]() { robot_driver_.update(); }));
+  EXPECT_EQ(actionlib::SimpleClientGoalState::SUCCEEDED, hold_client.getState().state_);
+  EXPECT_TRUE(isControllerInHoldMode());
+}
+
+/**
+ * @brief Check that a goal of the hold action receives the remaining stop time and is aborted after its timeout.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testHoldActionTimeout)
+{
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  actionlib::SimpleActionClient<pilz_control::HoldAction> hold_client(CONTROLLER_NAMESPACE + HOLD_ACTION, true);
+  ASSERT_TRUE(waitFor([&hold_client]() { return hold_client.isServerConnected(); }, HOLD_TIMEOUT));
+
+  std::atomic<double> remaining_stop_time{ 0.0 };
+  pilz_control::HoldGoal goal;
+  goal.timeout = ros::Duration(SHORT_HOLD_TIMEOUT_SEC);
+  hold_client.sendGoal(goal, actionlib::SimpleActionClient<pilz_control::HoldAction>::SimpleDoneCallback(),
+                       actionlib::SimpleActionClient<pilz_control::HoldAction>::SimpleActiveCallback(),
+                       [&remaining_stop_time](const pilz_control::HoldFeedbackConstPtr& feedback) {
+                         remaining_stop_time = feedback->remaining_stop_time.toSec();
+                       });
+
+  // Without updates the stop motion does not finish
+  EXPECT_TRUE(waitFor([&hold_client]() { return hold_client.getState().isDone(); }, HOLD_TIMEOUT));
+  EXPECT_EQ(actionlib::SimpleClientGoalState::ABORTED, hold_client.getState().state_);
+  EXPECT_GT(remaining_stop_time, 0.0);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 //    Testing the correct handling of trajectories that violate the acceleration limits    //
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -426,9 +519,74 @@ TEST_F(PilzJointTrajectoryControllerTest, testTrajectoryWithTooHighAcceleration)
 
   goal = generateAlternatingGoal(&robot_driver_, ros::Duration(DEFAULT_GOAL_DURATION_SEC), 1E3);
   action_client_.sendGoal(goal);
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(action_client_.getState(), actionlib::SimpleClientGoalState::ABORTED);
+  EXPECT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::INVALID_GOAL);
+  EXPECT_FALSE(action_client_.getResult()->error_string.empty());
+
+  const auto end_position = robot_driver_.getJointPositions();
+  ASSERT_EQ(end_position.size(), start_position.size()) << "Position vectors sizes mismatch.";
+  for (unsigned int i = 0; i < end_position.size(); ++i)
+  {
+    EXPECT_EQ(end_position[i], start_position[i])
+        << "Difference in position despite no movement should have been performed.";
+  }
+}
+
+static constexpr double MINIMUM_JERK_GOAL_DISTANCE{ 2e-2 };
+static constexpr double MINIMUM_JERK_GOAL_DURATION_SEC{ 2.0 };
+//! Max jerk[rad/s^3] of the minimum-jerk goal, which equals 60 * distance / duration^3.
+static constexpr double MINIMUM_JERK_GOAL_MAX_JERK{ 0.15 };
+
+/**
+ * @brief Generate a goal moving the first joint along a minimum-jerk profile, which starts and ends at rest.
+ *
+ * The waypoints include velocities and accelerations, hence the acceleration is continuous at the segment switches.
+ * In contrast, goals with positions only are interpolated linearly and therefore have no acceleration at all.
+ */
+static GoalType generateMinimumJerkGoal(const std::vector<double>& start_positions,
+                                        const std::size_t& number_of_segments)
+{
+  const double distance{ MINIMUM_JERK_GOAL_DISTANCE };
+  const double duration{ MINIMUM_JERK_GOAL_DURATION_SEC };
+
+  GoalType goal;
+  goal.trajectory.joint_names = std::vector<std::string>(JOINT_NAMES.begin(), JOINT_NAMES.end());
+  for (std::size_t k = 1; k <= number_of_segments; ++k)
+  {
+    const double tau{ static_cast<double>(k) / static_cast<double>(number_of_segments) };
+    trajectory_msgs::JointTrajectoryPoint point;
+    point.time_from_start = ros::Duration(tau * duration);
+    point.positions = start_positions;
+    point.positions.at(0) += distance * (10.0 - 15.0 * tau + 6.0 * tau * tau) * tau * tau * tau;
+    point.velocities.assign(start_positions.size(), 0.0);
+    point.velocities.at(0) = distance / duration * 30.0 * tau * tau * (1.0 - tau) * (1.0 - tau);
+    point.accelerations.assign(start_positions.size(), 0.0);
+    point.accelerations.at(0) = distance / (duration * duration) * 60.0 * tau * (1.0 - tau) * (1.0 - 2.0 * tau);
+    goal.trajectory.points.push_back(point);
+  }
+  return goal;
+}
+
+/**
+ * @brief Send a trajectory that violates the jerk limits and make sure the controller does not execute it.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testTrajectoryWithTooHighJerk)
+{
+  static constexpr double MAX_JERK{ 0.1 * MINIMUM_JERK_GOAL_MAX_JERK };
+  ros::NodeHandle limits_nh{ CONTROLLER_NAMESPACE + "/" + JOINT_LIMITS_NAMESPACE };
+  for (const auto& joint_name : JOINT_NAMES)
+  {
+    limits_nh.setParam(std::string(joint_name) + "/" + HAS_JERK_PARAMETER, true);
+    limits_nh.setParam(std::string(joint_name) + "/" + MAX_JERK_PARAMETER, MAX_JERK);
+  }
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  const auto start_position = robot_driver_.getJointPositions();
+
+  // The goal starts with its max jerk
+  action_client_.sendGoal(generateMinimumJerkGoal(start_position, 1));
   action_client_.waitForActionResult([this]() { robot_driver_.update(); });
-  // the following fails due to https://github.com/ros-controls/ros_controllers/issues/174
-  // EXPECT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::INVALID_GOAL);
 
   const auto end_position = robot_driver_.getJointPositions();
   ASSERT_EQ(end_position.size(), start_position.size()) << "Position vectors sizes mismatch.";
@@ -439,6 +597,516 @@ TEST_F(PilzJointTrajectoryControllerTest, testTrajectoryWithTooHighAcceleration)
   }
 }
 
+/**
+ * @brief Send a multi-segment trajectory within the jerk limits and make sure it is executed completely, i.e. the
+ * switches between the segments do not trigger a stop (no false positive).
+ *
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testMultiSegmentTrajectoryWithinJerkLimits)
+{
+  static constexpr std::size_t NUMBER_OF_SEGMENTS{ 10 };
+  static constexpr double MAX_JERK{ 3.0 * MINIMUM_JERK_GOAL_MAX_JERK };
+  ros::NodeHandle limits_nh{ CONTROLLER_NAMESPACE + "/" + JOINT_LIMITS_NAMESPACE };
+  for (const auto& joint_name : JOINT_NAMES)
+  {
+    limits_nh.setParam(std::string(joint_name) + "/" + HAS_JERK_PARAMETER, true);
+    limits_nh.setParam(std::string(joint_name) + "/" + MAX_JERK_PARAMETER, MAX_JERK);
+  }
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  const std::vector<double> start_positions{ robot_driver_.getJointPositions() };
+  const GoalType goal{ generateMinimumJerkGoal(start_positions, NUMBER_OF_SEGMENTS) };
+  action_client_.sendGoal(goal);
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(action_client_.getState(), actionlib::SimpleClientGoalState::SUCCEEDED);
+  EXPECT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::SUCCESSFUL);
+  EXPECT_TRUE(isControllerInUnholdMode()) << "Controller stopped at a segment switch.";
+  EXPECT_NEAR(start_positions.at(0) + MINIMUM_JERK_GOAL_DISTANCE, robot_driver_.getJointPositions().at(0), 1e-3);
+}
+
+/**
+ * @brief Lower the acceleration limits of the running controller via reload and make sure the controller applies them
+ * without restart, i.e. a goal which succeeded before the reload is not executed afterwards.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testReloadLimits)
+{
+  // The goal reaches its constant velocity of 1E-3rad/s within one cycle, i.e. with 0.125rad/s^2
+  static constexpr double MAX_ACCELERATION{ 1E-2 };
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  GoalType goal{ generateAlternatingGoal<RobotDriver>(&robot_driver_) };
+  action_client_.sendGoal(goal);
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  ASSERT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::SUCCESSFUL)
+      << "Goal not executed with the initial limits.";
+
+  ros::NodeHandle limits_nh{ CONTROLLER_NAMESPACE + "/" + JOINT_LIMITS_NAMESPACE };
+  for (const auto& joint_name : JOINT_NAMES)
+  {
+    limits_nh.setParam(std::string(joint_name) + "/" + MAX_ACCELERATION_PARAMETER, MAX_ACCELERATION);
+  }
+  std_srvs::TriggerRequest request;
+  std_srvs::TriggerResponse response;
+  ASSERT_TRUE(manager_->controller_->handleReloadLimitsRequest(request, response));
+  ASSERT_TRUE(response.success) << response.message;
+
+  goal = generateAlternatingGoal<RobotDriver>(&robot_driver_);
+  const auto start_position = robot_driver_.getJointPositions();
+  action_client_.sendGoal(goal);
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(action_client_.getState(), actionlib::SimpleClientGoalState::ABORTED);
+
+  const auto end_position = robot_driver_.getJointPositions();
+  ASSERT_EQ(end_position.size(), start_position.size()) << "Position vectors sizes mismatch.";
+  for (unsigned int i = 0; i < end_position.size(); ++i)
+  {
+    EXPECT_EQ(end_position[i], start_position[i]) << "Goal executed despite the reloaded acceleration limits.";
+  }
+}
+
+/**
+ * @brief Make sure that invalid limits are rejected on reload as a whole and the previous limits stay active.
+ *
+ * The rejected limits contain a valid, but lower acceleration limit, which the subsequent goal violates. The goal must
+ * be executed with the previous limits.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testReloadInvalidLimits)
+{
+  // The goal reaches its constant velocity of 1E-3rad/s within one cycle, i.e. with 0.125rad/s^2
+  static constexpr double REJECTED_MAX_ACCELERATION{ 1E-2 };
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  std_srvs::TriggerRequest request;
+  std_srvs::TriggerResponse response;
+
+  controller_nh.setParam(CARTESIAN_SPEED_LIMIT_PARAMETER, 2 * CARTESIAN_SPEED_LIMIT);
+  ASSERT_TRUE(manager_->controller_->handleReloadLimitsRequest(request, response));
+  EXPECT_FALSE(response.success) << "Cartesian speed limit above the T1 limit accepted.";
+  controller_nh.setParam(CARTESIAN_SPEED_LIMIT_PARAMETER, CARTESIAN_SPEED_LIMIT);
+
+  ros::NodeHandle limits_nh{ controller_nh, JOINT_LIMITS_NAMESPACE };
+  limits_nh.setParam(std::string(JOINT_NAMES.front()) + "/" + MAX_ACCELERATION_PARAMETER, REJECTED_MAX_ACCELERATION);
+  limits_nh.setParam(std::string(JOINT_NAMES.back()) + "/" + MAX_ACCELERATION_PARAMETER, -MAX_JOINT_ACCELERATION);
+  ASSERT_TRUE(manager_->controller_->handleReloadLimitsRequest(request, response));
+  EXPECT_FALSE(response.success) << "Negative acceleration limit accepted.";
+
+  GoalType goal{ generateAlternatingGoal<RobotDriver>(&robot_driver_) };
+  action_client_.sendGoal(goal);
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(action_client_.getState(), actionlib::SimpleClientGoalState::SUCCEEDED)
+      << "Goal not executed with the previous limits.";
+  EXPECT_TRUE(isControllerInUnholdMode()) << "Controller stopped due to the rejected acceleration limit.";
+}
+
+/////////////////////////////////////////
+//    Testing of the speed override    //
+/////////////////////////////////////////
+
+/**
+ * @brief Execute a trajectory with a reduced speed override and make sure its execution is slowed down accordingly
+ * without violating a limit.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testSpeedOverride)
+{
+  static constexpr double SPEED_OVERRIDE{ 0.5 };
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+  ASSERT_TRUE(manager_->controller_->setSpeedOverride(SPEED_OVERRIDE, CARTESIAN_SPEED_LIMIT));
+
+  // The robot is at rest, hence the speed override applies from the first cycle on
+  GoalType goal{ generateAlternatingGoal<RobotDriver>(&robot_driver_) };
+  const ros::Time start_time{ ros::Time::now() };
+  action_client_.sendGoal(goal);
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::SUCCESSFUL);
+
+  const ros::Duration execution_duration{ ros::Time::now() - start_time };
+  EXPECT_GT(execution_duration.toSec(), getGoalDuration(goal).toSec() / SPEED_OVERRIDE - GOAL_TIME_TOLERANCE_SEC)
+      << "Trajectory was not slowed down from the start.";
+}
+
+/**
+ * @brief Reduce the speed override during the execution of a trajectory and make sure the trajectory is completed.
+ *
+ * The acceleration limit is chosen such that an instant change of the speed would violate it.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testSpeedOverrideChangeDuringExecution)
+{
+  static constexpr double SPEED_OVERRIDE{ 0.2 };
+  static constexpr double MAX_ACCELERATION{ 0.05 };
+  static constexpr double TIME_BEFORE_CHANGE_SEC{ 0.4 };
+  ros::NodeHandle limits_nh{ CONTROLLER_NAMESPACE + "/" + JOINT_LIMITS_NAMESPACE };
+  for (const auto& joint_name : JOINT_NAMES)
+  {
+    limits_nh.setParam(std::string(joint_name) + "/" + MAX_ACCELERATION_PARAMETER, MAX_ACCELERATION);
+  }
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  GoalType goal{ generateAlternatingGoal<RobotDriver>(&robot_driver_) };
+  action_client_.sendGoal(goal);
+  EXPECT_TRUE(updateUntilRobotMotion(&robot_driver_));
+  for (double t = 0.0; t < TIME_BEFORE_CHANGE_SEC; t += DEFAULT_UPDATE_PERIOD_SEC)
+  {
+    progressInTime(ros::Duration(DEFAULT_UPDATE_PERIOD_SEC));
+    robot_driver_.update();
+  }
+
+  ASSERT_TRUE(manager_->controller_->setSpeedOverride(SPEED_OVERRIDE, CARTESIAN_SPEED_LIMIT));
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::SUCCESSFUL);
+}
+
+/**
+ * @brief Execute a trajectory with a velocity path tolerance and a reduced speed override and make sure the tolerance
+ * is checked against the slowed down velocity.
+ *
+ * The tolerance is below the difference between the velocity of the trajectory and the slowed down velocity.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testSpeedOverrideWithVelocityPathTolerance)
+{
+  static constexpr double SPEED_OVERRIDE{ 0.5 };
+  static constexpr double VELOCITY_TOLERANCE{ 5e-4 };
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+  ASSERT_TRUE(manager_->controller_->setSpeedOverride(SPEED_OVERRIDE, CARTESIAN_SPEED_LIMIT));
+
+  GoalType goal{ generateAlternatingGoal<RobotDriver>(&robot_driver_) };
+  for (const auto& joint_name : goal.trajectory.joint_names)
+  {
+    control_msgs::JointTolerance tolerance;
+    tolerance.name = joint_name;
+    tolerance.velocity = VELOCITY_TOLERANCE;
+    goal.path_tolerance.push_back(tolerance);
+  }
+  action_client_.sendGoal(goal);
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::SUCCESSFUL);
+}
+
+TEST_F(PilzJointTrajectoryControllerTest, testInvalidSpeedOverride)
+{
+  ASSERT_TRUE(manager_->loadController()) << "Failed to initialize the controller.";
+
+  EXPECT_FALSE(manager_->controller_->setSpeedOverride(-0.1, CARTESIAN_SPEED_LIMIT));
+  EXPECT_FALSE(manager_->controller_->setSpeedOverride(1.1, CARTESIAN_SPEED_LIMIT));
+  EXPECT_FALSE(
+      manager_->controller_->setSpeedOverride(std::numeric_limits<double>::quiet_NaN(), CARTESIAN_SPEED_LIMIT));
+  EXPECT_FALSE(manager_->controller_->setSpeedOverride(1.0, 0.0));
+  EXPECT_TRUE(manager_->controller_->setSpeedOverride(0.0, CARTESIAN_SPEED_LIMIT)) << "Pausing must be possible.";
+}
+
+/**
+ * @brief Send a slow trajectory with activated lookahead and make sure it is executed (no false positive).
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testLookaheadSlowTrajectory)
+{
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  controller_nh.setParam(LOOKAHEAD_ENABLED_PARAMETER, true);
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  GoalType goal{ generateAlternatingGoal<RobotDriver>(&robot_driver_) };
+  action_client_.sendGoal(goal);
+
+  EXPECT_TRUE(updateUntilRobotMotion(&robot_driver_));
+  EXPECT_TRUE(updateUntilNoRobotMotion(&robot_driver_));
+
+  action_client_.waitForActionResult();
+  EXPECT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::SUCCESSFUL);
+}
+
+/**
+ * @brief Send a trajectory whose second segment has too high acceleration with activated lookahead and make sure the
+ * controller stops the robot before the second segment starts.
+ *
+ * Without the lookahead the violation would only be detected at the start of the second segment.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testLookaheadTrajectoryWithTooHighAcceleration)
+{
+  static constexpr double LOOKAHEAD_HORIZON_SEC{ 0.5 };
+  static constexpr double VALID_SEGMENT_DURATION_SEC{ 1.0 };
+  static constexpr double VALID_SEGMENT_DISTANCE{ 1e-2 };
+  // Requires an acceleration far above MAX_JOINT_ACCELERATION at the transition from the valid segment
+  static constexpr double VIOLATING_SEGMENT_DURATION_SEC{ 0.1 };
+  static constexpr double VIOLATING_SEGMENT_DISTANCE{ 0.1 };
+
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  controller_nh.setParam(LOOKAHEAD_ENABLED_PARAMETER, true);
+  controller_nh.setParam(LOOKAHEAD_HORIZON_PARAMETER, LOOKAHEAD_HORIZON_SEC);
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  const double start_position{ robot_driver_.getJointPositions().at(0) };
+  GoalType goal{ generateSimpleGoal(start_position + VALID_SEGMENT_DISTANCE,
+                                    ros::Duration(VALID_SEGMENT_DURATION_SEC)) };
+  goal.trajectory.points.push_back(goal.trajectory.points.front());
+  goal.trajectory.points.back().positions.at(0) += VIOLATING_SEGMENT_DISTANCE;
+  goal.trajectory.points.back().time_from_start += ros::Duration(VIOLATING_SEGMENT_DURATION_SEC);
+
+  const ros::Time start_time{ ros::Time::now() };
+  ros::Time last_motion_time{ start_time };
+  const auto update = [this, &last_motion_time]() {
+    robot_driver_.update();
+    if (robot_driver_.isRobotMoving())
+    {
+      last_motion_time = ros::Time::now();
+    }
+  };
+  action_client_.sendGoal(goal);
+  ASSERT_TRUE(action_client_.waitForActionResult(update));
+  EXPECT_EQ(action_client_.getState(), actionlib::SimpleClientGoalState::ABORTED);
+  ASSERT_TRUE(waitFor([this]() { return !robot_driver_.isRobotMoving(); }, MOVEMENT_TIMEOUT, update));
+
+  EXPECT_GT(last_motion_time, start_time) << "The valid segment was not executed.";
+  EXPECT_LT((last_motion_time - start_time).toSec(), VALID_SEGMENT_DURATION_SEC)
+      << "The robot did not stop before the segment with too high acceleration.";
+  EXPECT_LE(robot_driver_.getJointPositions().at(0), start_position + VALID_SEGMENT_DISTANCE)
+      << "The segment with too high acceleration was executed.";
+}
+
+////////////////////////////////////
+//    Testing of the goal queue    //
+////////////////////////////////////
+
+static constexpr double QUEUED_GOAL_DISTANCE{ 1e-2 };
+static constexpr double BLEND_RADIUS{ 5e-3 };
+
+/**
+ * @brief Send a goal while another goal is executed and make sure both goals succeed without a stop in between.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testQueuedGoalIsExecutedWithoutStop)
+{
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  controller_nh.setParam(GOAL_QUEUE_ENABLED_PARAMETER, true);
+  controller_nh.setParam(GOAL_QUEUE_BLEND_RADIUS_PARAMETER, BLEND_RADIUS);
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  TrajectoryActionClientWrapper queued_action_client{ CONTROLLER_NAMESPACE + TRAJECTORY_ACTION };
+  ASSERT_TRUE(queued_action_client.waitForActionServer());
+
+  const double start_position{ robot_driver_.getJointPositions().at(0) };
+  const ros::Duration goal_duration(DEFAULT_GOAL_DURATION_SEC);
+  action_client_.sendGoal(generateSimpleGoal(start_position + QUEUED_GOAL_DISTANCE, goal_duration));
+  ASSERT_TRUE(updateUntilRobotMotion(&robot_driver_));
+
+  queued_action_client.sendGoal(generateSimpleGoal(start_position + 2 * QUEUED_GOAL_DISTANCE, goal_duration));
+  // The trajectory of the queued goal is taken over by the realtime thread
+  ASSERT_TRUE(waitFor(
+      [&queued_action_client]() {
+        return queued_action_client.getState() == actionlib::SimpleClientGoalState::ACTIVE;
+      },
+      MOVEMENT_TIMEOUT, [this]() { robot_driver_.update(); }))
+      << "Queued goal was not accepted.";
+
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::SUCCESSFUL);
+  EXPECT_TRUE(robot_driver_.isRobotMoving()) << "Robot stopped between the queued goals.";
+
+  ASSERT_TRUE(queued_action_client.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(queued_action_client.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::SUCCESSFUL);
+  EXPECT_TRUE(updateUntilNoRobotMotion(&robot_driver_));
+  EXPECT_NEAR(start_position + 2 * QUEUED_GOAL_DISTANCE, robot_driver_.getJointPositions().at(0), 1e-3);
+}
+
+/**
+ * @brief Cancel a queued goal and make sure the active goal is cancelled as well and the robot stops.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testCancelQueuedGoal)
+{
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  controller_nh.setParam(GOAL_QUEUE_ENABLED_PARAMETER, true);
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  TrajectoryActionClientWrapper queued_action_client{ CONTROLLER_NAMESPACE + TRAJECTORY_ACTION };
+  ASSERT_TRUE(queued_action_client.waitForActionServer());
+
+  const double start_position{ robot_driver_.getJointPositions().at(0) };
+  const ros::Duration goal_duration(DEFAULT_GOAL_DURATION_SEC);
+  action_client_.sendGoal(generateSimpleGoal(start_position + QUEUED_GOAL_DISTANCE, goal_duration));
+  ASSERT_TRUE(updateUntilRobotMotion(&robot_driver_));
+
+  queued_action_client.sendGoal(generateSimpleGoal(start_position + 2 * QUEUED_GOAL_DISTANCE, goal_duration));
+  // The trajectory of the queued goal is taken over by the realtime thread
+  ASSERT_TRUE(waitFor(
+      [&queued_action_client]() {
+        return queued_action_client.getState() == actionlib::SimpleClientGoalState::ACTIVE;
+      },
+      MOVEMENT_TIMEOUT, [this]() { robot_driver_.update(); }))
+      << "Queued goal was not accepted.";
+
+  queued_action_client.cancelGoal();
+  ASSERT_TRUE(queued_action_client.waitForActionResult([this]() { robot_driver_.update(); }));
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(queued_action_client.getState(), actionlib::SimpleClientGoalState::PREEMPTED);
+  EXPECT_EQ(action_client_.getState(), actionlib::SimpleClientGoalState::PREEMPTED);
+  EXPECT_TRUE(updateUntilNoRobotMotion(&robot_driver_));
+}
+
+///////////////////////////////////////////////////////
+//    Testing of the streaming setpoint interface    //
+///////////////////////////////////////////////////////
+
+static constexpr double STREAMING_SETPOINT_PERIOD_SEC{ 0.1 };
+static constexpr unsigned int NUMBER_OF_STREAMING_TEST_CYCLES{ 10 };
+
+/**
+ * @brief Send a streaming setpoint and make sure the robot moves to it.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testStreamingSetpoint)
+{
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  controller_nh.setParam(STREAMING_ENABLED_PARAMETER, true);
+  controller_nh.setParam(STREAMING_SETPOINT_PERIOD_PARAMETER, STREAMING_SETPOINT_PERIOD_SEC);
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  std::vector<double> setpoint{ robot_driver_.getJointPositions() };
+  setpoint.at(0) += 1e-3;
+  std::string error_string;
+  ASSERT_TRUE(manager_->controller_->setStreamingSetpoint(setpoint, {}, &error_string)) << error_string;
+
+  EXPECT_TRUE(updateUntilRobotMotion(&robot_driver_));
+  EXPECT_TRUE(updateUntilNoRobotMotion(&robot_driver_));
+  EXPECT_NEAR(setpoint.at(0), robot_driver_.getJointPositions().at(0), 1e-6);
+}
+
+/**
+ * @brief Send a streaming setpoint, which cannot be reached within the limits, and make sure the robot is stopped.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testStreamingSetpointWithTooHighAcceleration)
+{
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  controller_nh.setParam(STREAMING_ENABLED_PARAMETER, true);
+  controller_nh.setParam(STREAMING_SETPOINT_PERIOD_PARAMETER, STREAMING_SETPOINT_PERIOD_SEC);
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  const std::vector<double> start_position{ robot_driver_.getJointPositions() };
+  std::vector<double> setpoint{ start_position };
+  setpoint.at(0) += 1.0;
+  ASSERT_TRUE(manager_->controller_->setStreamingSetpoint(setpoint, {}));
+
+  for (unsigned int k = 0; k < NUMBER_OF_STREAMING_TEST_CYCLES; ++k)
+  {
+    progressInTime(ros::Duration(DEFAULT_UPDATE_PERIOD_SEC));
+    robot_driver_.update();
+  }
+  EXPECT_TRUE(updateUntilNoRobotMotion(&robot_driver_));
+  EXPECT_NEAR(start_position.at(0), robot_driver_.getJointPositions().at(0), 1e-2);
+  EXPECT_FALSE(manager_->controller_->setStreamingSetpoint(setpoint, {})) << "Setpoint accepted after a stop";
+}
+
+/**
+ * @brief Send a streaming setpoint followed by a goal before the controller is updated and make sure the setpoint
+ * does not replace the trajectory of the goal, i.e. the goal succeeds.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testStreamingSetpointBeforeGoal)
+{
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  controller_nh.setParam(STREAMING_ENABLED_PARAMETER, true);
+  controller_nh.setParam(STREAMING_SETPOINT_PERIOD_PARAMETER, STREAMING_SETPOINT_PERIOD_SEC);
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  GoalType goal{ generateAlternatingGoal<RobotDriver>(&robot_driver_) };
+  const double goal_position{ goal.trajectory.points.front().positions.at(0) };
+  std::vector<double> setpoint{ robot_driver_.getJointPositions() };
+  setpoint.at(0) -= goal_position - setpoint.at(0);
+  ASSERT_TRUE(manager_->controller_->setStreamingSetpoint(setpoint, {}));
+
+  action_client_.sendGoal(goal);
+  ASSERT_TRUE(waitFor(
+      [this]() { return action_client_.getState() == actionlib::SimpleClientGoalState::ACTIVE; }, MOVEMENT_TIMEOUT))
+      << "Goal was not accepted.";
+
+  ASSERT_TRUE(action_client_.waitForActionResult([this]() { robot_driver_.update(); }));
+  EXPECT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::SUCCESSFUL);
+  EXPECT_TRUE(updateUntilNoRobotMotion(&robot_driver_));
+  EXPECT_NEAR(goal_position, robot_driver_.getJointPositions().at(0), 1e-6);
+}
+
+TEST_F(PilzJointTrajectoryControllerTest, testStreamingSetpointDisabledByDefault)
+{
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+  EXPECT_FALSE(manager_->controller_->setStreamingSetpoint(robot_driver_.getJointPositions(), {}));
+}
+
+TEST_F(PilzJointTrajectoryControllerTest, testInvalidStreamingSetpoint)
+{
+  ros::NodeHandle controller_nh{ CONTROLLER_NAMESPACE };
+  controller_nh.setParam(STREAMING_ENABLED_PARAMETER, true);
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+
+  std::vector<double> setpoint{ robot_driver_.getJointPositions() };
+  EXPECT_FALSE(manager_->controller_->setStreamingSetpoint({ setpoint.front() }, {})) << "Too few positions";
+  EXPECT_FALSE(manager_->controller_->setStreamingSetpoint(setpoint, { 0.0 })) << "Too few velocities";
+
+  setpoint.at(0) = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_FALSE(manager_->controller_->setStreamingSetpoint(setpoint, {}));
+}
+
+/////////////////////////////////////////////
+//    Testing of the execution state topic    //
+/////////////////////////////////////////////
+
+/**
+ * @brief Stores the last execution state published by the controller.
+ */
+class ExecutionStateObserver
+{
+public:
+  explicit ExecutionStateObserver(const std::string& topic)
+    : subscriber_(ros::NodeHandle().subscribe(topic, 10, &ExecutionStateObserver::callback, this))
+  {
+  }
+
+  bool isInState(const bool& executing, const uint8_t& mode, const bool& has_goal)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return received_ && state_.executing == executing && state_.mode == mode && state_.goal_id.empty() != has_goal;
+  }
+
+private:
+  void callback(const pilz_control::ExecutionStateConstPtr& msg)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_ = *msg;
+    received_ = true;
+  }
+
+private:
+  std::mutex mutex_;
+  pilz_control::ExecutionState state_;
+  bool received_{ false };
+  ros::Subscriber subscriber_;
+};
+
+/**
+ * @brief Check that the execution state topic reflects the execution of a goal and the switch into holding mode.
+ */
+TEST_F(PilzJointTrajectoryControllerTest, testExecutionStateTopic)
+{
+  using pilz_control::ExecutionState;
+
+  ASSERT_TRUE(performFullControllerStartup(&robot_driver_));
+  ExecutionStateObserver observer{ CONTROLLER_NAMESPACE + EXECUTION_STATE_TOPIC };
+  const auto update = [this]() { robot_driver_.update(); };
+
+  EXPECT_TRUE(waitFor([&observer]() { return observer.isInState(false, ExecutionState::UNHOLD, false); },
+                      MOVEMENT_TIMEOUT, update));
+
+  GoalType goal{ generateAlternatingGoal<RobotDriver>(&robot_driver_) };
+  action_client_.sendGoal(goal);
+  EXPECT_TRUE(waitFor([&observer]() { return observer.isInState(true, ExecutionState::UNHOLD, true); },
+                      MOVEMENT_TIMEOUT, update));
+
+  EXPECT_TRUE(action_client_.waitForActionResult(update));
+  EXPECT_EQ(action_client_.getResult()->error_code, control_msgs::FollowJointTrajectoryResult::SUCCESSFUL);
+  EXPECT_TRUE(waitFor([&observer]() { return observer.isInState(false, ExecutionState::UNHOLD, false); },
+                      MOVEMENT_TIMEOUT, update));
+
+  std_srvs::TriggerRequest req;
+  std_srvs::TriggerResponse resp;
+  std::future<bool> hold_future = manager_->triggerHoldAsync(req, resp);
+  EXPECT_TRUE(updateUntilHoldMode<RobotDriver>(&robot_driver_, hold_future));
+  EXPECT_TRUE(waitFor([&observer]() { return observer.isInState(false, ExecutionState::HOLD, false); }, HOLD_TIMEOUT,
+                      update));
+}
+
 }  // namespace pilz_joint_trajectory_controller_test
 
 int main(int argc, char** argv)
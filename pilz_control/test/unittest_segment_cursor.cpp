@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <pilz_control/segment_cursor.h>
+
+namespace pilz_joint_trajectory_controller
+{
+static constexpr std::size_t NUMBER_OF_SEGMENTS{ 1000 };
+static constexpr double SEGMENT_DURATION{ 0.01 };
+
+class SegmentMock
+{
+public:
+  explicit SegmentMock(const double& start_time) : start_time_(start_time)
+  {
+  }
+  double startTime() const
+  {
+    return start_time_;
+  }
+
+private:
+  double start_time_;
+};
+
+using Trajectory = std::vector<SegmentMock>;
+
+static Trajectory createTrajectory(const double& start_time, const std::size_t& number_of_segments = NUMBER_OF_SEGMENTS)
+{
+  Trajectory trajectory;
+  for (std::size_t i = 0; i < number_of_segments; ++i)
+  {
+    trajectory.emplace_back(start_time + static_cast<double>(i) * SEGMENT_DURATION);
+  }
+  return trajectory;
+}
+
+//! @brief Reference implementation, equivalent to trajectory_interface::findSegment().
+static Trajectory::const_iterator findSegmentByBinarySearch(const Trajectory& trajectory, const double& time)
+{
+  if (trajectory.empty() || time < trajectory.front().startTime())
+  {
+    return trajectory.end();
+  }
+  return --std::upper_bound(trajectory.begin(), trajectory.end(), time,
+                            [](const double& t, const SegmentMock& segment) { return t < segment.startTime(); });
+}
+
+TEST(SegmentCursorTest, testEmptyTrajectory)
+{
+  SegmentCursor<SegmentMock> cursor;
+  const Trajectory trajectory;
+  EXPECT_EQ(trajectory.end(), cursor.findSegment(trajectory, 1.0));
+}
+
+TEST(SegmentCursorTest, testTimeBeforeTrajectoryStart)
+{
+  SegmentCursor<SegmentMock> cursor;
+  const Trajectory trajectory{ createTrajectory(1.0) };
+  EXPECT_EQ(trajectory.end(), cursor.findSegment(trajectory, 0.5));
+}
+
+TEST(SegmentCursorTest, testTimeAfterTrajectoryEnd)
+{
+  SegmentCursor<SegmentMock> cursor;
+  const Trajectory trajectory{ createTrajectory(0.0) };
+  EXPECT_EQ(trajectory.end() - 1, cursor.findSegment(trajectory, 100.0));
+}
+
+/**
+ * @brief Check that the cursor finds the same segments as a binary search for small and large steps in time.
+ */
+TEST(SegmentCursorTest, testMonotonicTime)
+{
+  const Trajectory trajectory{ createTrajectory(0.0) };
+  const double trajectory_duration{ static_cast<double>(NUMBER_OF_SEGMENTS) * SEGMENT_DURATION };
+  for (const double step : { 0.001, 0.01, 0.05, 0.5 })
+  {
+    SegmentCursor<SegmentMock> cursor;
+    for (double time = -step; time < trajectory_duration + step; time += step)
+    {
+      ASSERT_EQ(findSegmentByBinarySearch(trajectory, time), cursor.findSegment(trajectory, time))
+          << "Step: " << step << ", time: " << time;
+    }
+  }
+}
+
+TEST(SegmentCursorTest, testTimeJumpBackwards)
+{
+  SegmentCursor<SegmentMock> cursor;
+  const Trajectory trajectory{ createTrajectory(0.0) };
+  cursor.findSegment(trajectory, 5.0);
+  EXPECT_EQ(findSegmentByBinarySearch(trajectory, 1.234), cursor.findSegment(trajectory, 1.234));
+}
+
+/**
+ * @brief Check the search after the trajectory is replaced by a shorter one and by one which started in the past.
+ */
+TEST(SegmentCursorTest, testTrajectorySwap)
+{
+  SegmentCursor<SegmentMock> cursor;
+  const Trajectory trajectory{ createTrajectory(0.0) };
+  cursor.findSegment(trajectory, 9.0);
+
+  const Trajectory short_trajectory{ createTrajectory(0.0, 3) };
+  EXPECT_EQ(short_trajectory.begin() + 2, cursor.findSegment(short_trajectory, 9.0));
+
+  const Trajectory past_trajectory{ createTrajectory(-5.0) };
+  EXPECT_EQ(findSegmentByBinarySearch(past_trajectory, 9.0), cursor.findSegment(past_trajectory, 9.0));
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -14,9 +14,13 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <future>
+#include <random>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -167,6 +171,106 @@ TEST(TrajModeManagerTest, testListenerSwitchToMode)
   EXPECT_TRUE(holdReached(wait_future));
 }
 
+TEST(TrajModeManagerTest, testListenerTimeout)
+{
+  TrajProcessingModeManager manager;
+  ASSERT_EQ(manager.getCurrentMode(), TrajProcessingMode::stopping);
+
+  HoldModeListener listener;
+  EXPECT_FALSE(manager.stopEvent(&listener));
+  EXPECT_FALSE(listener.waitFor(std::chrono::milliseconds(10)));
+
+  manager.stopMotionFinishedEvent();
+  EXPECT_TRUE(listener.waitFor(std::chrono::milliseconds(10)));
+}
+
+static constexpr unsigned int NUMBER_OF_STRESS_TEST_CALLERS{ 8 };
+static constexpr std::chrono::milliseconds STRESS_TEST_DURATION{ 1000 };
+static constexpr std::chrono::microseconds STRESS_TEST_READER_PERIOD{ 1000 };
+
+/**
+ * @brief Many threads request stops (partly waiting for the hold mode) and starts concurrently, while a reader
+ * imitates the realtime thread at 1 kHz and finishes the stop motions.
+ *
+ * Checks that the reader always sees a valid mode and that each waiting caller returns once the hold mode is reached.
+ */
+TEST(TrajModeManagerTest, testConcurrentEvents)
+{
+  TrajProcessingModeManager manager;
+  std::atomic_bool terminate{ false };
+  std::atomic_bool terminate_reader{ false };
+
+  std::size_t number_of_reads{ 0 };
+  std::size_t number_of_invalid_modes{ 0 };
+  std::thread reader([&manager, &terminate_reader, &number_of_reads, &number_of_invalid_modes]() {
+    while (!terminate_reader)
+    {
+      const TrajProcessingMode mode{ manager.getCurrentMode() };
+      ++number_of_reads;
+      if (mode != TrajProcessingMode::unhold && mode != TrajProcessingMode::stopping &&
+          mode != TrajProcessingMode::hold)
+      {
+        ++number_of_invalid_modes;
+      }
+      if (mode == TrajProcessingMode::stopping)
+      {
+        manager.stopMotionFinishedEvent();
+      }
+      std::this_thread::sleep_for(STRESS_TEST_READER_PERIOD);
+    }
+  });
+
+  std::vector<std::future<std::size_t>> callers;
+  for (unsigned int k = 0; k < NUMBER_OF_STRESS_TEST_CALLERS; ++k)
+  {
+    callers.push_back(std::async(std::launch::async, [&manager, &terminate, k]() {
+      std::mt19937 generator(k);
+      std::size_t number_of_holds{ 0 };
+      while (!terminate)
+      {
+        switch (generator() % 3)
+        {
+          case 0:
+            manager.startEvent();
+            break;
+          case 1:
+            manager.stopEvent();
+            break;
+          default:
+            HoldModeListener listener;
+            manager.stopEvent(&listener);
+            listener.wait();
+            ++number_of_holds;
+        }
+      }
+      return number_of_holds;
+    }));
+  }
+
+  std::this_thread::sleep_for(STRESS_TEST_DURATION);
+  terminate = true;
+  // The reader keeps finishing stop motions, hence all waiting callers return
+  for (auto& caller : callers)
+  {
+    EXPECT_EQ(std::future_status::ready, caller.wait_for(std::chrono::seconds(WAIT_FOR_RESULT_TIMEOUT)))
+        << "A caller is still waiting for the hold mode";
+  }
+  terminate_reader = true;
+  reader.join();
+  for (auto& caller : callers)
+  {
+    EXPECT_GT(caller.get(), 0u);
+  }
+
+  EXPECT_GT(number_of_reads, 0u);
+  EXPECT_EQ(0u, number_of_invalid_modes);
+
+  manager.stopEvent();
+  manager.stopMotionFinishedEvent();
+  EXPECT_EQ(manager.getCurrentMode(), TrajProcessingMode::hold);
+  EXPECT_TRUE(manager.startEvent());
+}
+
 }  // namespace pilz_joint_trajectory_controller
 
 int main(int argc, char* argv[])
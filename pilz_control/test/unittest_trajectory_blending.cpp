@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <joint_trajectory_controller/joint_trajectory_segment.h>
+#include <trajectory_interface/quintic_spline_segment.h>
+
+#include <pilz_control/trajectory_blending.h>
+
+namespace pilz_joint_trajectory_controller
+{
+using SegmentImpl = trajectory_interface::QuinticSplineSegment<double>;
+using Segment = joint_trajectory_controller::JointTrajectorySegment<SegmentImpl>;
+using TrajectoryPerJoint = std::vector<Segment>;
+using Trajectory = std::vector<TrajectoryPerJoint>;
+
+static constexpr std::size_t NUMBER_OF_JOINTS{ 2 };
+static constexpr double EPSILON{ 1e-9 };
+static constexpr double CONTINUITY_TOLERANCE{ 1e-6 };
+static constexpr double SEGMENT_DURATION{ 1.0 };
+static const std::vector<double> NO_LIMITS(NUMBER_OF_JOINTS, std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Create a trajectory, which moves all joints at rest through the given positions, one segment per move.
+ */
+static Trajectory createTrajectory(const double& start_time, const std::vector<double>& positions)
+{
+  Trajectory trajectory(NUMBER_OF_JOINTS);
+  Segment::State start_state(1);
+  Segment::State end_state(1);
+  for (std::size_t k = 0; k + 1 < positions.size(); ++k)
+  {
+    start_state.position[0] = positions[k];
+    end_state.position[0] = positions[k + 1];
+    const double segment_start_time{ start_time + static_cast<double>(k) * SEGMENT_DURATION };
+    for (auto& joint_trajectory : trajectory)
+    {
+      joint_trajectory.emplace_back(segment_start_time, start_state, segment_start_time + SEGMENT_DURATION, end_state);
+    }
+  }
+  return trajectory;
+}
+
+static Segment::State sample(const Trajectory& trajectory, const std::size_t& joint, const double& time)
+{
+  Segment::State state(1);
+  trajectory_interface::sample(trajectory.at(joint), time, state);
+  return state;
+}
+
+TEST(TrajectoryBlendingTest, testInvalidTrajectories)
+{
+  const Trajectory trajectory{ createTrajectory(0.0, { 0.0, 1.0 }) };
+  EXPECT_TRUE(appendTrajectory(Trajectory(), trajectory, 0.0, 0.0, 0.0, NO_LIMITS, NO_LIMITS).empty());
+  EXPECT_TRUE(appendTrajectory(trajectory, Trajectory(), 0.0, 0.0, 0.0, NO_LIMITS, NO_LIMITS).empty());
+  EXPECT_TRUE(appendTrajectory(trajectory, Trajectory(1, trajectory.front()), 0.0, 0.0, 0.0, NO_LIMITS, NO_LIMITS)
+                  .empty())
+      << "Number of joints differs";
+  EXPECT_TRUE(
+      appendTrajectory(trajectory, Trajectory(NUMBER_OF_JOINTS), 0.0, 0.0, 0.0, NO_LIMITS, NO_LIMITS).empty());
+  EXPECT_TRUE(appendTrajectory(trajectory, trajectory, 0.0, 0.0, 0.0, {}, {}).empty())
+      << "Limits of all joints missing";
+}
+
+TEST(TrajectoryBlendingTest, testAppendWithoutBlending)
+{
+  const Trajectory curr_traj{ createTrajectory(0.0, { 0.0, 1.0, 2.0 }) };
+  const Trajectory next_traj{ createTrajectory(2.0, { 2.0, 1.0 }) };
+
+  const Trajectory result{ appendTrajectory(curr_traj, next_traj, 0.5, 0.0, 0.5, NO_LIMITS, NO_LIMITS) };
+  ASSERT_EQ(NUMBER_OF_JOINTS, result.size());
+  for (std::size_t i = 0; i < NUMBER_OF_JOINTS; ++i)
+  {
+    EXPECT_EQ(3u, result.at(i).size());
+    EXPECT_NEAR(1.5, sample(result, i, 1.5).position.at(0), EPSILON);
+    EXPECT_NEAR(2.0, sample(result, i, 2.0).position.at(0), EPSILON);
+    EXPECT_NEAR(0.0, sample(result, i, 2.0).velocity.at(0), EPSILON) << "Robot must stop at the junction";
+    EXPECT_NEAR(1.0, sample(result, i, 3.0).position.at(0), EPSILON);
+  }
+}
+
+TEST(TrajectoryBlendingTest, testFinishedSegmentsDropped)
+{
+  const Trajectory curr_traj{ createTrajectory(0.0, { 0.0, 1.0, 2.0, 3.0 }) };
+  const Trajectory next_traj{ createTrajectory(3.0, { 3.0, 4.0 }) };
+
+  const Trajectory result{ appendTrajectory(curr_traj, next_traj, 1.5, 0.0, 1.5, NO_LIMITS, NO_LIMITS) };
+  ASSERT_EQ(NUMBER_OF_JOINTS, result.size());
+  EXPECT_EQ(3u, result.front().size());
+  EXPECT_NEAR(1.0, result.front().front().startTime(), EPSILON) << "Segment active at the given time must be kept";
+}
+
+/**
+ * @brief Check that the blend is continuous and the robot does not stop at the junction.
+ */
+TEST(TrajectoryBlendingTest, testBlending)
+{
+  static constexpr double BLEND_RADIUS{ 0.5 };
+  const Trajectory curr_traj{ createTrajectory(0.0, { 0.0, 1.0, 2.0 }) };
+  const Trajectory next_traj{ createTrajectory(2.0, { 2.0, 3.0, 4.0 }) };
+
+  const Trajectory result{ appendTrajectory(curr_traj, next_traj, 0.0, BLEND_RADIUS, 0.0, NO_LIMITS, NO_LIMITS) };
+  ASSERT_EQ(NUMBER_OF_JOINTS, result.size());
+
+  // Blend from the radius around the junction to the end of the first segment of the next trajectory
+  const Segment& blend_segment{ result.front().at(2) };
+  EXPECT_GT(blend_segment.startTime(), 1.0);
+  EXPECT_LT(blend_segment.startTime(), 2.0);
+  EXPECT_NEAR(3.0, blend_segment.endTime(), EPSILON);
+  EXPECT_EQ(4u, result.front().size());
+
+  for (std::size_t i = 0; i < NUMBER_OF_JOINTS; ++i)
+  {
+    const double blend_start_time{ result.at(i).at(2).startTime() };
+    const Segment::State before_blend{ sample(curr_traj, i, blend_start_time) };
+    const Segment::State blend_start{ sample(result, i, blend_start_time) };
+    EXPECT_NEAR(before_blend.position.at(0), blend_start.position.at(0), CONTINUITY_TOLERANCE);
+    EXPECT_NEAR(before_blend.velocity.at(0), blend_start.velocity.at(0), CONTINUITY_TOLERANCE);
+    EXPECT_NEAR(before_blend.acceleration.at(0), blend_start.acceleration.at(0), CONTINUITY_TOLERANCE);
+    EXPECT_LE(BLEND_RADIUS * M_SQRT1_2, 2.0 - blend_start.position.at(0) + CONTINUITY_TOLERANCE);
+
+    EXPECT_GT(std::abs(sample(result, i, 2.0).velocity.at(0)), 0.0) << "Robot must not stop at the junction";
+    EXPECT_NEAR(3.0, sample(result, i, 3.0).position.at(0), EPSILON);
+    EXPECT_NEAR(4.0, sample(result, i, 4.0).position.at(0), EPSILON);
+  }
+}
+
+TEST(TrajectoryBlendingTest, testBlendDoesNotStartBeforeMinStartTime)
+{
+  static constexpr double MIN_BLEND_START_TIME{ 1.9 };
+  const Trajectory curr_traj{ createTrajectory(0.0, { 0.0, 1.0, 2.0 }) };
+  const Trajectory next_traj{ createTrajectory(2.0, { 2.0, 3.0 }) };
+
+  const Trajectory result{
+    appendTrajectory(curr_traj, next_traj, 0.0, 0.5, MIN_BLEND_START_TIME, NO_LIMITS, NO_LIMITS)
+  };
+  ASSERT_EQ(NUMBER_OF_JOINTS, result.size());
+  EXPECT_NEAR(MIN_BLEND_START_TIME, result.front().back().startTime(), EPSILON);
+}
+
+TEST(TrajectoryBlendingTest, testNoBlendingAfterTrajectoryEnd)
+{
+  const Trajectory curr_traj{ createTrajectory(0.0, { 0.0, 1.0 }) };
+  const Trajectory next_traj{ createTrajectory(1.0, { 1.0, 2.0 }) };
+
+  const Trajectory result{ appendTrajectory(curr_traj, next_traj, 1.5, 0.5, 1.5, NO_LIMITS, NO_LIMITS) };
+  ASSERT_EQ(NUMBER_OF_JOINTS, result.size());
+  EXPECT_EQ(2u, result.front().size());
+  EXPECT_NEAR(1.0, result.front().back().startTime(), EPSILON);
+}
+
+/**
+ * @brief Blend the trajectories of testBlending() with the given limits.
+ *
+ * The blend segment reaches an acceleration of about 2.3rad/s^2 and a jerk of about 12rad/s^3.
+ */
+static Trajectory blendWithLimits(const double& max_acceleration, const double& max_jerk)
+{
+  const Trajectory curr_traj{ createTrajectory(0.0, { 0.0, 1.0, 2.0 }) };
+  const Trajectory next_traj{ createTrajectory(2.0, { 2.0, 3.0, 4.0 }) };
+  return appendTrajectory(curr_traj, next_traj, 0.0, 0.5, 0.0, std::vector<double>(NUMBER_OF_JOINTS, max_acceleration),
+                          std::vector<double>(NUMBER_OF_JOINTS, max_jerk));
+}
+
+TEST(TrajectoryBlendingTest, testBlendingWithinLimits)
+{
+  const Trajectory result{ blendWithLimits(2.5, 15.0) };
+  ASSERT_EQ(NUMBER_OF_JOINTS, result.size());
+  EXPECT_EQ(4u, result.front().size());
+  EXPECT_GT(std::abs(sample(result, 0, 2.0).velocity.at(0)), 0.0) << "Robot must not stop at the junction";
+}
+
+/**
+ * @brief Check that the trajectories are appended without blending, if the blend exceeds a limit of a joint.
+ */
+TEST(TrajectoryBlendingTest, testNoBlendingIfLimitsExceeded)
+{
+  const Trajectory acceleration_limited{ blendWithLimits(2.0, 15.0) };
+  const Trajectory jerk_limited{ blendWithLimits(2.5, 10.0) };
+  for (const auto& result : { acceleration_limited, jerk_limited })
+  {
+    ASSERT_EQ(NUMBER_OF_JOINTS, result.size());
+    EXPECT_EQ(4u, result.front().size());
+    EXPECT_NEAR(1.0, result.front().at(1).startTime(), EPSILON) << "Segment replaced by a blend";
+    EXPECT_NEAR(0.0, sample(result, 0, 2.0).velocity.at(0), EPSILON) << "Robot must stop at the junction";
+  }
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <joint_trajectory_controller/joint_trajectory_segment.h>
+#include <trajectory_interface/quintic_spline_segment.h>
+
+#include <pilz_control/trajectory_pool.h>
+
+namespace pilz_joint_trajectory_controller
+{
+using SegmentImpl = trajectory_interface::QuinticSplineSegment<double>;
+using Segment = joint_trajectory_controller::JointTrajectorySegment<SegmentImpl>;
+using Pool = TrajectoryPool<Segment>;
+
+static constexpr std::size_t POOL_CAPACITY{ 2 };
+static constexpr std::size_t NUMBER_OF_JOINTS{ 3 };
+
+static Pool::Trajectory createTrajectory(const std::size_t& number_of_segments)
+{
+  const Segment::State state(1);
+  return Pool::Trajectory(NUMBER_OF_JOINTS, std::vector<Segment>(number_of_segments, Segment(0.0, state, 1.0, state)));
+}
+
+TEST(TrajectoryPoolTest, testAcquireMovesTrajectory)
+{
+  Pool pool(POOL_CAPACITY);
+  EXPECT_EQ(POOL_CAPACITY, pool.getCapacity());
+
+  Pool::Trajectory original{ createTrajectory(3) };
+  const Segment* segments{ original.front().data() };
+  const Pool::TrajectoryPtr trajectory{ pool.acquire(std::move(original)) };
+  ASSERT_TRUE(trajectory);
+  ASSERT_EQ(NUMBER_OF_JOINTS, trajectory->size());
+  EXPECT_EQ(3u, trajectory->front().size());
+  EXPECT_EQ(segments, trajectory->front().data()) << "Trajectory was copied instead of moved";
+}
+
+TEST(TrajectoryPoolTest, testTrajectoryInUseIsNotReturned)
+{
+  Pool pool(POOL_CAPACITY);
+  const Pool::TrajectoryPtr first{ pool.acquire(createTrajectory(1)) };
+  const Pool::TrajectoryPtr second{ pool.acquire(createTrajectory(1)) };
+  EXPECT_NE(first, second);
+  EXPECT_EQ(0u, pool.getNumberOfFallbackAllocations());
+}
+
+/**
+ * @brief Check that the pool keeps a released trajectory until its slot is reused.
+ */
+TEST(TrajectoryPoolTest, testReleasedTrajectoryIsKeptUntilReuse)
+{
+  Pool pool(1);
+  Pool::TrajectoryPtr trajectory{ pool.acquire(createTrajectory(2)) };
+  const Pool::Trajectory* slot{ trajectory.get() };
+  const std::weak_ptr<Pool::Trajectory> released{ trajectory };
+  trajectory.reset();
+  ASSERT_FALSE(released.expired()) << "Last reference was released outside of the pool";
+  EXPECT_EQ(2u, slot->front().size());
+
+  trajectory = pool.acquire(createTrajectory(1));
+  EXPECT_EQ(slot, trajectory.get());
+  EXPECT_EQ(1u, trajectory->front().size());
+  EXPECT_EQ(0u, pool.getNumberOfFallbackAllocations());
+}
+
+TEST(TrajectoryPoolTest, testFallbackIfExhausted)
+{
+  Pool pool(POOL_CAPACITY);
+  std::vector<Pool::TrajectoryPtr> trajectories;
+  for (std::size_t k = 0; k <= POOL_CAPACITY; ++k)
+  {
+    trajectories.push_back(pool.acquire(createTrajectory(1)));
+    ASSERT_TRUE(trajectories.back());
+    EXPECT_EQ(NUMBER_OF_JOINTS, trajectories.back()->size());
+  }
+  EXPECT_EQ(1u, pool.getNumberOfFallbackAllocations());
+}
+
+TEST(TrajectoryPoolTest, testZeroCapacity)
+{
+  Pool pool(0);
+  const Pool::TrajectoryPtr trajectory{ pool.acquire(createTrajectory(1)) };
+  ASSERT_TRUE(trajectory);
+  EXPECT_EQ(NUMBER_OF_JOINTS, trajectory->size());
+  EXPECT_EQ(1u, pool.getNumberOfFallbackAllocations());
+}
+
+}  // namespace pilz_joint_trajectory_controller
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <pilz_control/triple_buffer.h>
+
+namespace pilz_control
+{
+static constexpr std::size_t VALUE_SIZE{ 64 };
+static constexpr int NUMBER_OF_WRITES{ 10000 };
+
+TEST(TripleBufferTest, testInitialValue)
+{
+  TripleBuffer<int> buffer{ 42 };
+  EXPECT_EQ(42, buffer.readFromRT());
+  EXPECT_EQ(42, buffer.readFromRT());
+}
+
+TEST(TripleBufferTest, testReadLatestValue)
+{
+  TripleBuffer<int> buffer{ 0 };
+  buffer.writeFromNonRT(1);
+  EXPECT_EQ(1, buffer.readFromRT());
+
+  buffer.writeFromNonRT(2);
+  buffer.writeFromNonRT(3);
+  EXPECT_EQ(3, buffer.readFromRT()) << "Intermediate values must be skipped";
+  EXPECT_EQ(3, buffer.readFromRT()) << "Value must remain without new write";
+}
+
+/**
+ * @brief Check that the value read by the realtime thread stays untouched by subsequent writes.
+ */
+TEST(TripleBufferTest, testReadValueStable)
+{
+  TripleBuffer<int> buffer{ 0 };
+  buffer.writeFromNonRT(1);
+  const int& value{ buffer.readFromRT() };
+  for (int i = 2; i < 10; ++i)
+  {
+    buffer.writeFromNonRT(i);
+    EXPECT_EQ(1, value);
+  }
+  EXPECT_EQ(9, buffer.readFromRT());
+}
+
+/**
+ * @brief Write vectors of equal entries concurrently to reading, a torn (mixed) value must never be observed.
+ */
+TEST(TripleBufferTest, testConcurrentWriteAndRead)
+{
+  TripleBuffer<std::vector<int>> buffer{ std::vector<int>(VALUE_SIZE, 0) };
+  std::atomic<bool> writing_finished{ false };
+
+  std::thread writer([&buffer, &writing_finished]() {
+    for (int i = 1; i <= NUMBER_OF_WRITES; ++i)
+    {
+      buffer.writeFromNonRT(std::vector<int>(VALUE_SIZE, i));
+    }
+    writing_finished = true;
+  });
+
+  int last_value{ 0 };
+  bool finished{ false };
+  while (!finished)
+  {
+    finished = writing_finished;
+    const std::vector<int>& value{ buffer.readFromRT() };
+    for (const auto& entry : value)
+    {
+      ASSERT_EQ(value.front(), entry) << "Torn value read";
+    }
+    ASSERT_GE(value.front(), last_value) << "Older value read";
+    last_value = value.front();
+  }
+  writer.join();
+
+  EXPECT_EQ(NUMBER_OF_WRITES, buffer.readFromRT().front());
+}
+
+}  // namespace pilz_control
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
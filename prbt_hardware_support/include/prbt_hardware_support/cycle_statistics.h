@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRBT_HARDWARE_SUPPORT_CYCLE_STATISTICS_H
+#define PRBT_HARDWARE_SUPPORT_CYCLE_STATISTICS_H
+
+#include <chrono>
+#include <cstddef>
+
+namespace prbt_hardware_support
+{
+/**
+ * @brief Timing statistics of a periodic loop.
+ *
+ * For each cycle the period (time since the start of the last cycle), the jitter (delay of the start with respect to
+ * its deadline) and whether the cycle overran its period are recorded.
+ */
+class CycleStatistics
+{
+public:
+  using Duration = std::chrono::nanoseconds;
+
+  /**
+   * @brief Add the timing of a cycle.
+   * @param period Time since the start of the last cycle.
+   * @param jitter Delay of the start of the cycle with respect to its deadline.
+   * @param overrun True if the cycle did not finish before its next deadline.
+   */
+  void addCycle(const Duration& period, const Duration& jitter, const bool overrun);
+
+  //! @brief Add all cycles recorded by other statistics.
+  void add(const CycleStatistics& other);
+
+  //! @brief Remove all recorded cycles.
+  void reset();
+
+  std::size_t getNumberOfCycles() const;
+  std::size_t getNumberOfOverruns() const;
+
+  //! @brief Zero if no cycle was recorded.
+  Duration getMinPeriod() const;
+  Duration getMaxPeriod() const;
+  Duration getMeanPeriod() const;
+
+  Duration getMaxJitter() const;
+  Duration getMeanJitter() const;
+
+private:
+  std::size_t number_of_cycles_{ 0 };
+  std::size_t number_of_overruns_{ 0 };
+  Duration min_period_{ Duration::zero() };
+  Duration max_period_{ Duration::zero() };
+  Duration period_sum_{ Duration::zero() };
+  Duration max_jitter_{ Duration::zero() };
+  Duration jitter_sum_{ Duration::zero() };
+};
+
+inline std::size_t CycleStatistics::getNumberOfCycles() const
+{
+  return number_of_cycles_;
+}
+
+inline std::size_t CycleStatistics::getNumberOfOverruns() const
+{
+  return number_of_overruns_;
+}
+
+inline CycleStatistics::Duration CycleStatistics::getMinPeriod() const
+{
+  return min_period_;
+}
+
+inline CycleStatistics::Duration CycleStatistics::getMaxPeriod() const
+{
+  return max_period_;
+}
+
+inline CycleStatistics::Duration CycleStatistics::getMaxJitter() const
+{
+  return max_jitter_;
+}
+
+}  // namespace prbt_hardware_support
+
+#endif  // PRBT_HARDWARE_SUPPORT_CYCLE_STATISTICS_H
@@ -53,6 +53,13 @@ public:
   RegCont writeReadHoldingRegister(const int write_addr, const RegCont& write_reg, const int read_addr,
                                    const int read_nb) override;
 
+  //! @brief See base class. Reads directly into the given buffer.
+  void readHoldingRegisterInto(int addr, int nb, uint16_t* dest) override;
+
+  //! @brief See base class. Reads directly into the given buffer.
+  void writeReadHoldingRegisterInto(const int write_addr, const RegCont& write_reg, const int read_addr,
+                                    const int read_nb, uint16_t* dest) override;
+
   /**
    * @brief Close connection with server
    */
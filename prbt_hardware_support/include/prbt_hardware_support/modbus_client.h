@@ -18,6 +18,8 @@
 #ifndef MODBUS_CLIENT_H
 #define MODBUS_CLIENT_H
 
+#include <algorithm>
+#include <cstddef>
 #include <vector>
 #include <cstdint>
 
@@ -25,6 +27,17 @@
 
 namespace prbt_hardware_support
 {
+/**
+ * @brief Block of holding registers which is read with a single request into a preallocated buffer.
+ */
+struct ModbusReadRequest
+{
+  int addr;
+  int nb;
+  //! Buffer with space for at least nb registers.
+  uint16_t* dest;
+};
+
 class ModbusClient
 {
 public:
@@ -72,6 +85,77 @@ public:
 
   virtual RegCont writeReadHoldingRegister(const int write_addr, const RegCont& write_reg, const int read_addr,
                                            const int read_nb) = 0;
+
+  /**
+   * @brief Read the holding registers into a preallocated buffer
+   *
+   * The default implementation copies the result of readHoldingRegister(), implementations should override it if
+   * they are able to read without allocating.
+   *
+   * @param dest buffer with space for at least nb registers
+   * @throw ModbusExceptionDisconnect if a disconnect from the server happens
+   */
+  virtual void readHoldingRegisterInto(int addr, int nb, uint16_t* dest)
+  {
+    copyRegisters(readHoldingRegister(addr, nb), nb, dest);
+  }
+
+  /**
+   * @brief Write and read the holding registers, the read registers are stored in a preallocated buffer
+   *
+   * @param dest buffer with space for at least read_nb registers
+   * @see readHoldingRegisterInto()
+   */
+  virtual void writeReadHoldingRegisterInto(const int write_addr, const RegCont& write_reg, const int read_addr,
+                                            const int read_nb, uint16_t* dest)
+  {
+    copyRegisters(writeReadHoldingRegister(write_addr, write_reg, read_addr, read_nb), read_nb, dest);
+  }
+
+  /**
+   * @brief Read several blocks of holding registers
+   *
+   * The default implementation reads the blocks one after the other. Implementations should override it if they are
+   * able to send all requests without waiting for the responses.
+   *
+   * @throw ModbusExceptionDisconnect if a disconnect from the server happens
+   */
+  virtual void readHoldingRegisterBlocks(const std::vector<ModbusReadRequest>& requests)
+  {
+    for (const auto& request : requests)
+    {
+      readHoldingRegisterInto(request.addr, request.nb, request.dest);
+    }
+  }
+
+  /**
+   * @brief Write the holding registers and read several blocks of holding registers
+   *
+   * The registers are written together with the first block, hence at least one block has to be given.
+   *
+   * @see readHoldingRegisterBlocks()
+   */
+  virtual void writeReadHoldingRegisterBlocks(const int write_addr, const RegCont& write_reg,
+                                              const std::vector<ModbusReadRequest>& requests)
+  {
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+      if (i == 0)
+      {
+        writeReadHoldingRegisterInto(write_addr, write_reg, requests[i].addr, requests[i].nb, requests[i].dest);
+      }
+      else
+      {
+        readHoldingRegisterInto(requests[i].addr, requests[i].nb, requests[i].dest);
+      }
+    }
+  }
+
+private:
+  static void copyRegisters(const RegCont& registers, const int nb, uint16_t* dest)
+  {
+    std::copy_n(registers.begin(), std::min(registers.size(), static_cast<RegCont::size_type>(std::max(nb, 0))), dest);
+  }
 };
 
 }  // namespace prbt_hardware_support
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRBT_HARDWARE_SUPPORT_MODBUS_READ_PLAN_H
+#define PRBT_HARDWARE_SUPPORT_MODBUS_READ_PLAN_H
+
+#include <cstddef>
+#include <vector>
+
+#include <prbt_hardware_support/register_container.h>
+
+namespace prbt_hardware_support
+{
+//! Max number of registers which can be read with a single request, limited by the size of a Modbus PDU.
+static constexpr int MODBUS_READ_REQUEST_MAX_REGISTERS{ 125 };
+
+/**
+ * @brief Consecutive registers which are read with a single modbus request.
+ */
+struct ModbusReadBlock
+{
+  int first_register;
+  int number_of_registers;
+  //! Position of the first register of the block within the register image.
+  std::size_t image_offset;
+};
+
+/**
+ * @brief Registers within the register image, which are read but not requested.
+ */
+struct ModbusImageGap
+{
+  std::size_t image_offset;
+  std::size_t number_of_registers;
+};
+
+/**
+ * @brief Costs used to decide whether two blocks are read with a single request.
+ *
+ * Two blocks are merged if reading the registers between them is cheaper than an additional request. Both costs have
+ * to be given in the same unit, e.g. the round trip time and the transfer time of a register in microseconds.
+ *
+ * By default no blocks are merged, since the registers between them might not be readable on the modbus server.
+ */
+struct ModbusReadCostModel
+{
+  //! Cost of an additional request.
+  double request_cost{ 0.0 };
+  //! Cost of reading one additional register.
+  double register_cost{ 1.0 };
+};
+
+/**
+ * @brief Describes how the registers read by PilzModbusClient are requested from the modbus server.
+ *
+ * The register image covers all registers from the lowest to the highest register which has to be read. Each block is
+ * read directly into its part of the image, registers between the blocks stay zero.
+ *
+ * Blocks are merged according to the given cost model, as long as a block does not exceed
+ * MODBUS_READ_REQUEST_MAX_REGISTERS. Longer blocks are split. Registers which are read due to a merge but not requested
+ * are reported as gaps, in order to reset them after each read.
+ *
+ * The plan is immutable, hence it is computed once and the polling loop does not have to split the registers again.
+ */
+class ModbusReadPlan
+{
+public:
+  /**
+   * @param blocks Consecutive groups of registers in ascending order, see PilzModbusClient::splitIntoBlocks().
+   * @param cost_model Decides which blocks are read with a single request.
+   * @throw PilzModbusClientException if there are no registers to read.
+   */
+  explicit ModbusReadPlan(const std::vector<std::vector<unsigned short>>& blocks,
+                          const ModbusReadCostModel& cost_model = ModbusReadCostModel());
+
+  const std::vector<ModbusReadBlock>& getBlocks() const;
+
+  //! @brief Registers which are read but were not requested.
+  const std::vector<ModbusImageGap>& getGaps() const;
+
+  //! @brief Register which corresponds to the first element of the register image.
+  unsigned short getFirstRegister() const;
+
+  std::size_t getImageSize() const;
+
+  //! @brief Create a register image of the correct size, filled with zeros.
+  RegCont createImage() const;
+
+private:
+  std::vector<ModbusReadBlock> blocks_;
+  std::vector<ModbusImageGap> gaps_;
+  unsigned short first_register_{ 0 };
+  std::size_t image_size_{ 0 };
+};
+
+inline const std::vector<ModbusReadBlock>& ModbusReadPlan::getBlocks() const
+{
+  return blocks_;
+}
+
+inline const std::vector<ModbusImageGap>& ModbusReadPlan::getGaps() const
+{
+  return gaps_;
+}
+
+inline unsigned short ModbusReadPlan::getFirstRegister() const
+{
+  return first_register_;
+}
+
+inline std::size_t ModbusReadPlan::getImageSize() const
+{
+  return image_size_;
+}
+
+inline RegCont ModbusReadPlan::createImage() const
+{
+  return RegCont(image_size_, 0);
+}
+
+}  // namespace prbt_hardware_support
+
+#endif  // PRBT_HARDWARE_SUPPORT_MODBUS_READ_PLAN_H
@@ -25,6 +25,7 @@ namespace prbt_hardware_support
 // Topic names
 static const std::string TOPIC_MODBUS_READ = "/pilz_modbus_client_node/modbus_read";
 static const std::string SERVICE_MODBUS_WRITE = "/pilz_modbus_client_node/modbus_write";
+static const std::string TOPIC_DIAGNOSTICS = "/diagnostics";
 
 }  // namespace prbt_hardware_support
 #endif  // PRBT_HARDWARE_SUPPORT_COMMON_H
@@ -31,6 +31,13 @@ static const std::string PARAM_INDEX_OF_FIRST_REGISTER_TO_READ_STR{ "index_of_fi
 static const std::string PARAM_NUM_REGISTERS_TO_READ_STR{ "num_registers_to_read" };
 static const std::string PARAM_MODBUS_CONNECTION_RETRIES{ "modbus_connection_retries" };
 static const std::string PARAM_MODBUS_CONNECTION_RETRY_TIMEOUT{ "modbus_connection_retry_timeout" };
+static const std::string PARAM_MODBUS_READ_REQUEST_COST{ "modbus_read_request_cost" };
+static const std::string PARAM_MODBUS_READ_REGISTER_COST{ "modbus_read_register_cost" };
+static const std::string PARAM_MODBUS_PIPELINING{ "modbus_pipelining" };
+static const std::string PARAM_MODBUS_PUBLISH_ON_CHANGE{ "modbus_publish_on_change" };
+static const std::string PARAM_MODBUS_HEARTBEAT_PERIOD{ "modbus_heartbeat_period" };
+static const std::string PARAM_MODBUS_POLL_THREAD_PRIORITY{ "modbus_poll_thread_priority" };
+static const std::string PARAM_MODBUS_POLL_THREAD_CPU{ "modbus_poll_thread_cpu" };
 
 }  // namespace prbt_hardware_support
 
@@ -25,14 +25,28 @@
 #include <boost/optional.hpp>
 
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
 #include <std_msgs/UInt16MultiArray.h>
 
+#include <prbt_hardware_support/cycle_statistics.h>
 #include <prbt_hardware_support/modbus_client.h>
+#include <prbt_hardware_support/modbus_read_plan.h>
 #include <prbt_hardware_support/register_container.h>
 #include <prbt_hardware_support/WriteModbusRegister.h>
 
 namespace prbt_hardware_support
 {
+/**
+ * @brief Scheduling of the thread which polls the modbus server.
+ */
+struct PollThreadConfig
+{
+  //! SCHED_FIFO priority (1-99) of the thread, 0 keeps the default scheduling.
+  int priority{ 0 };
+  //! CPU to which the thread is pinned, -1 disables the pinning.
+  int cpu{ -1 };
+};
+
 /**
  * @brief Connects to a modbus server and publishes the received data into ROS.
  */
@@ -78,11 +92,18 @@ public:
   /**
    * @brief Publishes the register values as messages.
    *
-   * The value of the modbus register is read in a loop.
+   * The value of the modbus register is read in a loop on a dedicated thread, which only serves to apply the
+   * scheduling set via 'setPollThreadConfig()'. This call still blocks its caller until the loop ends (see
+   * 'terminate()').
+   * Each cycle starts at an absolute deadline, hence the time spent in a cycle does not delay the following cycles.
+   * The write service is handled by a separate spinner and does not run on the polling thread.
    * Once a loop the value is published as a message.
    * In order for clients to differentiate between messages notifying about
    * changes in the register the timestamp of the message is only changed
    * if a register value changed.
+   *
+   * If publishing on change is enabled (see 'setPublishOnChange()'), a message is only published if a register value
+   * changed, on a disconnect or when the heartbeat period elapsed since the last message.
    */
   void run();
 
@@ -97,6 +118,32 @@ public:
    */
   bool isRunning();
 
+  /**
+   * @brief Set the costs which decide whether the registers between two blocks are read in order to save a request.
+   *
+   * Takes effect with the next call to 'run()'.
+   */
+  void setReadCostModel(const ModbusReadCostModel& read_cost_model);
+
+  /**
+   * @brief Only publish a message if a register value changed, instead of once per read cycle.
+   *
+   * Liveness: As long as the client is running, a message is published at least once per heartbeat period. The
+   * heartbeat repeats the last message including its timestamp, so it is dropped by the UpdateFilter like an
+   * unchanged message. A disconnect is always published immediately. A zero heartbeat period disables the heartbeat.
+   *
+   * Takes effect with the next call to 'run()'.
+   */
+  void setPublishOnChange(const ros::Duration& heartbeat_period);
+
+  /**
+   * @brief Set the scheduling of the polling thread.
+   *
+   * If the scheduling cannot be applied (e.g. missing permissions for SCHED_FIFO) a warning is shown and the loop
+   * runs with the default scheduling. Takes effect with the next call to 'run()'.
+   */
+  void setPollThreadConfig(const PollThreadConfig& poll_thread_config);
+
   /**
    * @brief Splits a vector of integers into a vector of vectors with consecutive groups
    */
@@ -105,6 +152,15 @@ public:
 private:
   void sendDisconnectMsg();
 
+  //! @brief Reads the registers in a loop until terminated or disconnected.
+  void poll(const ModbusReadPlan& read_plan);
+
+  //! @brief Apply the configured scheduling to the calling thread.
+  void configurePollThread();
+
+  //! @brief Publishes the timing statistics of the polling loop since the last call.
+  void publishDiagnostics(const ros::WallTimerEvent& event);
+
   /**
    * @brief Stores the register which have to be send to the modbus server
    * in a local buffer for further processing by the modbus thread.
@@ -125,6 +181,14 @@ private:
 
   //! Registers which have to be read.
   std::vector<unsigned short> registers_to_read_;
+  //! Decides which blocks of registers are read with a single request.
+  ModbusReadCostModel read_cost_model_;
+  //! Publish only if a register value changed or the heartbeat period elapsed.
+  bool publish_on_change_{ false };
+  //! Max time between two messages, if only changes are published.
+  ros::Duration heartbeat_period_;
+  //! Scheduling of the polling thread.
+  PollThreadConfig poll_thread_config_;
 
   //! Defines how long we wait for a response from the Modbus-server.
   const unsigned int RESPONSE_TIMEOUT_MS;
@@ -134,6 +198,8 @@ private:
 private:
   static constexpr double DEFAULT_MODBUS_READ_FREQUENCY_HZ{ 500 };
   static constexpr int DEFAULT_QUEUE_SIZE_MODBUS{ 1 };
+  static constexpr int DEFAULT_QUEUE_SIZE_DIAGNOSTICS{ 1 };
+  static constexpr double DIAGNOSTICS_PERIOD_S{ 1.0 };
 
 private:
   std::atomic<State> state_{ State::not_initialized };
@@ -141,10 +207,25 @@ private:
   ModbusClientUniquePtr modbus_client_;
   ros::Publisher modbus_read_pub_;
   ros::Subscriber modbus_write_sub_;
+
+  //! Handles the write service and the diagnostics, so that they do not run on the polling thread.
+  ros::CallbackQueue service_queue_;
   ros::ServiceServer modbus_write_service_;
+  ros::Publisher diagnostics_pub_;
+  ros::WallTimer diagnostics_timer_;
 
   std::mutex write_reg_blocks_mutex_;
   std::queue<ModbusRegisterBlock> write_reg_blocks_;
+
+  //! Timing of the polling loop since the diagnostics were published the last time.
+  //! The polling thread only tries to lock the mutex, so it never waits for the diagnostics.
+  std::mutex cycle_statistics_mutex_;
+  CycleStatistics cycle_statistics_;
+  //! Number of overruns since the start of the polling loop.
+  std::size_t total_overruns_{ 0 };
+
+  //! Declared last, so that it is stopped before the members used by the callbacks are destroyed.
+  ros::AsyncSpinner service_spinner_{ 1, &service_queue_ };
 };
 
 inline void PilzModbusClient::terminate()
@@ -152,6 +233,22 @@ inline void PilzModbusClient::terminate()
   stop_run_ = true;
 }
 
+inline void PilzModbusClient::setReadCostModel(const ModbusReadCostModel& read_cost_model)
+{
+  read_cost_model_ = read_cost_model;
+}
+
+inline void PilzModbusClient::setPublishOnChange(const ros::Duration& heartbeat_period)
+{
+  publish_on_change_ = true;
+  heartbeat_period_ = heartbeat_period;
+}
+
+inline void PilzModbusClient::setPollThreadConfig(const PollThreadConfig& poll_thread_config)
+{
+  poll_thread_config_ = poll_thread_config;
+}
+
 inline bool PilzModbusClient::isRunning()
 {
   return state_.load() == State::running;
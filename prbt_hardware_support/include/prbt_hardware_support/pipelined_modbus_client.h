@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRBT_HARDWARE_SUPPORT_PIPELINED_MODBUS_CLIENT_H
+#define PRBT_HARDWARE_SUPPORT_PIPELINED_MODBUS_CLIENT_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <prbt_hardware_support/modbus_client.h>
+
+namespace prbt_hardware_support
+{
+/**
+ * @brief Modbus/TCP client, which sends several requests without waiting for the responses.
+ *
+ * All blocks passed to readHoldingRegisterBlocks() (and the pending write) are sent at once on a non-blocking socket.
+ * The responses are assigned to the requests via their transaction ID, hence reading N blocks takes a single round
+ * trip instead of N. The modbus server has to support multiple outstanding transactions.
+ *
+ * The response timeout applies to all requests sent at once. After an error the connection is closed, because the
+ * remaining responses cannot be assigned reliably any more.
+ */
+class PipelinedModbusClient : public ModbusClient
+{
+public:
+  PipelinedModbusClient();
+
+  //! @brief See base class.
+  virtual ~PipelinedModbusClient() override;
+
+  //! @brief See base class.
+  bool init(const char* ip, unsigned int port) override;
+
+  //! @brief See base class.
+  void setResponseTimeoutInMs(unsigned long timeout_ms) override;
+
+  //! @brief See base class.
+  unsigned long getResponseTimeoutInMs() override;
+
+  //! @brief See base class.
+  RegCont readHoldingRegister(int addr, int nb) override;
+
+  //! @brief See base class.
+  RegCont writeReadHoldingRegister(const int write_addr, const RegCont& write_reg, const int read_addr,
+                                   const int read_nb) override;
+
+  //! @brief See base class.
+  void readHoldingRegisterInto(int addr, int nb, uint16_t* dest) override;
+
+  //! @brief See base class.
+  void writeReadHoldingRegisterInto(const int write_addr, const RegCont& write_reg, const int read_addr,
+                                    const int read_nb, uint16_t* dest) override;
+
+  //! @brief See base class. Sends all requests at once.
+  void readHoldingRegisterBlocks(const std::vector<ModbusReadRequest>& requests) override;
+
+  //! @brief See base class. Sends all requests at once.
+  void writeReadHoldingRegisterBlocks(const int write_addr, const RegCont& write_reg,
+                                      const std::vector<ModbusReadRequest>& requests) override;
+
+  /**
+   * @brief Close connection with server
+   */
+  void close();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  //! @brief Request which was sent and waits for its response.
+  struct Transaction
+  {
+    uint16_t transaction_id;
+    uint8_t function_code;
+    int nb;
+    uint16_t* dest;
+    bool done;
+  };
+
+  //! @brief Throw if not connected and drop the requests of the last transmission.
+  void beginTransmission();
+  void addReadRequest(const ModbusReadRequest& request);
+  void addWriteReadRequest(const int write_addr, const RegCont& write_reg, const ModbusReadRequest& request);
+  void addHeader(const uint8_t function_code, const std::size_t pdu_length, const int nb, uint16_t* dest);
+
+  //! @brief Send all added requests and wait for their responses.
+  void transmit();
+  void sendRequests(const Clock::time_point& deadline);
+  void receiveResponses(const Clock::time_point& deadline);
+  void processResponse(const uint8_t* adu, const std::size_t adu_length);
+  void waitForEvent(const uint32_t events, const Clock::time_point& deadline);
+
+  //! @brief Close the connection and throw a ModbusExceptionDisconnect.
+  [[noreturn]] void fail(const std::string& reason);
+
+private:
+  int socket_{ -1 };
+  int epoll_fd_{ -1 };
+  uint32_t epoll_events_{ 0 };
+  unsigned long response_timeout_ms_{ DEFAULT_RESPONSE_TIMEOUT_MS };
+
+  uint16_t next_transaction_id_{ 0 };
+  std::vector<Transaction> transactions_;
+  std::vector<uint8_t> send_buffer_;
+  std::vector<uint8_t> receive_buffer_;
+
+private:
+  //! Same as the default of libmodbus.
+  static constexpr unsigned long DEFAULT_RESPONSE_TIMEOUT_MS{ 500 };
+  static constexpr int CONNECT_TIMEOUT_MS{ 1000 };
+  //! Unit identifier used by libmodbus for Modbus/TCP.
+  static constexpr uint8_t UNIT_ID{ 0xFF };
+  static constexpr std::size_t MAX_ADU_LENGTH{ 260 };
+  //! Limits of a single request given by the Modbus specification.
+  static constexpr int MAX_READ_REGISTERS{ 125 };
+  static constexpr int MAX_WRITE_READ_WRITE_REGISTERS{ 121 };
+  //! Number of requests sent at once, for which memory is reserved.
+  static constexpr std::size_t RESERVED_TRANSACTIONS{ 16 };
+};
+
+}  // namespace prbt_hardware_support
+
+#endif  // PRBT_HARDWARE_SUPPORT_PIPELINED_MODBUS_CLIENT_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <prbt_hardware_support/cycle_statistics.h>
+
+#include <algorithm>
+
+namespace prbt_hardware_support
+{
+void CycleStatistics::addCycle(const Duration& period, const Duration& jitter, const bool overrun)
+{
+  min_period_ = (number_of_cycles_ == 0) ? period : std::min(min_period_, period);
+  max_period_ = std::max(max_period_, period);
+  period_sum_ += period;
+  max_jitter_ = std::max(max_jitter_, jitter);
+  jitter_sum_ += jitter;
+  if (overrun)
+  {
+    ++number_of_overruns_;
+  }
+  ++number_of_cycles_;
+}
+
+void CycleStatistics::add(const CycleStatistics& other)
+{
+  if (other.number_of_cycles_ == 0)
+  {
+    return;
+  }
+  min_period_ = (number_of_cycles_ == 0) ? other.min_period_ : std::min(min_period_, other.min_period_);
+  max_period_ = std::max(max_period_, other.max_period_);
+  period_sum_ += other.period_sum_;
+  max_jitter_ = std::max(max_jitter_, other.max_jitter_);
+  jitter_sum_ += other.jitter_sum_;
+  number_of_overruns_ += other.number_of_overruns_;
+  number_of_cycles_ += other.number_of_cycles_;
+}
+
+void CycleStatistics::reset()
+{
+  *this = CycleStatistics();
+}
+
+CycleStatistics::Duration CycleStatistics::getMeanPeriod() const
+{
+  if (number_of_cycles_ == 0)
+  {
+    return Duration::zero();
+  }
+  return period_sum_ / static_cast<Duration::rep>(number_of_cycles_);
+}
+
+CycleStatistics::Duration CycleStatistics::getMeanJitter() const
+{
+  if (number_of_cycles_ == 0)
+  {
+    return Duration::zero();
+  }
+  return jitter_sum_ / static_cast<Duration::rep>(number_of_cycles_);
+}
+
+}  // namespace prbt_hardware_support
@@ -17,6 +17,7 @@
 
 #include <ros/ros.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <vector>
 #include <errno.h>
@@ -82,6 +83,13 @@ unsigned long LibModbusClient::getResponseTimeoutInMs()
 }
 
 RegCont LibModbusClient::readHoldingRegister(int addr, int nb)
+{
+  RegCont tab_reg(static_cast<RegCont::size_type>(std::max(nb, 0)));
+  readHoldingRegisterInto(addr, nb, tab_reg.data());
+  return tab_reg;
+}
+
+void LibModbusClient::readHoldingRegisterInto(int addr, int nb, uint16_t* dest)
 {
   ROS_DEBUG("readHoldingRegister()");
   if (modbus_connection_ == nullptr)
@@ -89,10 +97,9 @@ RegCont LibModbusClient::readHoldingRegister(int addr, int nb)
     throw ModbusExceptionDisconnect("Modbus disconnected!");
   }
 
-  RegCont tab_reg(static_cast<RegCont::size_type>(nb));
   int rc{ -1 };
 
-  rc = modbus_read_registers(modbus_connection_, addr, nb, tab_reg.data());
+  rc = modbus_read_registers(modbus_connection_, addr, nb, dest);
   if (rc == -1)
   {
     std::ostringstream err_stream;
@@ -102,12 +109,18 @@ RegCont LibModbusClient::readHoldingRegister(int addr, int nb)
     ROS_ERROR_STREAM_NAMED("LibModbusClient", err_stream.str());
     throw ModbusExceptionDisconnect(err_stream.str());
   }
-
-  return tab_reg;
 }
 
 RegCont LibModbusClient::writeReadHoldingRegister(const int write_addr, const RegCont& write_reg, const int read_addr,
                                                   const int read_nb)
+{
+  RegCont read_reg(static_cast<RegCont::size_type>(std::max(read_nb, 0)));
+  writeReadHoldingRegisterInto(write_addr, write_reg, read_addr, read_nb, read_reg.data());
+  return read_reg;
+}
+
+void LibModbusClient::writeReadHoldingRegisterInto(const int write_addr, const RegCont& write_reg,
+                                                   const int read_addr, const int read_nb, uint16_t* dest)
 {
   if (modbus_connection_ == nullptr)
   {
@@ -118,7 +131,6 @@ RegCont LibModbusClient::writeReadHoldingRegister(const int write_addr, const Re
   {
     throw std::invalid_argument("Argument \"read_nb\" must not be negative");
   }
-  RegCont read_reg(static_cast<RegCont::size_type>(read_nb));
 
   if (write_reg.size() > std::numeric_limits<int>::max())
   {
@@ -127,7 +139,7 @@ RegCont LibModbusClient::writeReadHoldingRegister(const int write_addr, const Re
 
   int rc{ -1 };
   rc = modbus_write_and_read_registers(modbus_connection_, write_addr, static_cast<int>(write_reg.size()),
-                                       write_reg.data(), read_addr, read_nb, read_reg.data());
+                                       write_reg.data(), read_addr, read_nb, dest);
   ROS_DEBUG_NAMED("LibModbusClient", "modbus_write_and_read_registers: writing from %i %i registers\
                                       and reading from %i %i registers",
                   write_addr, static_cast<int>(write_reg.size()), read_addr, read_nb);
@@ -138,8 +150,6 @@ RegCont LibModbusClient::writeReadHoldingRegister(const int write_addr, const Re
     ROS_ERROR_STREAM_NAMED("LibModbusClient", err);
     throw ModbusExceptionDisconnect(err);
   }
-
-  return read_reg;
 }
 
 void LibModbusClient::close()
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <prbt_hardware_support/modbus_read_plan.h>
+
+#include <algorithm>
+
+#include <prbt_hardware_support/pilz_modbus_client_exception.h>
+
+namespace prbt_hardware_support
+{
+ModbusReadPlan::ModbusReadPlan(const std::vector<std::vector<unsigned short>>& blocks,
+                               const ModbusReadCostModel& cost_model)
+{
+  for (const auto& block : blocks)
+  {
+    if (block.empty())
+    {
+      continue;
+    }
+    if (blocks_.empty())
+    {
+      first_register_ = block.front();
+    }
+
+    // Split blocks which do not fit into a single request
+    for (std::size_t i = 0; i < block.size(); i += MODBUS_READ_REQUEST_MAX_REGISTERS)
+    {
+      const int first_register{ static_cast<int>(block.at(i)) };
+      const int number_of_registers{ static_cast<int>(
+          std::min(block.size() - i, static_cast<std::size_t>(MODBUS_READ_REQUEST_MAX_REGISTERS))) };
+      const std::size_t image_offset{ static_cast<std::size_t>(first_register - first_register_) };
+
+      if (!blocks_.empty())
+      {
+        ModbusReadBlock& prev_block{ blocks_.back() };
+        const int gap{ first_register - prev_block.first_register - prev_block.number_of_registers };
+        const int merged_size{ first_register + number_of_registers - prev_block.first_register };
+        if (gap > 0 && merged_size <= MODBUS_READ_REQUEST_MAX_REGISTERS &&
+            gap * cost_model.register_cost < cost_model.request_cost)
+        {
+          gaps_.push_back({ image_offset - static_cast<std::size_t>(gap), static_cast<std::size_t>(gap) });
+          prev_block.number_of_registers = merged_size;
+          image_size_ = image_offset + static_cast<std::size_t>(number_of_registers);
+          continue;
+        }
+      }
+
+      blocks_.push_back({ first_register, number_of_registers, image_offset });
+      image_size_ = image_offset + static_cast<std::size_t>(number_of_registers);
+    }
+  }
+
+  if (blocks_.empty())
+  {
+    throw PilzModbusClientException("No registers to read.");
+  }
+}
+
+}  // namespace prbt_hardware_support
@@ -17,13 +17,54 @@
 
 #include <prbt_hardware_support/pilz_modbus_client.h>
 
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <thread>
+
+#include <diagnostic_msgs/DiagnosticArray.h>
+
 #include <prbt_hardware_support/ModbusMsgInStamped.h>
 #include <prbt_hardware_support/modbus_msg_in_builder.h>
+#include <prbt_hardware_support/modbus_topic_definitions.h>
 #include <prbt_hardware_support/pilz_modbus_exceptions.h>
 #include <prbt_hardware_support/pilz_modbus_client_exception.h>
 
 namespace prbt_hardware_support
 {
+static constexpr int64_t NSEC_PER_SEC{ 1000000000 };
+
+static int64_t monotonicNowNSec()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * NSEC_PER_SEC + now.tv_nsec;
+}
+
+static void sleepUntilNSec(const int64_t deadline_ns)
+{
+  timespec deadline;
+  deadline.tv_sec = static_cast<time_t>(deadline_ns / NSEC_PER_SEC);
+  deadline.tv_nsec = static_cast<long>(deadline_ns % NSEC_PER_SEC);
+  // Restart after signals, the deadline is absolute
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+  {
+  }
+}
+
+static std::string toMicroseconds(const CycleStatistics::Duration& duration)
+{
+  return std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
 PilzModbusClient::PilzModbusClient(ros::NodeHandle& nh, const std::vector<unsigned short>& registers_to_read,
                                    ModbusClientUniquePtr modbus_client, unsigned int response_timeout_ms,
                                    const std::string& modbus_read_topic_name,
@@ -33,9 +74,15 @@ PilzModbusClient::PilzModbusClient(ros::NodeHandle& nh, const std::vector<unsign
   , READ_FREQUENCY_HZ(read_frequency_hz)
   , modbus_client_(std::move(modbus_client))
   , modbus_read_pub_(nh.advertise<ModbusMsgInStamped>(modbus_read_topic_name, DEFAULT_QUEUE_SIZE_MODBUS))
-  , modbus_write_service_(
-        nh.advertiseService(modbus_write_service_name, &PilzModbusClient::modbus_write_service_cb, this))
+  , diagnostics_pub_(nh.advertise<diagnostic_msgs::DiagnosticArray>(TOPIC_DIAGNOSTICS, DEFAULT_QUEUE_SIZE_DIAGNOSTICS))
 {
+  ros::NodeHandle service_nh(nh);
+  service_nh.setCallbackQueue(&service_queue_);
+  modbus_write_service_ =
+      service_nh.advertiseService(modbus_write_service_name, &PilzModbusClient::modbus_write_service_cb, this);
+  diagnostics_timer_ = service_nh.createWallTimer(ros::WallDuration(DIAGNOSTICS_PERIOD_S),
+                                                  &PilzModbusClient::publishDiagnostics, this, false, false);
+  service_spinner_.start();
 }
 
 bool PilzModbusClient::init(const char* ip, unsigned int port, int retries, const ros::Duration& timeout)
@@ -97,11 +144,13 @@ void PilzModbusClient::sendDisconnectMsg()
   msg.disconnect.data = true;
   msg.header.stamp = ros::Time::now();
   modbus_read_pub_.publish(msg);
-  ros::spinOnce();
 }
 
 void PilzModbusClient::run()
 {
+  // The registers do not change, hence the blocks are computed once and not in every cycle
+  const ModbusReadPlan read_plan{ splitIntoBlocks(registers_to_read_), read_cost_model_ };
+
   State expected_state{ State::initialized };
   if (!state_.compare_exchange_strong(expected_state, State::running))
   {
@@ -109,13 +158,71 @@ void PilzModbusClient::run()
     throw PilzModbusClientException("Modbus-client not in correct state.");
   }
 
-  RegCont holding_register;
-  RegCont last_holding_register;
-  ros::Time last_update{ ros::Time::now() };
-  state_ = State::running;
-  ros::Rate rate(READ_FREQUENCY_HZ);
+  {
+    std::lock_guard<std::mutex> lock(cycle_statistics_mutex_);
+    cycle_statistics_.reset();
+    total_overruns_ = 0;
+  }
+  diagnostics_timer_.start();
+
+  // Exceptions cannot leave the thread, hence they are rethrown after it is joined
+  std::exception_ptr poll_exception;
+  std::thread poll_thread([this, &read_plan, &poll_exception]() {
+    try
+    {
+      poll(read_plan);
+    }
+    catch (...)
+    {
+      poll_exception = std::current_exception();
+    }
+  });
+  poll_thread.join();
+
+  diagnostics_timer_.stop();
+  stop_run_ = false;
+  state_ = State::not_initialized;
+
+  if (poll_exception)
+  {
+    std::rethrow_exception(poll_exception);
+  }
+}
+
+void PilzModbusClient::poll(const ModbusReadPlan& read_plan)
+{
+  configurePollThread();
+
+  // Double buffered register image: The registers are read into the current image and compared with the last image,
+  // on a change both are swapped instead of copied.
+  std::array<RegCont, 2> holding_registers{ { read_plan.createImage(), read_plan.createImage() } };
+  // The read requests of both images, which allows the client to send them at once
+  std::array<std::vector<ModbusReadRequest>, 2> read_requests;
+  for (std::size_t image = 0; image < holding_registers.size(); ++image)
+  {
+    for (const auto& block : read_plan.getBlocks())
+    {
+      read_requests[image].push_back(
+          { block.first_register, block.number_of_registers, holding_registers[image].data() + block.image_offset });
+    }
+  }
+  std::size_t current_image{ 0 };
+  bool first_read{ true };
+  // Unchanged registers are published by repeating the last message, which also keeps its timestamp
+  ModbusMsgInStampedPtr last_msg;
+  ros::Time last_publish{ ros::Time::now() };
+
+  // Each cycle starts at an absolute deadline, so the time spent in a cycle does not shift the following cycles
+  const int64_t period_ns{ static_cast<int64_t>(std::llround(static_cast<double>(NSEC_PER_SEC) / READ_FREQUENCY_HZ)) };
+  int64_t deadline_ns{ monotonicNowNSec() };
+  int64_t last_wakeup_ns{ 0 };
+  // Cycles which are not yet handed over to the diagnostics
+  CycleStatistics pending_statistics;
   while (ros::ok() && !stop_run_.load())
   {
+    sleepUntilNSec(deadline_ns);
+    const int64_t wakeup_ns{ monotonicNowNSec() };
+
     // Work with local copy of buffer to ensure that the service callback
     // function does not become blocked
     boost::optional<ModbusRegisterBlock> write_reg_bock{ boost::none };
@@ -129,37 +236,20 @@ void PilzModbusClient::run()
       }
     }
 
-    std::vector<std::vector<unsigned short>> blocks = splitIntoBlocks(registers_to_read_);
-
-    unsigned short index_of_first_register = *std::min_element(registers_to_read_.begin(), registers_to_read_.end());
-    int num_registers =
-        *std::max_element(registers_to_read_.begin(), registers_to_read_.end()) - index_of_first_register + 1;
-    holding_register = RegCont(static_cast<unsigned long>(num_registers), 0);
+    RegCont& holding_register{ holding_registers[current_image] };
+    const RegCont& last_holding_register{ holding_registers[1 - current_image] };
 
-    ROS_DEBUG("blocks.size() %zu", blocks.size());
+    ROS_DEBUG("blocks.size() %zu", read_plan.getBlocks().size());
     try
     {
-      for (auto& block : blocks)
+      if (write_reg_bock)
+      {
+        modbus_client_->writeReadHoldingRegisterBlocks(static_cast<int>(write_reg_bock->start_idx),
+                                                       write_reg_bock->values, read_requests[current_image]);
+      }
+      else
       {
-        ROS_DEBUG("block.size() %zu", block.size());
-        unsigned short index_of_first_register_block = *(block.begin());
-        unsigned long num_registers_block = block.size();
-        RegCont block_holding_register;
-        if (write_reg_bock)
-        {
-          block_holding_register = modbus_client_->writeReadHoldingRegister(
-              static_cast<int>(write_reg_bock->start_idx), write_reg_bock->values,
-              static_cast<int>(index_of_first_register_block), static_cast<int>(num_registers_block));
-          // write only once:
-          write_reg_bock = boost::none;
-        }
-        else
-        {
-          block_holding_register = modbus_client_->readHoldingRegister(static_cast<int>(index_of_first_register_block),
-                                                                       static_cast<int>(num_registers_block));
-        }
-        for (uint i = 0; i < num_registers_block; i++)
-          holding_register[i + index_of_first_register_block - index_of_first_register] = block_holding_register[i];
+        modbus_client_->readHoldingRegisterBlocks(read_requests[current_image]);
       }
     }
     catch (ModbusExceptionDisconnect& e)
@@ -169,29 +259,128 @@ void PilzModbusClient::run()
       break;
     }
 
-    ModbusMsgInStampedPtr msg{ ModbusMsgInBuilder::createDefaultModbusMsgIn(index_of_first_register,
-                                                                            holding_register) };
+    // Registers which are only read to save a request are not published
+    for (const auto& gap : read_plan.getGaps())
+    {
+      std::fill_n(holding_register.begin() + static_cast<RegCont::difference_type>(gap.image_offset),
+                  gap.number_of_registers, 0);
+    }
 
     // Publish the received data into ROS
-    if (holding_register != last_holding_register)
+    const ros::Time now{ ros::Time::now() };
+    if (first_read || holding_register != last_holding_register)
     {
       ROS_DEBUG_STREAM("Sending new ROS-message.");
-      msg->header.stamp = ros::Time::now();
-      last_update = msg->header.stamp;
-      last_holding_register = holding_register;
+      last_msg = ModbusMsgInBuilder::createDefaultModbusMsgIn(read_plan.getFirstRegister(), holding_register);
+      last_msg->header.stamp = now;
+      current_image = 1 - current_image;
+      first_read = false;
+      modbus_read_pub_.publish(last_msg);
+      last_publish = now;
     }
-    else
+    else if (!publish_on_change_ || (!heartbeat_period_.isZero() && now - last_publish >= heartbeat_period_))
     {
-      msg->header.stamp = last_update;
+      modbus_read_pub_.publish(last_msg);
+      last_publish = now;
     }
-    modbus_read_pub_.publish(msg);
 
-    ros::spinOnce();
-    rate.sleep();
+    // Missed deadlines are skipped instead of being caught up with a burst of reads
+    const int64_t scheduled_ns{ deadline_ns };
+    deadline_ns += period_ns;
+    const int64_t now_ns{ monotonicNowNSec() };
+    const bool overrun{ now_ns > deadline_ns };
+    if (overrun)
+    {
+      deadline_ns += ((now_ns - deadline_ns) / period_ns + 1) * period_ns;
+    }
+
+    if (last_wakeup_ns != 0)
+    {
+      pending_statistics.addCycle(CycleStatistics::Duration(wakeup_ns - last_wakeup_ns),
+                                  CycleStatistics::Duration(wakeup_ns - scheduled_ns), overrun);
+    }
+    last_wakeup_ns = wakeup_ns;
+
+    // The polling thread may run with a realtime priority, hence it must not wait for the diagnostics. If they hold
+    // the lock, the cycles are handed over in one of the next cycles.
+    std::unique_lock<std::mutex> lock(cycle_statistics_mutex_, std::try_to_lock);
+    if (lock.owns_lock())
+    {
+      cycle_statistics_.add(pending_statistics);
+      pending_statistics.reset();
+    }
   }
+}
 
-  stop_run_ = false;
-  state_ = State::not_initialized;
+void PilzModbusClient::configurePollThread()
+{
+  if (poll_thread_config_.priority > 0)
+  {
+    sched_param param;
+    param.sched_priority = poll_thread_config_.priority;
+    const int res{ pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) };
+    ROS_WARN_STREAM_COND(res != 0, "Could not set SCHED_FIFO priority " << poll_thread_config_.priority
+                                                                        << " of the modbus polling thread: "
+                                                                        << std::strerror(res));
+  }
+
+  if (poll_thread_config_.cpu >= 0)
+  {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(static_cast<std::size_t>(poll_thread_config_.cpu), &cpu_set);
+    const int res{ pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) };
+    ROS_WARN_STREAM_COND(res != 0, "Could not pin the modbus polling thread to CPU " << poll_thread_config_.cpu << ": "
+                                                                                     << std::strerror(res));
+  }
+}
+
+void PilzModbusClient::publishDiagnostics(const ros::WallTimerEvent& /*event*/)
+{
+  CycleStatistics statistics;
+  std::size_t total_overruns;
+  {
+    std::lock_guard<std::mutex> lock(cycle_statistics_mutex_);
+    statistics = cycle_statistics_;
+    cycle_statistics_.reset();
+    total_overruns_ += statistics.getNumberOfOverruns();
+    total_overruns = total_overruns_;
+  }
+
+  diagnostic_msgs::DiagnosticStatus status;
+  status.name = ros::this_node::getName() + ": Modbus polling";
+  if (statistics.getNumberOfOverruns() > 0)
+  {
+    status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+    status.message = "Read cycles overran their period";
+  }
+  else
+  {
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = "OK";
+  }
+
+  const auto add_value = [&status](const std::string& key, const std::string& value) {
+    diagnostic_msgs::KeyValue key_value;
+    key_value.key = key;
+    key_value.value = value;
+    status.values.push_back(key_value);
+  };
+  add_value("Expected period [us]", toMicroseconds(std::chrono::duration_cast<CycleStatistics::Duration>(
+                                        std::chrono::duration<double>(1.0 / READ_FREQUENCY_HZ))));
+  add_value("Cycles", std::to_string(statistics.getNumberOfCycles()));
+  add_value("Min period [us]", toMicroseconds(statistics.getMinPeriod()));
+  add_value("Mean period [us]", toMicroseconds(statistics.getMeanPeriod()));
+  add_value("Max period [us]", toMicroseconds(statistics.getMaxPeriod()));
+  add_value("Mean jitter [us]", toMicroseconds(statistics.getMeanJitter()));
+  add_value("Max jitter [us]", toMicroseconds(statistics.getMaxJitter()));
+  add_value("Overruns", std::to_string(statistics.getNumberOfOverruns()));
+  add_value("Total overruns", std::to_string(total_overruns));
+
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+  msg.status.push_back(status);
+  diagnostics_pub_.publish(msg);
 }
 
 std::vector<std::vector<unsigned short>> PilzModbusClient::splitIntoBlocks(std::vector<unsigned short>& in)
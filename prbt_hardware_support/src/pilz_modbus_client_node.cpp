@@ -23,6 +23,7 @@
 
 #include <pilz_utils/get_param.h>
 #include <prbt_hardware_support/libmodbus_client.h>
+#include <prbt_hardware_support/pipelined_modbus_client.h>
 #include <prbt_hardware_support/pilz_modbus_client.h>
 #include <prbt_hardware_support/param_names.h>
 #include <prbt_hardware_support/pilz_modbus_client_exception.h>
@@ -32,6 +33,7 @@
 static constexpr int32_t MODBUS_CONNECTION_RETRIES_DEFAULT{ -1 };
 static constexpr double MODBUS_CONNECTION_RETRY_TIMEOUT_S_DEFAULT{ 1.0 };
 static constexpr int MODBUS_RESPONSE_TIMEOUT_MS{ 20 };
+static constexpr double MODBUS_HEARTBEAT_PERIOD_S_DEFAULT{ 1.0 };
 
 using namespace prbt_hardware_support;
 
@@ -95,11 +97,44 @@ int main(int argc, char** argv)
   std::string modbus_write_service_name;
   nh.param<std::string>(PARAM_MODBUS_WRITE_SERVICE_NAME_STR, modbus_write_service_name, SERVICE_MODBUS_WRITE);
 
+  bool modbus_pipelining{ false };
+  pnh.param<bool>(PARAM_MODBUS_PIPELINING, modbus_pipelining, false);
+
+  bool modbus_publish_on_change{ false };
+  pnh.param<bool>(PARAM_MODBUS_PUBLISH_ON_CHANGE, modbus_publish_on_change, false);
+
+  double modbus_heartbeat_period_s{ MODBUS_HEARTBEAT_PERIOD_S_DEFAULT };
+  pnh.param<double>(PARAM_MODBUS_HEARTBEAT_PERIOD, modbus_heartbeat_period_s, MODBUS_HEARTBEAT_PERIOD_S_DEFAULT);
+
+  PollThreadConfig poll_thread_config;
+  pnh.param<int>(PARAM_MODBUS_POLL_THREAD_PRIORITY, poll_thread_config.priority, poll_thread_config.priority);
+  pnh.param<int>(PARAM_MODBUS_POLL_THREAD_CPU, poll_thread_config.cpu, poll_thread_config.cpu);
+
+  ModbusReadCostModel read_cost_model;
+  pnh.param<double>(PARAM_MODBUS_READ_REQUEST_COST, read_cost_model.request_cost, read_cost_model.request_cost);
+  pnh.param<double>(PARAM_MODBUS_READ_REGISTER_COST, read_cost_model.register_cost, read_cost_model.register_cost);
+
   // LCOV_EXCL_STOP
 
-  prbt_hardware_support::PilzModbusClient modbus_client(
-      pnh, registers_to_read, std::unique_ptr<LibModbusClient>(new LibModbusClient()),
-      static_cast<unsigned int>(response_timeout_ms), modbus_read_topic_name, modbus_write_service_name);
+  std::unique_ptr<ModbusClient> client;
+  if (modbus_pipelining)
+  {
+    client.reset(new PipelinedModbusClient());
+  }
+  else
+  {
+    client.reset(new LibModbusClient());
+  }
+
+  prbt_hardware_support::PilzModbusClient modbus_client(pnh, registers_to_read, std::move(client),
+                                                        static_cast<unsigned int>(response_timeout_ms),
+                                                        modbus_read_topic_name, modbus_write_service_name);
+  modbus_client.setReadCostModel(read_cost_model);
+  if (modbus_publish_on_change)
+  {
+    modbus_client.setPublishOnChange(ros::Duration(modbus_heartbeat_period_s));
+  }
+  modbus_client.setPollThreadConfig(poll_thread_config);
 
   ROS_DEBUG_STREAM("Modbus client IP: " << ip << " | Port: " << port);
   std::ostringstream oss;
@@ -110,6 +145,13 @@ int main(int argc, char** argv)
   }
   ROS_DEBUG_STREAM("Registers to read: " << oss.str());
   ROS_DEBUG_STREAM("Modbus response timeout: " << response_timeout_ms);
+  ROS_DEBUG_STREAM("Modbus publish on change: " << (modbus_publish_on_change ? "enabled" : "disabled")
+                                                 << " | heartbeat period: " << modbus_heartbeat_period_s << "s");
+  ROS_DEBUG_STREAM("Modbus poll thread priority: " << poll_thread_config.priority
+                                                     << " | CPU: " << poll_thread_config.cpu);
+  ROS_DEBUG_STREAM("Modbus pipelining: " << (modbus_pipelining ? "enabled" : "disabled"));
+  ROS_DEBUG_STREAM("Modbus read request cost: " << read_cost_model.request_cost
+                                                << " | register cost: " << read_cost_model.register_cost);
   ROS_DEBUG_STREAM("Modbus read topic: \"" << modbus_read_topic_name << "\"");
   ROS_DEBUG_STREAM("Modbus write service: \"" << modbus_write_service_name << "\"");
 
@@ -0,0 +1,459 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <prbt_hardware_support/pipelined_modbus_client.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <ros/ros.h>
+
+#include <prbt_hardware_support/pilz_modbus_exceptions.h>
+
+namespace prbt_hardware_support
+{
+static constexpr uint8_t FUNCTION_READ_HOLDING_REGISTERS{ 0x03 };
+static constexpr uint8_t FUNCTION_WRITE_READ_HOLDING_REGISTERS{ 0x17 };
+static constexpr uint8_t EXCEPTION_FLAG{ 0x80 };
+//! Transaction ID, protocol ID, length and unit ID.
+static constexpr std::size_t MBAP_HEADER_LENGTH{ 7 };
+
+static void appendUint16(std::vector<uint8_t>& buffer, const int value)
+{
+  buffer.push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
+  buffer.push_back(static_cast<uint8_t>(value & 0xFF));
+}
+
+static uint16_t readUint16(const uint8_t* data)
+{
+  return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+constexpr unsigned long PipelinedModbusClient::DEFAULT_RESPONSE_TIMEOUT_MS;
+constexpr int PipelinedModbusClient::CONNECT_TIMEOUT_MS;
+constexpr uint8_t PipelinedModbusClient::UNIT_ID;
+constexpr std::size_t PipelinedModbusClient::MAX_ADU_LENGTH;
+constexpr int PipelinedModbusClient::MAX_READ_REGISTERS;
+constexpr int PipelinedModbusClient::MAX_WRITE_READ_WRITE_REGISTERS;
+constexpr std::size_t PipelinedModbusClient::RESERVED_TRANSACTIONS;
+
+PipelinedModbusClient::PipelinedModbusClient()
+{
+  transactions_.reserve(RESERVED_TRANSACTIONS);
+  send_buffer_.reserve(RESERVED_TRANSACTIONS * MAX_ADU_LENGTH);
+  receive_buffer_.resize(RESERVED_TRANSACTIONS * MAX_ADU_LENGTH);
+}
+
+PipelinedModbusClient::~PipelinedModbusClient()
+{
+  close();
+}
+
+bool PipelinedModbusClient::init(const char* ip, unsigned int port)
+{
+  close();
+
+  sockaddr_in server_address;
+  std::memset(&server_address, 0, sizeof(server_address));
+  server_address.sin_family = AF_INET;
+  server_address.sin_port = htons(static_cast<uint16_t>(port));
+  if (inet_pton(AF_INET, ip, &server_address.sin_addr) != 1)
+  {
+    ROS_ERROR_STREAM_NAMED("PipelinedModbusClient", "Invalid ip address " << ip << ".");
+    return false;
+  }
+
+  socket_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (socket_ == -1 || epoll_fd_ == -1)
+  {
+    ROS_ERROR_STREAM_NAMED("PipelinedModbusClient", "Could not create socket. " << std::strerror(errno) << ".");
+    close();
+    return false;
+  }
+
+  // Requests are small and latency matters, hence they must not be delayed
+  int no_delay{ 1 };
+  if (setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay)) == -1)
+  {
+    ROS_ERROR_STREAM_NAMED("PipelinedModbusClient", "Could not disable the delay of the socket. "
+                                                        << std::strerror(errno) << ".");
+    close();
+    return false;
+  }
+
+  epoll_event event;
+  std::memset(&event, 0, sizeof(event));
+  event.events = EPOLLOUT;
+  event.data.fd = socket_;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_, &event) == -1)
+  {
+    ROS_ERROR_STREAM_NAMED("PipelinedModbusClient", "Could not watch the socket. " << std::strerror(errno) << ".");
+    close();
+    return false;
+  }
+  epoll_events_ = EPOLLOUT;
+
+  if (connect(socket_, reinterpret_cast<const sockaddr*>(&server_address), sizeof(server_address)) == -1 &&
+      errno != EINPROGRESS)
+  {
+    ROS_ERROR_STREAM_NAMED("PipelinedModbusClient",
+                           "Could not establish modbus connection. " << std::strerror(errno) << ".");
+    close();
+    return false;
+  }
+
+  int ready{ -1 };
+  do
+  {
+    ready = epoll_wait(epoll_fd_, &event, 1, CONNECT_TIMEOUT_MS);
+  } while (ready == -1 && errno == EINTR);
+
+  int error{ 0 };
+  socklen_t error_length{ sizeof(error) };
+  if (ready != 1 || getsockopt(socket_, SOL_SOCKET, SO_ERROR, &error, &error_length) == -1 || error != 0)
+  {
+    ROS_ERROR_STREAM_NAMED("PipelinedModbusClient", "Could not establish modbus connection to "
+                                                        << ip << ":" << port << ". "
+                                                        << (ready == 1 ? std::strerror(error) : "Timeout") << ".");
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void PipelinedModbusClient::setResponseTimeoutInMs(unsigned long timeout_ms)
+{
+  response_timeout_ms_ = timeout_ms;
+}
+
+unsigned long PipelinedModbusClient::getResponseTimeoutInMs()
+{
+  return response_timeout_ms_;
+}
+
+RegCont PipelinedModbusClient::readHoldingRegister(int addr, int nb)
+{
+  RegCont tab_reg(static_cast<RegCont::size_type>(std::max(nb, 0)));
+  readHoldingRegisterInto(addr, nb, tab_reg.data());
+  return tab_reg;
+}
+
+RegCont PipelinedModbusClient::writeReadHoldingRegister(const int write_addr, const RegCont& write_reg,
+                                                        const int read_addr, const int read_nb)
+{
+  RegCont read_reg(static_cast<RegCont::size_type>(std::max(read_nb, 0)));
+  writeReadHoldingRegisterInto(write_addr, write_reg, read_addr, read_nb, read_reg.data());
+  return read_reg;
+}
+
+void PipelinedModbusClient::readHoldingRegisterInto(int addr, int nb, uint16_t* dest)
+{
+  beginTransmission();
+  addReadRequest({ addr, nb, dest });
+  transmit();
+}
+
+void PipelinedModbusClient::writeReadHoldingRegisterInto(const int write_addr, const RegCont& write_reg,
+                                                         const int read_addr, const int read_nb, uint16_t* dest)
+{
+  beginTransmission();
+  addWriteReadRequest(write_addr, write_reg, { read_addr, read_nb, dest });
+  transmit();
+}
+
+void PipelinedModbusClient::readHoldingRegisterBlocks(const std::vector<ModbusReadRequest>& requests)
+{
+  beginTransmission();
+  for (const auto& request : requests)
+  {
+    addReadRequest(request);
+  }
+  transmit();
+}
+
+void PipelinedModbusClient::writeReadHoldingRegisterBlocks(const int write_addr, const RegCont& write_reg,
+                                                           const std::vector<ModbusReadRequest>& requests)
+{
+  beginTransmission();
+  for (std::size_t i = 0; i < requests.size(); ++i)
+  {
+    if (i == 0)
+    {
+      addWriteReadRequest(write_addr, write_reg, requests[i]);
+    }
+    else
+    {
+      addReadRequest(requests[i]);
+    }
+  }
+  transmit();
+}
+
+void PipelinedModbusClient::close()
+{
+  if (socket_ != -1)
+  {
+    ::close(socket_);
+    socket_ = -1;
+  }
+  if (epoll_fd_ != -1)
+  {
+    ::close(epoll_fd_);
+    epoll_fd_ = -1;
+  }
+  epoll_events_ = 0;
+}
+
+void PipelinedModbusClient::beginTransmission()
+{
+  if (socket_ == -1)
+  {
+    throw ModbusExceptionDisconnect("Modbus disconnected!");
+  }
+  transactions_.clear();
+  send_buffer_.clear();
+}
+
+void PipelinedModbusClient::addReadRequest(const ModbusReadRequest& request)
+{
+  if (request.nb < 0 || request.nb > MAX_READ_REGISTERS)
+  {
+    throw std::invalid_argument("Argument \"nb\" must be within [0, " + std::to_string(MAX_READ_REGISTERS) + "]");
+  }
+
+  addHeader(FUNCTION_READ_HOLDING_REGISTERS, 5, request.nb, request.dest);
+  appendUint16(send_buffer_, request.addr);
+  appendUint16(send_buffer_, request.nb);
+}
+
+void PipelinedModbusClient::addWriteReadRequest(const int write_addr, const RegCont& write_reg,
+                                                const ModbusReadRequest& request)
+{
+  if (request.nb < 0 || request.nb > MAX_READ_REGISTERS)
+  {
+    throw std::invalid_argument("Argument \"read_nb\" must be within [0, " + std::to_string(MAX_READ_REGISTERS) +
+                                "]");
+  }
+  if (write_reg.size() > static_cast<std::size_t>(MAX_WRITE_READ_WRITE_REGISTERS))
+  {
+    throw std::invalid_argument("Argument \"write_reg\" must not contain more than " +
+                                std::to_string(MAX_WRITE_READ_WRITE_REGISTERS) + " registers");
+  }
+
+  addHeader(FUNCTION_WRITE_READ_HOLDING_REGISTERS, 10 + 2 * write_reg.size(), request.nb, request.dest);
+  appendUint16(send_buffer_, request.addr);
+  appendUint16(send_buffer_, request.nb);
+  appendUint16(send_buffer_, write_addr);
+  appendUint16(send_buffer_, static_cast<int>(write_reg.size()));
+  send_buffer_.push_back(static_cast<uint8_t>(2 * write_reg.size()));
+  for (const auto& value : write_reg)
+  {
+    appendUint16(send_buffer_, value);
+  }
+}
+
+void PipelinedModbusClient::addHeader(const uint8_t function_code, const std::size_t pdu_length, const int nb,
+                                      uint16_t* dest)
+{
+  const uint16_t transaction_id{ next_transaction_id_++ };
+  transactions_.push_back({ transaction_id, function_code, nb, dest, false });
+
+  appendUint16(send_buffer_, transaction_id);
+  appendUint16(send_buffer_, 0);  // Modbus protocol
+  appendUint16(send_buffer_, static_cast<int>(pdu_length + 1));
+  send_buffer_.push_back(UNIT_ID);
+  send_buffer_.push_back(function_code);
+}
+
+void PipelinedModbusClient::transmit()
+{
+  if (transactions_.empty())
+  {
+    return;
+  }
+
+  const Clock::time_point deadline{ Clock::now() + std::chrono::milliseconds(response_timeout_ms_) };
+  sendRequests(deadline);
+  receiveResponses(deadline);
+}
+
+void PipelinedModbusClient::sendRequests(const Clock::time_point& deadline)
+{
+  std::size_t bytes_sent{ 0 };
+  while (bytes_sent < send_buffer_.size())
+  {
+    const ssize_t rc{ send(socket_, send_buffer_.data() + bytes_sent, send_buffer_.size() - bytes_sent,
+                           MSG_NOSIGNAL) };
+    if (rc >= 0)
+    {
+      bytes_sent += static_cast<std::size_t>(rc);
+    }
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+    {
+      waitForEvent(EPOLLOUT, deadline);
+    }
+    else if (errno != EINTR)
+    {
+      fail(std::string("Failed to send modbus requests: ") + std::strerror(errno));
+    }
+  }
+}
+
+void PipelinedModbusClient::receiveResponses(const Clock::time_point& deadline)
+{
+  std::size_t pending_transactions{ transactions_.size() };
+  std::size_t bytes_received{ 0 };
+  while (pending_transactions > 0)
+  {
+    if (receive_buffer_.size() - bytes_received < MAX_ADU_LENGTH)
+    {
+      receive_buffer_.resize(bytes_received + MAX_ADU_LENGTH);
+    }
+
+    const ssize_t rc{ recv(socket_, receive_buffer_.data() + bytes_received, receive_buffer_.size() - bytes_received,
+                           0) };
+    if (rc == 0)
+    {
+      fail("Connection closed by the modbus server");
+    }
+    if (rc < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+      {
+        waitForEvent(EPOLLIN, deadline);
+      }
+      else if (errno != EINTR)
+      {
+        fail(std::string("Failed to receive modbus responses: ") + std::strerror(errno));
+      }
+      continue;
+    }
+    bytes_received += static_cast<std::size_t>(rc);
+    // Acknowledge immediately: Servers which use Nagle's algorithm hold back further responses until the ACK arrives.
+    // Linux resets this option, hence it is set after each receive.
+    int quick_ack{ 1 };
+    setsockopt(socket_, IPPROTO_TCP, TCP_QUICKACK, &quick_ack, sizeof(quick_ack));
+
+    // Process all complete responses, an incomplete response is kept at the start of the buffer
+    std::size_t offset{ 0 };
+    while (bytes_received - offset >= MBAP_HEADER_LENGTH)
+    {
+      const std::size_t adu_length{ 6 + static_cast<std::size_t>(readUint16(receive_buffer_.data() + offset + 4)) };
+      if (adu_length < MBAP_HEADER_LENGTH + 2 || adu_length > MAX_ADU_LENGTH)
+      {
+        fail("Invalid length of modbus response");
+      }
+      if (bytes_received - offset < adu_length)
+      {
+        break;
+      }
+      processResponse(receive_buffer_.data() + offset, adu_length);
+      --pending_transactions;
+      offset += adu_length;
+    }
+    std::copy(receive_buffer_.begin() + static_cast<std::ptrdiff_t>(offset),
+              receive_buffer_.begin() + static_cast<std::ptrdiff_t>(bytes_received), receive_buffer_.begin());
+    bytes_received -= offset;
+  }
+}
+
+void PipelinedModbusClient::processResponse(const uint8_t* adu, const std::size_t adu_length)
+{
+  const uint16_t transaction_id{ readUint16(adu) };
+  // Transaction IDs are assigned consecutively within a transmission
+  const uint16_t index{ static_cast<uint16_t>(transaction_id - transactions_.front().transaction_id) };
+  if (index >= transactions_.size() || transactions_[index].done || readUint16(adu + 2) != 0)
+  {
+    fail("Unexpected modbus response with transaction id " + std::to_string(transaction_id));
+  }
+  Transaction& transaction{ transactions_[index] };
+
+  const uint8_t function_code{ adu[MBAP_HEADER_LENGTH] };
+  if (function_code == (transaction.function_code | EXCEPTION_FLAG))
+  {
+    std::ostringstream err_stream;
+    err_stream << "Modbus server responded with exception " << static_cast<int>(adu[MBAP_HEADER_LENGTH + 1])
+               << " to function " << static_cast<int>(transaction.function_code);
+    fail(err_stream.str());
+  }
+
+  const std::size_t byte_count{ 2 * static_cast<std::size_t>(transaction.nb) };
+  if (function_code != transaction.function_code || adu[MBAP_HEADER_LENGTH + 1] != byte_count ||
+      adu_length != MBAP_HEADER_LENGTH + 2 + byte_count)
+  {
+    fail("Invalid modbus response with transaction id " + std::to_string(transaction_id));
+  }
+
+  const uint8_t* values{ adu + MBAP_HEADER_LENGTH + 2 };
+  for (int i = 0; i < transaction.nb; ++i)
+  {
+    transaction.dest[i] = readUint16(values + 2 * i);
+  }
+  transaction.done = true;
+}
+
+void PipelinedModbusClient::waitForEvent(const uint32_t events, const Clock::time_point& deadline)
+{
+  if (epoll_events_ != events)
+  {
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = socket_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket_, &event) == -1)
+    {
+      fail(std::string("Failed to watch the socket: ") + std::strerror(errno));
+    }
+    epoll_events_ = events;
+  }
+
+  const auto remaining{ std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now()) };
+  if (remaining.count() <= 0)
+  {
+    fail("Timeout while waiting for the modbus server");
+  }
+
+  // Round up, since epoll has a resolution of milliseconds
+  epoll_event event;
+  const int timeout_ms{ static_cast<int>((remaining.count() + 999) / 1000) };
+  if (epoll_wait(epoll_fd_, &event, 1, timeout_ms) == -1 && errno != EINTR)
+  {
+    fail(std::string("Failed to wait for the modbus server: ") + std::strerror(errno));
+  }
+  // The caller retries, a timeout is detected on the next call
+}
+
+void PipelinedModbusClient::fail(const std::string& reason)
+{
+  ROS_ERROR_STREAM_NAMED("PipelinedModbusClient", reason);
+  close();
+  throw ModbusExceptionDisconnect(reason);
+}
+
+}  // namespace prbt_hardware_support
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include <prbt_hardware_support/cycle_statistics.h>
+
+using namespace prbt_hardware_support;
+
+namespace cycle_statistics_test
+{
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+/**
+ * @brief Test that the statistics are zero if no cycle was added
+ */
+TEST(CycleStatisticsTest, testNoCycles)
+{
+  const CycleStatistics statistics;
+  EXPECT_EQ(0u, statistics.getNumberOfCycles());
+  EXPECT_EQ(0u, statistics.getNumberOfOverruns());
+  EXPECT_EQ(CycleStatistics::Duration::zero(), statistics.getMinPeriod());
+  EXPECT_EQ(CycleStatistics::Duration::zero(), statistics.getMaxPeriod());
+  EXPECT_EQ(CycleStatistics::Duration::zero(), statistics.getMeanPeriod());
+  EXPECT_EQ(CycleStatistics::Duration::zero(), statistics.getMaxJitter());
+  EXPECT_EQ(CycleStatistics::Duration::zero(), statistics.getMeanJitter());
+}
+
+/**
+ * @brief Test min, max and mean of the period and the jitter as well as the number of overruns
+ */
+TEST(CycleStatisticsTest, testAddCycles)
+{
+  CycleStatistics statistics;
+  statistics.addCycle(milliseconds(2), microseconds(10), false);
+  statistics.addCycle(milliseconds(3), microseconds(50), true);
+  statistics.addCycle(milliseconds(1), microseconds(30), false);
+
+  EXPECT_EQ(3u, statistics.getNumberOfCycles());
+  EXPECT_EQ(1u, statistics.getNumberOfOverruns());
+  EXPECT_EQ(milliseconds(1), statistics.getMinPeriod());
+  EXPECT_EQ(milliseconds(3), statistics.getMaxPeriod());
+  EXPECT_EQ(milliseconds(2), statistics.getMeanPeriod());
+  EXPECT_EQ(microseconds(50), statistics.getMaxJitter());
+  EXPECT_EQ(microseconds(30), statistics.getMeanJitter());
+}
+
+/**
+ * @brief Test that reset removes all recorded cycles
+ */
+TEST(CycleStatisticsTest, testReset)
+{
+  CycleStatistics statistics;
+  statistics.addCycle(milliseconds(2), microseconds(10), true);
+  statistics.reset();
+  EXPECT_EQ(0u, statistics.getNumberOfCycles());
+  EXPECT_EQ(0u, statistics.getNumberOfOverruns());
+  EXPECT_EQ(CycleStatistics::Duration::zero(), statistics.getMaxPeriod());
+
+  statistics.addCycle(milliseconds(4), microseconds(10), false);
+  EXPECT_EQ(milliseconds(4), statistics.getMinPeriod());
+  EXPECT_EQ(milliseconds(4), statistics.getMeanPeriod());
+}
+
+/**
+ * @brief Test that adding statistics yields the same result as adding their cycles one by one
+ */
+TEST(CycleStatisticsTest, testAddStatistics)
+{
+  CycleStatistics statistics;
+  CycleStatistics empty;
+  statistics.add(empty);
+  EXPECT_EQ(0u, statistics.getNumberOfCycles());
+  EXPECT_EQ(CycleStatistics::Duration::zero(), statistics.getMinPeriod());
+
+  CycleStatistics first;
+  first.addCycle(milliseconds(2), microseconds(10), false);
+  first.addCycle(milliseconds(3), microseconds(50), true);
+  CycleStatistics second;
+  second.addCycle(milliseconds(1), microseconds(30), false);
+
+  statistics.add(first);
+  statistics.add(empty);
+  statistics.add(second);
+
+  EXPECT_EQ(3u, statistics.getNumberOfCycles());
+  EXPECT_EQ(1u, statistics.getNumberOfOverruns());
+  EXPECT_EQ(milliseconds(1), statistics.getMinPeriod());
+  EXPECT_EQ(milliseconds(3), statistics.getMaxPeriod());
+  EXPECT_EQ(milliseconds(2), statistics.getMeanPeriod());
+  EXPECT_EQ(microseconds(50), statistics.getMaxJitter());
+  EXPECT_EQ(microseconds(30), statistics.getMeanJitter());
+}
+
+}  // namespace cycle_statistics_test
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
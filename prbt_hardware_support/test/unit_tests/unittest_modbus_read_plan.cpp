@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+#include <prbt_hardware_support/modbus_read_plan.h>
+#include <prbt_hardware_support/pilz_modbus_client_exception.h>
+
+using namespace prbt_hardware_support;
+
+namespace modbus_read_plan_test
+{
+/**
+ * @brief Test that a plan without registers is rejected
+ */
+TEST(ModbusReadPlanTest, testNoRegisters)
+{
+  using Blocks = std::vector<std::vector<unsigned short>>;
+  EXPECT_THROW(ModbusReadPlan{ Blocks() }, PilzModbusClientException);
+  EXPECT_THROW(ModbusReadPlan{ Blocks(1) }, PilzModbusClientException);
+}
+
+/**
+ * @brief Test that a single block covers the whole register image
+ */
+TEST(ModbusReadPlanTest, testSingleBlock)
+{
+  const ModbusReadPlan plan({ { 512, 513, 514 } });
+  EXPECT_EQ(512u, plan.getFirstRegister());
+  EXPECT_EQ(3u, plan.getImageSize());
+
+  ASSERT_EQ(1u, plan.getBlocks().size());
+  EXPECT_EQ(512, plan.getBlocks().front().first_register);
+  EXPECT_EQ(3, plan.getBlocks().front().number_of_registers);
+  EXPECT_EQ(0u, plan.getBlocks().front().image_offset);
+}
+
+/**
+ * @brief Test the offsets of several blocks within the register image
+ */
+TEST(ModbusReadPlanTest, testSeveralBlocks)
+{
+  const ModbusReadPlan plan({ { 1, 2 }, { 4, 5 }, { 9 } });
+  EXPECT_EQ(1u, plan.getFirstRegister());
+  EXPECT_EQ(9u, plan.getImageSize());
+
+  const std::vector<ModbusReadBlock>& blocks{ plan.getBlocks() };
+  ASSERT_EQ(3u, blocks.size());
+  EXPECT_EQ(4, blocks.at(1).first_register);
+  EXPECT_EQ(2, blocks.at(1).number_of_registers);
+  EXPECT_EQ(3u, blocks.at(1).image_offset);
+  EXPECT_EQ(9, blocks.at(2).first_register);
+  EXPECT_EQ(1, blocks.at(2).number_of_registers);
+  EXPECT_EQ(8u, blocks.at(2).image_offset);
+}
+
+TEST(ModbusReadPlanTest, testCreateImage)
+{
+  const ModbusReadPlan plan({ { 1, 2 }, { 4 } });
+  EXPECT_EQ(RegCont(4, 0), plan.createImage());
+}
+
+/**
+ * @brief Test that blocks are not merged by default
+ */
+TEST(ModbusReadPlanTest, testNoMergeByDefault)
+{
+  const ModbusReadPlan plan({ { 970 }, { 973, 974 }, { 977 } });
+  EXPECT_EQ(3u, plan.getBlocks().size());
+  EXPECT_TRUE(plan.getGaps().empty());
+}
+
+/**
+ * @brief Test that blocks are merged if the gap costs less than an additional request
+ */
+TEST(ModbusReadPlanTest, testMergeBlocks)
+{
+  ModbusReadCostModel cost_model;
+  cost_model.request_cost = 2.5;
+  cost_model.register_cost = 1.0;
+
+  const ModbusReadPlan plan({ { 970 }, { 973, 974 }, { 977 }, { 990 } }, cost_model);
+  EXPECT_EQ(21u, plan.getImageSize());
+
+  const std::vector<ModbusReadBlock>& blocks{ plan.getBlocks() };
+  ASSERT_EQ(2u, blocks.size()) << "Gap of 12 registers must not be merged";
+  EXPECT_EQ(970, blocks.front().first_register);
+  EXPECT_EQ(8, blocks.front().number_of_registers);
+  EXPECT_EQ(990, blocks.back().first_register);
+  EXPECT_EQ(20u, blocks.back().image_offset);
+
+  const std::vector<ModbusImageGap>& gaps{ plan.getGaps() };
+  ASSERT_EQ(2u, gaps.size());
+  EXPECT_EQ(1u, gaps.front().image_offset);
+  EXPECT_EQ(2u, gaps.front().number_of_registers);
+  EXPECT_EQ(5u, gaps.back().image_offset);
+  EXPECT_EQ(2u, gaps.back().number_of_registers);
+}
+
+/**
+ * @brief Test that a single request does not exceed the max number of registers
+ */
+TEST(ModbusReadPlanTest, testMaxReadRegisters)
+{
+  std::vector<unsigned short> long_block(MODBUS_READ_REQUEST_MAX_REGISTERS + 10);
+  std::iota(long_block.begin(), long_block.end(), 0);
+
+  ModbusReadCostModel cost_model;
+  cost_model.request_cost = 1000.0;
+
+  const ModbusReadPlan plan({ long_block, { static_cast<unsigned short>(long_block.size() + 1) } }, cost_model);
+  const std::vector<ModbusReadBlock>& blocks{ plan.getBlocks() };
+  ASSERT_EQ(2u, blocks.size());
+  EXPECT_EQ(MODBUS_READ_REQUEST_MAX_REGISTERS, blocks.front().number_of_registers);
+  EXPECT_EQ(MODBUS_READ_REQUEST_MAX_REGISTERS, blocks.back().first_register);
+  EXPECT_EQ(12, blocks.back().number_of_registers) << "Remainder of the long block and the last block are merged";
+  EXPECT_EQ(long_block.size() + 2, plan.getImageSize());
+}
+
+}  // namespace modbus_read_plan_test
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
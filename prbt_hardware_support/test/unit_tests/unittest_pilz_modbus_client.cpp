@@ -27,6 +27,7 @@
 
 #include <ros/ros.h>
 #include <modbus/modbus.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 
 #include <prbt_hardware_support/modbus_topic_definitions.h>
 #include <prbt_hardware_support/ModbusMsgInStamped.h>
@@ -44,6 +45,7 @@ namespace pilz_modbus_client_test
 using ::testing::_;
 using ::testing::AnyNumber;
 using ::testing::AtLeast;
+using ::testing::Between;
 using ::testing::InSequence;
 using ::testing::Invoke;
 using ::testing::InvokeWithoutArgs;
@@ -129,6 +131,7 @@ protected:
   ros::NodeHandle nh_;
 
   MOCK_METHOD1(modbus_read_cb, void(const ModbusMsgInStampedConstPtr& msg));
+  MOCK_METHOD1(diagnostics_cb, void(const diagnostic_msgs::DiagnosticArrayConstPtr& msg));
 };
 
 void PilzModbusClientTests::SetUp()
@@ -146,6 +149,20 @@ MATCHER(IsDisconnect, "")
 {
   return arg->disconnect.data;
 }
+MATCHER(HasPolledCycles, "")
+{
+  for (const auto& status : arg->status)
+  {
+    for (const auto& value : status.values)
+    {
+      if (value.key == "Cycles" && value.value != "0")
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
 
 /**
  * @brief Test that PilzModbusClient initializes its client properly
@@ -272,6 +289,127 @@ TEST_F(PilzModbusClientTests, properReadingAndDisconnect)
   BARRIER("disconnected");
 }
 
+/**
+ * @brief Test that only changes are published if publishing on change is enabled
+ */
+TEST_F(PilzModbusClientTests, publishOnChange)
+{
+  std::unique_ptr<PilzModbusClientMock> mock(new PilzModbusClientMock());
+
+  {
+    InSequence s;
+    EXPECT_CALL(*mock, init(_, _)).Times(1).WillOnce(Return(true));
+    EXPECT_CALL(*mock, readHoldingRegister(_, _))
+        .WillOnce(Return(std::vector<uint16_t>{ 1, 2 }))
+        .WillOnce(Return(std::vector<uint16_t>{ 1, 2 }))
+        .WillOnce(Return(std::vector<uint16_t>{ 1, 2 }))
+        .WillOnce(Return(std::vector<uint16_t>{ 3, 4 }))
+        .WillOnce(Return(std::vector<uint16_t>{ 3, 4 }))
+        .WillOnce(Throw(ModbusExceptionDisconnect("disconnect_message")));
+  }
+  {
+    InSequence s;
+    EXPECT_CALL(*this, modbus_read_cb(IsSuccessfullRead(std::vector<uint16_t>{ 1, 2 }))).Times(1);
+    EXPECT_CALL(*this, modbus_read_cb(IsSuccessfullRead(std::vector<uint16_t>{ 3, 4 }))).Times(1);
+    EXPECT_CALL(*this, modbus_read_cb(IsDisconnect())).Times(1).WillOnce(ACTION_OPEN_BARRIER_VOID("disconnected"));
+  }
+
+  std::vector<unsigned short> registers(REGISTER_SIZE_TEST);
+  std::iota(registers.begin(), registers.end(), REGISTER_FIRST_IDX_TEST);
+
+  PilzModbusClient client(nh_, registers, std::move(mock), RESPONSE_TIMEOUT, prbt_hardware_support::TOPIC_MODBUS_READ,
+                          prbt_hardware_support::SERVICE_MODBUS_WRITE);
+  client.setPublishOnChange(ros::Duration(0.0));
+
+  EXPECT_TRUE(client.init(LOCALHOST, DEFAULT_MODBUS_PORT_TEST));
+  EXPECT_NO_THROW(client.run());
+  BARRIER("disconnected");
+}
+
+/**
+ * @brief Test that unchanged registers are published once per heartbeat period if publishing on change is enabled
+ *
+ * Test Sequence:
+ * - 1. Run the client with a read frequency of 100Hz and a heartbeat period of 0.1s for ~1 second.
+ *
+ * Expected Results:
+ * - 1. About 10 messages (instead of 100) are published, all with the timestamp of the first message.
+ */
+TEST_F(PilzModbusClientTests, publishOnChangeHeartbeat)
+{
+  std::unique_ptr<PilzModbusClientMock> mock(new PilzModbusClientMock());
+
+  EXPECT_CALL(*mock, init(_, _)).Times(1).WillOnce(Return(true));
+  ON_CALL(*mock, readHoldingRegister(_, _)).WillByDefault(Return(std::vector<uint16_t>{ 3, 4 }));
+
+  std::mutex stamps_mutex;
+  std::vector<ros::Time> stamps;
+  EXPECT_CALL(*this, modbus_read_cb(IsSuccessfullRead(std::vector<uint16_t>{ 3, 4 })))
+      .Times(Between(5, 15))
+      .WillRepeatedly(Invoke([&stamps_mutex, &stamps](const ModbusMsgInStampedConstPtr& msg) {
+        std::lock_guard<std::mutex> lock(stamps_mutex);
+        stamps.push_back(msg->header.stamp);
+      }));
+
+  std::vector<unsigned short> registers(REGISTER_SIZE_TEST);
+  std::iota(registers.begin(), registers.end(), REGISTER_FIRST_IDX_TEST);
+
+  auto client = std::make_shared<PilzModbusClient>(nh_, registers, std::move(mock), RESPONSE_TIMEOUT,
+                                                   prbt_hardware_support::TOPIC_MODBUS_READ,
+                                                   prbt_hardware_support::SERVICE_MODBUS_WRITE, 100.0);
+  client->setPublishOnChange(ros::Duration(0.1));
+
+  EXPECT_TRUE(client->init(LOCALHOST, DEFAULT_MODBUS_PORT_TEST));
+
+  PilzModbusClientExecutor executor(client.get());
+  executor.start();
+  ros::Duration(1).sleep();
+  executor.stop();
+  // Wait for the last messages to arrive
+  ros::Duration(0.1).sleep();
+
+  std::lock_guard<std::mutex> lock(stamps_mutex);
+  ASSERT_FALSE(stamps.empty());
+  for (const auto& stamp : stamps)
+  {
+    EXPECT_EQ(stamps.front(), stamp) << "Heartbeat must not change the timestamp";
+  }
+}
+
+/**
+ * @brief Test that blocks are read with a single request if this is cheaper and that the registers between them are
+ * not published
+ */
+TEST_F(PilzModbusClientTests, readMergedBlocks)
+{
+  std::unique_ptr<PilzModbusClientMock> mock(new PilzModbusClientMock());
+
+  {
+    InSequence s;
+    EXPECT_CALL(*mock, init(_, _)).Times(1).WillOnce(Return(true));
+    EXPECT_CALL(*mock, readHoldingRegister(static_cast<int>(REGISTER_FIRST_IDX_TEST), 3))
+        .WillOnce(Return(std::vector<uint16_t>{ 1, 2, 3 }))
+        .WillOnce(Throw(ModbusExceptionDisconnect("disconnect_message")));
+  }
+  {
+    InSequence s;
+    EXPECT_CALL(*this, modbus_read_cb(IsSuccessfullRead(std::vector<uint16_t>{ 1, 0, 3 }))).Times(1);
+    EXPECT_CALL(*this, modbus_read_cb(IsDisconnect())).Times(1).WillOnce(ACTION_OPEN_BARRIER_VOID("disconnected"));
+  }
+
+  std::vector<unsigned short> registers{ REGISTER_FIRST_IDX_TEST, REGISTER_FIRST_IDX_TEST + 2 };
+
+  PilzModbusClient client(nh_, registers, std::move(mock), RESPONSE_TIMEOUT, prbt_hardware_support::TOPIC_MODBUS_READ,
+                          prbt_hardware_support::SERVICE_MODBUS_WRITE);
+  ModbusReadCostModel cost_model;
+  cost_model.request_cost = 2.0;
+  client.setReadCostModel(cost_model);
+
+  EXPECT_TRUE(client.init(LOCALHOST, DEFAULT_MODBUS_PORT_TEST));
+  EXPECT_NO_THROW(client.run());
+  BARRIER("disconnected");
+}
+
 /**
  * @brief Try to run the modbus read client without a foregoing call to init()
  */
@@ -319,6 +457,39 @@ TEST_F(PilzModbusClientTests, terminateRunningClient)
   EXPECT_FALSE(client->isRunning());
 }
 
+/**
+ * @brief Test that the timing statistics of the polling loop are published as diagnostics
+ */
+TEST_F(PilzModbusClientTests, publishDiagnostics)
+{
+  std::unique_ptr<PilzModbusClientMock> mock(new PilzModbusClientMock());
+
+  EXPECT_CALL(*mock, init(_, _)).Times(1).WillOnce(Return(true));
+  ON_CALL(*mock, readHoldingRegister(_, _)).WillByDefault(Return(std::vector<uint16_t>{ 3, 4 }));
+  ON_CALL(*this, modbus_read_cb(IsSuccessfullRead(std::vector<uint16_t>{ 3, 4 }))).WillByDefault(Return());
+  EXPECT_CALL(*this, diagnostics_cb(HasPolledCycles()))
+      .Times(AtLeast(1))
+      .WillOnce(ACTION_OPEN_BARRIER_VOID("diagnostics"))
+      .WillRepeatedly(Return());
+
+  ros::Subscriber diagnostics_sub{ nh_.subscribe<diagnostic_msgs::DiagnosticArray>(
+      prbt_hardware_support::TOPIC_DIAGNOSTICS, 1, &PilzModbusClientTests::diagnostics_cb, this) };
+
+  std::vector<unsigned short> registers(REGISTER_SIZE_TEST);
+  std::iota(registers.begin(), registers.end(), REGISTER_FIRST_IDX_TEST);
+
+  auto client = std::make_shared<PilzModbusClient>(nh_, registers, std::move(mock), RESPONSE_TIMEOUT,
+                                                   prbt_hardware_support::TOPIC_MODBUS_READ,
+                                                   prbt_hardware_support::SERVICE_MODBUS_WRITE);
+
+  EXPECT_TRUE(client->init(LOCALHOST, DEFAULT_MODBUS_PORT_TEST));
+
+  PilzModbusClientExecutor executor(client.get());
+  executor.start();
+  BARRIER("diagnostics");
+  executor.stop();
+}
+
 void callbackDummy(const ModbusMsgInStampedConstPtr& /*msg*/)
 {
 }
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2020 Pilz GmbH & Co. KG
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <prbt_hardware_support/pipelined_modbus_client.h>
+#include <prbt_hardware_support/pilz_modbus_server_mock.h>
+#include <prbt_hardware_support/pilz_modbus_exceptions.h>
+
+#include <prbt_hardware_support/client_tests_common.h>
+
+namespace pipelined_modbus_client_test
+{
+using namespace prbt_hardware_support;
+
+// Each testcase should have its own port in order to avoid conflicts between them
+constexpr unsigned int START_PORT{ 20700 };
+constexpr unsigned int END_PORT{ 20800 };
+static unsigned int ACTIVE_PORT_IDX{ 0 };
+static std::vector<unsigned int> PORTS_FOR_TEST(END_PORT - START_PORT);
+
+constexpr unsigned int DEFAULT_REGISTER_SIZE{ 514 };
+constexpr unsigned int DEFAULT_WRITE_IDX{ 512 };
+constexpr unsigned int DEFAULT_READ_IDX{ 77 };
+
+class PipelinedModbusClientTest : public testing::Test
+{
+public:
+  static void SetUpTestCase();  // NOLINT
+  void TearDown() override;
+  unsigned int testPort();
+
+protected:
+  void shutdownModbusServer(PilzModbusServerMock* server, PipelinedModbusClient& client);
+};
+
+void PipelinedModbusClientTest::TearDown()
+{
+  // Use next port on next test
+  ACTIVE_PORT_IDX++;
+}
+
+unsigned int PipelinedModbusClientTest::testPort()
+{
+  return PORTS_FOR_TEST.at(ACTIVE_PORT_IDX % PORTS_FOR_TEST.size());
+}
+
+void PipelinedModbusClientTest::SetUpTestCase()  // NOLINT
+{
+  std::iota(PORTS_FOR_TEST.begin(), PORTS_FOR_TEST.end(), START_PORT);
+}
+
+void PipelinedModbusClientTest::shutdownModbusServer(PilzModbusServerMock* server, PipelinedModbusClient& client)
+{
+  server->setTerminateFlag();
+  RegCont reg_to_write_by_client{ 1 };
+  try
+  {
+    client.writeReadHoldingRegister(DEFAULT_REGISTER_SIZE, reg_to_write_by_client, DEFAULT_WRITE_IDX,
+                                    DEFAULT_REGISTER_SIZE - DEFAULT_WRITE_IDX);
+  }
+  catch (const ModbusExceptionDisconnect& /* ex */)
+  {
+    // Tolerated exception
+  }
+
+  server->terminate();
+}
+
+/**
+ * @brief Test unsuccessfull init if no server is present
+ */
+TEST_F(PipelinedModbusClientTest, testFailingInitIfNoServer)
+{
+  PipelinedModbusClient client;
+  EXPECT_FALSE(client.init(LOCALHOST, testPort()));
+  EXPECT_THROW(client.readHoldingRegister(DEFAULT_WRITE_IDX, 2), ModbusExceptionDisconnect);
+}
+
+/**
+ * @brief Tests that holding registers set on the server are correctly read by the client
+ */
+TEST_F(PipelinedModbusClientTest, testReadRegisters)
+{
+  PipelinedModbusClient client;
+  std::shared_ptr<PilzModbusServerMock> server(new PilzModbusServerMock(DEFAULT_REGISTER_SIZE));
+  server->startAsync(LOCALHOST, testPort());
+
+  server->setHoldingRegister(RegCont{ 1, 2 }, DEFAULT_WRITE_IDX);
+
+  EXPECT_TRUE(client.init(LOCALHOST, testPort()));
+
+  RegCont res = client.readHoldingRegister(DEFAULT_WRITE_IDX, 2);
+  RegCont res_expected{ 1, 2 };
+  EXPECT_EQ(res_expected, res);
+
+  shutdownModbusServer(server.get(), client);
+  client.close();
+}
+
+/**
+ * @brief Tests that several blocks sent at once are assigned to the correct buffers
+ */
+TEST_F(PipelinedModbusClientTest, testReadRegisterBlocks)
+{
+  PipelinedModbusClient client;
+  std::shared_ptr<PilzModbusServerMock> server(new PilzModbusServerMock(DEFAULT_REGISTER_SIZE));
+  server->startAsync(LOCALHOST, testPort());
+
+  server->setHoldingRegister(RegCont{ 1, 2 }, DEFAULT_WRITE_IDX);
+  server->setHoldingRegister(RegCont{ 3, 4, 5 }, DEFAULT_READ_IDX);
+
+  EXPECT_TRUE(client.init(LOCALHOST, testPort()));
+
+  RegCont image(5, 0);
+  const std::vector<ModbusReadRequest> requests{ { static_cast<int>(DEFAULT_WRITE_IDX), 2, image.data() },
+                                                 { static_cast<int>(DEFAULT_READ_IDX), 3, image.data() + 2 } };
+  client.readHoldingRegisterBlocks(requests);
+  EXPECT_EQ(RegCont({ 1, 2, 3, 4, 5 }), image);
+
+  shutdownModbusServer(server.get(), client);
+  client.close();
+}
+
+/**
+ * @brief Tests that the registers are written before the blocks are read
+ */
+TEST_F(PipelinedModbusClientTest, testWriteReadRegisterBlocks)
+{
+  PipelinedModbusClient client;
+  std::shared_ptr<PilzModbusServerMock> server(new PilzModbusServerMock(DEFAULT_REGISTER_SIZE));
+  server->startAsync(LOCALHOST, testPort());
+
+  server->setHoldingRegister(RegCont{ 1, 2 }, DEFAULT_WRITE_IDX);
+
+  EXPECT_TRUE(client.init(LOCALHOST, testPort()));
+
+  const RegCont reg_to_write_by_client{ 8, 3, 7 };
+  RegCont image(5, 0);
+  const std::vector<ModbusReadRequest> requests{ { static_cast<int>(DEFAULT_WRITE_IDX), 2, image.data() },
+                                                 { static_cast<int>(DEFAULT_READ_IDX), 3, image.data() + 2 } };
+  client.writeReadHoldingRegisterBlocks(DEFAULT_READ_IDX, reg_to_write_by_client, requests);
+  EXPECT_EQ(RegCont({ 1, 2, 8, 3, 7 }), image);
+  EXPECT_EQ(reg_to_write_by_client, server->readHoldingRegister(DEFAULT_READ_IDX, reg_to_write_by_client.size()));
+
+  shutdownModbusServer(server.get(), client);
+  client.close();
+}
+
+/**
+ * @brief Tests that an exception response of the server is treated as disconnect
+ */
+TEST_F(PipelinedModbusClientTest, testExceptionResponse)
+{
+  PipelinedModbusClient client;
+  std::shared_ptr<PilzModbusServerMock> server(new PilzModbusServerMock(DEFAULT_REGISTER_SIZE));
+  server->startAsync(LOCALHOST, testPort());
+
+  EXPECT_TRUE(client.init(LOCALHOST, testPort()));
+  EXPECT_THROW(client.readHoldingRegister(DEFAULT_REGISTER_SIZE + 10, 2), ModbusExceptionDisconnect);
+  EXPECT_THROW(client.readHoldingRegister(DEFAULT_WRITE_IDX, 2), ModbusExceptionDisconnect)
+      << "Connection must be closed after an error";
+
+  server->terminate();
+}
+
+/**
+ * @brief Tests that requests exceeding the limits of the Modbus specification are rejected
+ */
+TEST_F(PipelinedModbusClientTest, testInvalidNumberOfRegisters)
+{
+  PipelinedModbusClient client;
+  std::shared_ptr<PilzModbusServerMock> server(new PilzModbusServerMock(DEFAULT_REGISTER_SIZE));
+  server->startAsync(LOCALHOST, testPort());
+
+  EXPECT_TRUE(client.init(LOCALHOST, testPort()));
+  EXPECT_THROW(client.readHoldingRegister(0, 126), std::invalid_argument);
+  EXPECT_THROW(client.writeReadHoldingRegister(DEFAULT_READ_IDX, RegCont{ 8, 3, 7 }, DEFAULT_WRITE_IDX, -2),
+               std::invalid_argument);
+  EXPECT_THROW(client.writeReadHoldingRegister(DEFAULT_READ_IDX, RegCont(122, 0), DEFAULT_WRITE_IDX, 2),
+               std::invalid_argument);
+
+  shutdownModbusServer(server.get(), client);
+  client.close();
+}
+
+/**
+ * @brief Tests that reading from a terminated server throws a exception
+ */
+TEST_F(PipelinedModbusClientTest, testReadRegistersTerminatedServer)
+{
+  PipelinedModbusClient client;
+  std::shared_ptr<PilzModbusServerMock> server(new PilzModbusServerMock(DEFAULT_REGISTER_SIZE));
+  server->startAsync(LOCALHOST, testPort());
+
+  EXPECT_TRUE(client.init(LOCALHOST, testPort()));
+  shutdownModbusServer(server.get(), client);
+
+  EXPECT_THROW(client.readHoldingRegister(DEFAULT_WRITE_IDX, 2), ModbusExceptionDisconnect);
+  client.close();
+}
+
+/**
+ * @brief Tests that setting reponse timeout on the client will return the same timeout on getResponseTimeoutInMs
+ */
+TEST_F(PipelinedModbusClientTest, setResponseTimeout)
+{
+  PipelinedModbusClient client;
+  unsigned long timeout_ms = 3;
+  client.setResponseTimeoutInMs(timeout_ms);
+  EXPECT_EQ(timeout_ms, client.getResponseTimeoutInMs());
+}
+
+}  // namespace pipelined_modbus_client_test
+
+int main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}